@@ -0,0 +1,150 @@
+/** @file
+ *
+ * @brief Throughput benchmark comparing a single node placed @c wait_queue with a
+ * @c numa_wait_queue, with writer and reader threads pinned to NUMA nodes.
+ *
+ * Three pinning layouts are run for each queue:
+ *
+ * - @c local, every writer and reader thread on node 0, the same node as the single
+ * @c wait_queue (the best case for a single queue).
+ *
+ * - @c cross, writer threads on node 0 and reader threads on the last node, so every
+ * pop from a single queue (and every steal from a @c numa_wait_queue) crosses sockets.
+ *
+ * - @c spread, writer and reader threads alternating between nodes, the typical layout
+ * of a service using every socket. This is where the per-node sub-queues help.
+ *
+ * On a single node host every layout is the same, and the numbers are only useful as a
+ * check of the @c numa_wait_queue overhead.
+ *
+ * Usage:
+ *
+ * @code
+ *   bench/numa_throughput [total_elements_per_run] [threads_per_side]
+ * @endcode
+ *
+ * The defaults are 2000000 elements per run and 4 writer and 4 reader threads.
+ *
+ * @author Cliff Green
+ *
+ * @copyright (c) 2024 by Cliff Green
+ *
+ * Distributed under the Boost Software License, Version 1.0.
+ * (See accompanying file LICENSE.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+ *
+ */
+
+#include <iostream>
+#include <iomanip> // std::setw
+#include <cstdlib> // EXIT_SUCCESS, std::atoi
+#include <cstddef> // std::size_t
+#include <vector>
+#include <string>
+#include <memory_resource>
+#include <optional>
+#include <algorithm> // std::max
+#include <functional> // std::function
+#include <chrono>
+
+#include <thread>
+#include <atomic>
+
+#include "queue/numa_wait_queue.hpp"
+
+using bench_clock = std::chrono::steady_clock;
+
+using layout_fn = std::function<std::size_t (int)>; // thread index to node
+
+struct layout {
+  std::string m_name;
+  layout_fn   m_writer_node;
+  layout_fn   m_reader_node;
+};
+
+// single wait_queue with control block and container storage on node 0
+struct single_queue {
+  std::pmr::unsynchronized_pool_resource m_pool;
+  chops::pmr::wait_queue<int>            m_wq;
+
+  single_queue(chops::numa::node_memory_resource* res) : m_pool(res), m_wq(&m_pool) { }
+
+  auto push(int val) -> bool { return m_wq.push(val); }
+  auto wait_and_pop() -> std::optional<int> { return m_wq.wait_and_pop(); }
+  auto request_stop() -> bool { return m_wq.request_stop(); }
+};
+
+template <typename Q>
+auto run_once(Q& wq, const layout& lay, int threads, std::size_t total) -> double {
+
+  // at least one element per writer, otherwise no reader would ever request the stop
+  const std::size_t per_writer = std::max(total / static_cast<std::size_t>(threads),
+                                          std::size_t{1u});
+  const std::size_t expected = per_writer * static_cast<std::size_t>(threads);
+  std::atomic<std::size_t> popped {0u};
+
+  auto start = bench_clock::now();
+  {
+    std::vector<std::jthread> thrs;
+    for (int i {0}; i < threads; ++i) {
+      thrs.emplace_back( [&wq, &popped, node = lay.m_reader_node(i), expected] {
+          (void) chops::numa::pin_this_thread(node);
+          while (auto val = wq.wait_and_pop()) {
+            if (popped.fetch_add(1u, std::memory_order_relaxed) + 1u == expected) {
+              wq.request_stop();
+            }
+          }
+        } );
+    }
+    for (int i {0}; i < threads; ++i) {
+      thrs.emplace_back( [&wq, node = lay.m_writer_node(i), per_writer] {
+          (void) chops::numa::pin_this_thread(node);
+          for (std::size_t j {0u}; j < per_writer; ++j) {
+            if (!wq.push(static_cast<int>(j))) {
+              return;
+            }
+          }
+        } );
+    }
+  } // all threads joined
+  const std::chrono::duration<double> elapsed = bench_clock::now() - start;
+  return static_cast<double>(expected) / elapsed.count();
+}
+
+auto print_row(const std::string& queue, const std::string& lay, double ops) -> void {
+  std::cout << std::left << std::setw(18) << queue << std::setw(10) << lay
+            << std::right << std::fixed << std::setprecision(0) << std::setw(14) << ops << '\n';
+}
+
+int main(int argc, char* argv[]) {
+
+  std::size_t total { 2000000u };
+  int threads { 4 };
+  if (argc > 1) {
+    total = static_cast<std::size_t>(std::atoi(argv[1]));
+  }
+  if (argc > 2) {
+    threads = std::atoi(argv[2]);
+  }
+
+  const std::size_t nodes = chops::numa::node_count();
+  const std::vector<layout> layouts {
+    { "local", [] (int) { return 0u; }, [] (int) { return 0u; } },
+    { "cross", [] (int) { return 0u; }, [nodes] (int) { return nodes - 1u; } },
+    { "spread", [nodes] (int i) { return static_cast<std::size_t>(i) % nodes; },
+                [nodes] (int i) { return static_cast<std::size_t>(i) % nodes; } }
+  };
+
+  std::cout << "nodes: " << nodes << ", threads per side: " << threads << '\n';
+  std::cout << std::left << std::setw(18) << "queue" << std::setw(10) << "layout"
+            << std::right << std::setw(14) << "ops/sec" << '\n';
+  for (const auto& lay : layouts) {
+    chops::numa::node_memory_resource res { 0u };
+    auto single = chops::numa::make_on_node<single_queue>(0u, &res);
+    print_row("wait_queue node 0", lay.m_name, run_once(*single, lay, threads, total));
+    chops::numa_wait_queue<int> nwq;
+    print_row("numa_wait_queue", lay.m_name, run_once(nwq, lay, threads, total));
+  }
+
+  return EXIT_SUCCESS;
+}
+
@@ -0,0 +1,75 @@
+/** @file
+ *
+ * @brief Microbenchmarks for @c wait_queue class template, using Catch2 @c BENCHMARK.
+ *
+ * Run with the benchmark tag, for example:
+ *
+ * @code
+ *   bench/wait_queue_bench "[uncontended]"
+ * @endcode
+ *
+ * @author Cliff Green
+ *
+ * @copyright (c) 2024 by Cliff Green
+ *
+ * Distributed under the Boost Software License, Version 1.0.
+ * (See accompanying file LICENSE.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+ *
+ */
+
+#include <vector>
+#include <iterator> // std::back_inserter
+#include <optional>
+
+#include <thread>
+#include <atomic>
+
+#include "catch2/catch_test_macros.hpp"
+#include "catch2/benchmark/catch_benchmark.hpp"
+
+#include "queue/wait_queue.hpp"
+
+TEST_CASE ( "Uncontended wait_queue push and pop",
+            "[wait_queue] [benchmark] [uncontended]" ) {
+
+  chops::wait_queue<int> wq;
+
+  // with no reader blocked in wait_and_pop, push does not notify the condition variable
+  BENCHMARK ( "push then try_pop, no waiting reader" ) {
+    wq.push(42);
+    return wq.try_pop();
+  };
+
+  BENCHMARK ( "emplace_push then wait_and_pop, no waiting reader" ) {
+    wq.emplace_push(42);
+    return wq.wait_and_pop();
+  };
+
+  std::vector<int> src (64, 42);
+  std::vector<int> dest;
+  dest.reserve(64);
+  BENCHMARK ( "push_range then try_pop_many, 64 elements" ) {
+    dest.clear();
+    wq.push_range(src);
+    return wq.try_pop_many(std::back_inserter(dest), src.size());
+  };
+}
+
+TEST_CASE ( "Push to wait_queue with a blocked reader thread",
+            "[wait_queue] [benchmark] [blocked_reader]" ) {
+
+  chops::wait_queue<int> wq;
+  std::atomic<long> cnt {0};
+  std::jthread rdr ( [&wq, &cnt] {
+      while (wq.wait_and_pop()) {
+        cnt.fetch_add(1, std::memory_order_relaxed);
+      }
+    } );
+
+  // the reader is frequently blocked, so most pushes notify the condition variable
+  BENCHMARK ( "push, reader thread consuming" ) {
+    return wq.push(42);
+  };
+  wq.request_stop();
+}
+
@@ -0,0 +1,229 @@
+/** @file
+ *
+ * @brief Throughput and latency benchmark for @c wait_queue, sweeping container types,
+ * writer and reader thread counts, and element types.
+ *
+ * Each run starts a number of writer threads and reader threads sharing one
+ * @c wait_queue. Each element is stamped with a @c std::chrono::steady_clock time at
+ * push, and the reader computes the push to pop latency. The total throughput (elements
+ * per second) along with the p50, p99, and p999 latency is reported for each run.
+ *
+ * Usage:
+ *
+ * @code
+ *   bench/wait_queue_throughput [total_elements_per_run] [max_threads]
+ * @endcode
+ *
+ * The defaults are 200000 elements per run and a maximum of 64 writer or reader threads.
+ *
+ * @author Cliff Green
+ *
+ * @copyright (c) 2024 by Cliff Green
+ *
+ * Distributed under the Boost Software License, Version 1.0.
+ * (See accompanying file LICENSE.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+ *
+ */
+
+#include <iostream>
+#include <iomanip> // std::setw
+#include <cstdlib> // EXIT_SUCCESS, std::atoi
+#include <cstddef> // std::size_t, std::byte
+#include <vector>
+#include <string>
+#include <memory> // std::shared_ptr, std::make_shared, std::unique_ptr
+#include <algorithm> // std::sort, std::max
+#include <utility> // std::pair
+#include <chrono>
+
+#include <thread>
+#include <atomic>
+#include <mutex>
+
+#include "queue/wait_queue.hpp"
+
+#include "nonstd/ring_span.hpp"
+#include "circular_buffer.hpp"
+
+using namespace std::literals::string_literals;
+
+using bench_clock = std::chrono::steady_clock;
+
+// element types passed through the queue
+
+using int_payload = int;
+using string_payload = std::string;
+// reference counted immutable buffer, same size and copy cost as a const_shared_buffer
+using blob_payload = std::shared_ptr<const std::vector<std::byte> >;
+
+template <typename P>
+struct stamped {
+  P                       m_payload { };
+  bench_clock::time_point m_stamp { };
+};
+
+template <typename P>
+auto make_payload() -> P {
+  if constexpr (std::is_same_v<P, string_payload>) {
+    return "A medium length string, longer than the small string buffer"s;
+  }
+  else if constexpr (std::is_same_v<P, blob_payload>) {
+    return std::make_shared<const std::vector<std::byte> >(512u, std::byte{0x42});
+  }
+  else {
+    return P { 42 };
+  }
+}
+
+constexpr std::size_t ring_cap = 1024u;
+
+struct run_result {
+  double m_ops_per_sec;
+  double m_p50_us;
+  double m_p99_us;
+  double m_p999_us;
+};
+
+auto percentile(const std::vector<long long>& sorted, double pct) -> double {
+  if (sorted.empty()) {
+    return 0.0;
+  }
+  auto idx = static_cast<std::size_t>(pct * static_cast<double>(sorted.size() - 1u));
+  return static_cast<double>(sorted[idx]) / 1000.0; // ns to us
+}
+
+template <typename Q>
+auto push_one(Q& wq, typename Q::value_type&& val) -> bool {
+  if constexpr (chops::supports_full<typename Q::container_type>) {
+    return wq.wait_and_push(std::move(val)); // fixed size containers must not overwrite
+  }
+  else {
+    return wq.push(std::move(val));
+  }
+}
+
+template <typename P, typename Q>
+auto run_once(Q& wq, int num_writers, int num_readers, std::size_t total) -> run_result {
+
+  // at least one element per writer, otherwise no reader would ever request the stop
+  const std::size_t per_writer = std::max(total / static_cast<std::size_t>(num_writers),
+                                          std::size_t{1u});
+  const std::size_t expected = per_writer * static_cast<std::size_t>(num_writers);
+  const P payload = make_payload<P>();
+
+  std::atomic<std::size_t> popped {0u};
+  std::vector<std::vector<long long> > lats (static_cast<std::size_t>(num_readers));
+
+  auto start = bench_clock::now();
+  {
+    std::vector<std::jthread> rd_thrs;
+    for (int i {0}; i < num_readers; ++i) {
+      rd_thrs.emplace_back( [&wq, &popped, &lat = lats[static_cast<std::size_t>(i)], expected] {
+          lat.reserve(expected);
+          while (auto val = wq.wait_and_pop()) {
+            lat.push_back(std::chrono::duration_cast<std::chrono::nanoseconds>(
+                            bench_clock::now() - (*val).m_stamp).count());
+            if (popped.fetch_add(1u, std::memory_order_relaxed) + 1u == expected) {
+              wq.request_stop();
+            }
+          }
+        } );
+    }
+    std::vector<std::jthread> wr_thrs;
+    for (int i {0}; i < num_writers; ++i) {
+      wr_thrs.emplace_back( [&wq, &payload, per_writer] {
+          for (std::size_t j {0u}; j < per_writer; ++j) {
+            if (!push_one(wq, stamped<P>{payload, bench_clock::now()})) {
+              return;
+            }
+          }
+        } );
+    }
+  } // all threads joined
+  const std::chrono::duration<double> elapsed = bench_clock::now() - start;
+
+  std::vector<long long> all;
+  all.reserve(expected);
+  for (const auto& v : lats) {
+    all.insert(all.end(), v.cbegin(), v.cend());
+  }
+  std::sort(all.begin(), all.end());
+  return run_result { static_cast<double>(all.size()) / elapsed.count(),
+                      percentile(all, 0.50), percentile(all, 0.99), percentile(all, 0.999) };
+}
+
+// each container type constructs the queue differently
+
+template <typename P>
+auto run_deque(int w, int r, std::size_t total) -> run_result {
+  chops::wait_queue<stamped<P> > wq;
+  return run_once<P>(wq, w, r, total);
+}
+
+template <typename P>
+auto run_ring_span(int w, int r, std::size_t total) -> run_result {
+  std::vector<stamped<P> > buf (ring_cap);
+  chops::wait_queue<stamped<P>, nonstd::ring_span<stamped<P> > > wq
+    { nonstd::ring_span<stamped<P> > { buf.data(), buf.data() + buf.size() } };
+  return run_once<P>(wq, w, r, total);
+}
+
+template <typename P>
+auto run_circular_buffer(int w, int r, std::size_t total) -> run_result {
+  using q_type = chops::wait_queue<stamped<P>, jm::circular_buffer<stamped<P>, ring_cap> >;
+  auto wq_ptr = std::make_unique<q_type>(); // large object, allocate on heap
+  return run_once<P>(*wq_ptr, w, r, total);
+}
+
+auto print_header() -> void {
+  std::cout << std::left << std::setw(18) << "container" << std::setw(10) << "element"
+            << std::right << std::setw(8) << "writers" << std::setw(8) << "readers"
+            << std::setw(14) << "ops/sec" << std::setw(11) << "p50 us"
+            << std::setw(11) << "p99 us" << std::setw(11) << "p999 us" << '\n';
+}
+
+auto print_row(const std::string& ctr, const std::string& elem, int w, int r,
+               const run_result& res) -> void {
+  std::cout << std::left << std::setw(18) << ctr << std::setw(10) << elem
+            << std::right << std::setw(8) << w << std::setw(8) << r
+            << std::fixed << std::setprecision(0) << std::setw(14) << res.m_ops_per_sec
+            << std::setprecision(2) << std::setw(11) << res.m_p50_us
+            << std::setw(11) << res.m_p99_us << std::setw(11) << res.m_p999_us << '\n';
+}
+
+template <typename P>
+auto sweep(const std::string& elem, const std::vector<std::pair<int, int> >& thr_counts,
+           std::size_t total) -> void {
+  for (auto [w, r] : thr_counts) {
+    print_row("deque", elem, w, r, run_deque<P>(w, r, total));
+    print_row("ring_span", elem, w, r, run_ring_span<P>(w, r, total));
+    print_row("circular_buffer", elem, w, r, run_circular_buffer<P>(w, r, total));
+  }
+}
+
+int main(int argc, char* argv[]) {
+
+  std::size_t total { 200000u };
+  int max_threads { 64 };
+  if (argc > 1) {
+    total = static_cast<std::size_t>(std::atoi(argv[1]));
+  }
+  if (argc > 2) {
+    max_threads = std::atoi(argv[2]);
+  }
+
+  std::vector<std::pair<int, int> > thr_counts;
+  for (int w {1}; w <= max_threads; w *= 4) {
+    for (int r {1}; r <= max_threads; r *= 4) {
+      thr_counts.emplace_back(w, r);
+    }
+  }
+
+  print_header();
+  sweep<int_payload>("int", thr_counts, total);
+  sweep<string_payload>("string", thr_counts, total);
+  sweep<blob_payload>("blob", thr_counts, total);
+
+  return EXIT_SUCCESS;
+}
+
@@ -0,0 +1,429 @@
+/** @file
+ *
+ * @brief Broadcast (multicast) queue, where every subscriber sees every element.
+ *
+ * A @c wait_queue delivers each element to exactly one reader. A @c broadcast_queue
+ * delivers each element to every subscriber, for example market data fanned out to
+ * multiple consumers. Writers publish an element once (one lock, one copy or move into
+ * a fixed size ring), and each @c subscriber keeps its own read cursor into the ring,
+ * copying elements out as it reads them. Compared to pushing the same element into N
+ * separate queues, there is one lock acquisition per push instead of N.
+ *
+ * The ring capacity is fixed (a power of two template parameter). What happens when a
+ * writer publishes into a full ring (where the slowest subscriber has not yet read the
+ * oldest element) is selected by the @c overflow_policy template parameter:
+ *
+ * - @c overflow_policy::block, the default: pushes are back-pressured by the slowest
+ *   subscriber. @c push (and @c emplace_push) block until the slowest subscriber reads
+ *   an element, while @c try_push returns @c false.
+ *
+ * - @c overflow_policy::lap: pushes never block, and the oldest element is overwritten.
+ *   A subscriber that falls more than the capacity behind is lapped: it skips to the
+ *   oldest available element, and the number of elements it missed is available through
+ *   the @c subscriber::lapped method.
+ *
+ * A new subscriber sees only elements published after it subscribes. Subscribers
+ * block in @c wait_and_pop with the same shutdown semantics as @c wait_queue (a
+ * @c std::stop_token, either internal or externally provided).
+ *
+ * Example usage:
+ *
+ * @code
+ *   chops::broadcast_queue<md_msg, 1024> bq;
+ *
+ *   // inside each subscriber thread
+ *   chops::broadcast_queue<md_msg, 1024>::subscriber sub { bq };
+ *   while (auto msg = sub.wait_and_pop()) {
+ *     ...
+ *   }
+ *
+ *   // inside writer thread
+ *   bq.push(msg);
+ *   ...
+ *   bq.request_stop();
+ * @endcode
+ *
+ * @note With @c overflow_policy::block and no subscribers, pushes never block (there
+ * is no one to wait for). An element stays in its ring slot (e.g. holding a reference
+ * count) until it is overwritten by a later push.
+ *
+ * @author Cliff Green
+ *
+ * @copyright (c) 2024 by Cliff Green
+ *
+ * Distributed under the Boost Software License, Version 1.0.
+ * (See accompanying file LICENSE.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+ *
+ */
+
+#ifndef BROADCAST_QUEUE_HPP_INCLUDED
+#define BROADCAST_QUEUE_HPP_INCLUDED
+
+#include <cassert> // assert
+#include <cstddef> // std::size_t
+#include <cstdint> // std::uint64_t
+#include <array>
+#include <vector>
+#include <algorithm> // std::find, std::min
+#include <optional>
+#include <mutex>
+#include <condition_variable>
+#include <stop_token> // std::stop_source, std::stop_token
+#include <utility> // std::move, std::forward
+#include <type_traits> // for requires clauses
+
+#include "queue/sync_utility.hpp" // cache_line_size
+
+namespace chops {
+
+/**
+ * @brief Behavior of a @c broadcast_queue push when the slowest subscriber is a full
+ * ring behind.
+ */
+enum class overflow_policy { block, lap };
+
+/**
+ * @brief Broadcast queue, with a per-subscriber read cursor into a fixed size ring.
+ *
+ * @tparam T Type of value that will be passed through the queue, which must be copy
+ * constructible (each subscriber receives a copy).
+ *
+ * @tparam N Capacity of the ring, which must be a power of two.
+ *
+ * @tparam Policy @c overflow_policy::block or @c overflow_policy::lap.
+ *
+ */
+template <typename T, std::size_t N, overflow_policy Policy = overflow_policy::block>
+  requires std::is_copy_constructible_v<T> && (N > 0u) && ((N & (N - 1u)) == 0u)
+class broadcast_queue {
+public:
+
+  using size_type = std::size_t;
+  using value_type = T;
+
+  class subscriber;
+
+private:
+
+  std::optional<std::stop_source> m_stop_src;
+  std::stop_token                 m_stop_tok;
+  alignas(cache_line_size) mutable std::mutex m_mut;
+  std::uint64_t                   m_tail {0u}; // sequence number of the next element
+  std::vector<subscriber*>        m_subs;
+  std::size_t                     m_data_waiters {0u};
+  std::size_t                     m_space_waiters {0u};
+  std::condition_variable_any     m_data_cond;
+  std::condition_variable_any     m_space_cond;
+  std::array<std::optional<T>, N> m_ring;
+
+  using lock_guard = std::scoped_lock<std::mutex>;
+  using unique_lock = std::unique_lock<std::mutex>;
+
+public:
+
+  /**
+   * @brief Subscription to a @c broadcast_queue, with its own read cursor.
+   *
+   * A @c subscriber is registered with the queue on construction and removed on
+   * destruction, and must be destroyed before the queue. Each subscriber is used by
+   * one reader thread at a time.
+   */
+  class subscriber {
+  public:
+
+    /**
+     * @brief Subscribe to a queue, starting with the next element published.
+     */
+    explicit subscriber(broadcast_queue& bq) : m_bq(&bq) {
+      lock_guard lk{m_bq->m_mut};
+      m_cursor = m_bq->m_tail;
+      m_bq->m_subs.push_back(this);
+    }
+
+    /**
+     * @brief Unsubscribe, writers blocked on this subscriber are woken up.
+     */
+    ~subscriber() {
+      lock_guard lk{m_bq->m_mut};
+      auto& subs = m_bq->m_subs;
+      subs.erase(std::find(subs.begin(), subs.end(), this));
+      m_bq->notify_space();
+    }
+
+    subscriber(const subscriber&) = delete;
+    subscriber(subscriber&&) = delete;
+    subscriber& operator=(const subscriber&) = delete;
+    subscriber& operator=(subscriber&&) = delete;
+
+    /**
+     * @brief Copy the next element, blocking until one is published.
+     *
+     * @return The next element, or an empty @c std::optional if the queue has been
+     * requested to stop and this subscriber has read all published elements.
+     */
+    [[nodiscard]] auto wait_and_pop() /* noexcept(std::is_nothrow_copy_constructible_v<T>) */
+          -> std::optional<T>
+    {
+      unique_lock lk{m_bq->m_mut};
+      if (m_cursor == m_bq->m_tail) {
+        ++m_bq->m_data_waiters;
+        const bool ok = m_bq->m_data_cond.wait(lk, m_bq->m_stop_tok,
+                                     [this] { return m_cursor != m_bq->m_tail; });
+        --m_bq->m_data_waiters;
+        if (!ok) {
+          return std::optional<T> {};
+        }
+      }
+      return read_next();
+    }
+
+    /**
+     * @brief Copy the next element if one is available, without blocking.
+     *
+     * @return The next element, or an empty @c std::optional if none is available or
+     * the queue has been requested to stop.
+     */
+    [[nodiscard]] auto try_pop() /* noexcept(std::is_nothrow_copy_constructible_v<T>) */
+          -> std::optional<T>
+    {
+      if (m_bq->m_stop_tok.stop_requested()) {
+        return std::optional<T> {};
+      }
+      lock_guard lk{m_bq->m_mut};
+      if (m_cursor == m_bq->m_tail) {
+        return std::optional<T> {};
+      }
+      return read_next();
+    }
+
+    /**
+     * @brief Number of elements published but not yet read by this subscriber
+     * (including any that will be skipped because the subscriber has been lapped).
+     */
+    [[nodiscard]] auto available() const /* noexcept */
+          -> size_type
+    {
+      lock_guard lk{m_bq->m_mut};
+      return static_cast<size_type>(m_bq->m_tail - m_cursor);
+    }
+
+    /**
+     * @brief Total number of elements this subscriber missed by being lapped, always 0
+     * for @c overflow_policy::block.
+     */
+    [[nodiscard]] auto lapped() const /* noexcept */
+          -> std::uint64_t
+    {
+      lock_guard lk{m_bq->m_mut};
+      return m_lapped;
+    }
+
+  private:
+
+    friend class broadcast_queue;
+
+    // lock must be held by caller, and an element must be available
+    auto read_next()
+          -> std::optional<T>
+    {
+      assert(m_cursor != m_bq->m_tail);
+      if constexpr (Policy == overflow_policy::lap) {
+        const auto oldest = m_bq->oldest();
+        if (m_cursor < oldest) {
+          m_lapped += oldest - m_cursor;
+          m_cursor = oldest;
+        }
+      }
+      std::optional<T> val { *(m_bq->m_ring[slot(m_cursor)]) };
+      ++m_cursor;
+      m_bq->notify_space();
+      return val;
+    }
+
+    broadcast_queue* m_bq;
+    std::uint64_t    m_cursor {0u};
+    std::uint64_t    m_lapped {0u};
+  };
+
+  /**
+   * @brief Default construct a @c broadcast_queue, with an internal @c std::stop_source.
+   */
+  broadcast_queue() : m_stop_src(std::stop_source{}), m_stop_tok((*m_stop_src).get_token()) { }
+
+  /**
+   * @brief Construct a @c broadcast_queue with an externally provided @c std::stop_token.
+   */
+  explicit broadcast_queue(std::stop_token stop_tok) : m_stop_tok(stop_tok) { }
+
+  // disallow copy or move construction or assignment of the entire object
+  broadcast_queue(const broadcast_queue&) = delete;
+  broadcast_queue(broadcast_queue&&) = delete;
+  broadcast_queue& operator=(const broadcast_queue&) = delete;
+  broadcast_queue& operator=(broadcast_queue&&) = delete;
+
+  /**
+   * @brief Request the @c broadcast_queue to stop processing, unless a @c std::stop_token
+   * was passed in to a constructor.
+   *
+   * @return @c true if an internal @c stop_source was used (versus a @c std::stop_token
+   * passed in to the constructor) and the request returns @c true, @c false if an
+   * external @c std::stop_token was passed in.
+   */
+  auto request_stop() noexcept
+        -> bool
+  {
+    if (m_stop_src) {
+      return (*m_stop_src).request_stop();
+    }
+    return false;
+  }
+
+  /**
+   * @brief Publish a value to all subscribers.
+   *
+   * With @c overflow_policy::block, this blocks while the slowest subscriber is a full
+   * ring behind.
+   *
+   * @return @c true if successful, @c false if the queue has been requested to stop.
+   */
+  auto push(const T& val)
+        -> bool
+  {
+    return emplace_push(val);
+  }
+
+  auto push(T&& val)
+        -> bool
+  {
+    return emplace_push(std::move(val));
+  }
+
+  /**
+   * @brief Directly construct a value in the ring and publish it to all subscribers.
+   *
+   * @return @c true if successful, @c false if the queue has been requested to stop.
+   */
+  template <typename ... Args>
+  auto emplace_push(Args&&... args)
+        -> bool
+      requires std::is_constructible_v<T, Args...>
+  {
+    if (m_stop_tok.stop_requested()) {
+      return false;
+    }
+    unique_lock lk{m_mut};
+    if constexpr (Policy == overflow_policy::block) {
+      if (full()) {
+        ++m_space_waiters;
+        const bool ok = m_space_cond.wait(lk, m_stop_tok, [this] { return !full(); });
+        --m_space_waiters;
+        if (!ok) {
+          return false;
+        }
+      }
+    }
+    publish(lk, std::forward<Args>(args)...);
+    return true;
+  }
+
+  /**
+   * @brief Publish a value to all subscribers if there is space, without blocking.
+   *
+   * @return @c true if successful, @c false if the slowest subscriber is a full ring
+   * behind (with @c overflow_policy::block) or the queue has been requested to stop.
+   */
+  auto try_push(const T& val)
+        -> bool
+  {
+    if (m_stop_tok.stop_requested()) {
+      return false;
+    }
+    unique_lock lk{m_mut};
+    if (full()) {
+      return false;
+    }
+    publish(lk, val);
+    return true;
+  }
+
+  [[nodiscard]] auto stop_requested() const noexcept
+        -> bool
+  {
+    return m_stop_tok.stop_requested();
+  }
+
+  /**
+   * @brief Get the number of registered subscribers.
+   */
+  [[nodiscard]] auto subscriber_count() const /* noexcept */
+        -> size_type
+  {
+    lock_guard lk{m_mut};
+    return m_subs.size();
+  }
+
+  [[nodiscard]] static constexpr auto capacity() noexcept
+        -> size_type
+  {
+    return N;
+  }
+
+private:
+
+  static constexpr auto slot(std::uint64_t seq) noexcept
+        -> std::size_t
+  {
+    return static_cast<std::size_t>(seq & (N - 1u));
+  }
+
+  // lock must be held by caller for the following methods
+  auto oldest() const noexcept
+        -> std::uint64_t
+  {
+    return (m_tail > N) ? m_tail - N : 0u;
+  }
+
+  // only the block policy is ever full
+  auto full() const noexcept
+        -> bool
+  {
+    if constexpr (Policy == overflow_policy::block) {
+      for (const auto* sub : m_subs) {
+        if (m_tail - sub->m_cursor >= N) {
+          return true;
+        }
+      }
+    }
+    return false;
+  }
+
+  auto notify_space() noexcept
+        -> void
+  {
+    if constexpr (Policy == overflow_policy::block) {
+      if (m_space_waiters != 0u) {
+        m_space_cond.notify_all();
+      }
+    }
+  }
+
+  // lock is held on entry and released on return
+  template <typename ... Args>
+  auto publish(unique_lock& lk, Args&&... args)
+        -> void
+  {
+    m_ring[slot(m_tail)].emplace(std::forward<Args>(args)...);
+    ++m_tail;
+    const auto waiters = m_data_waiters;
+    lk.unlock();
+    if (waiters != 0u) {
+      m_data_cond.notify_all(); // every subscriber reads every element
+    }
+  }
+
+};
+
+} // end namespace
+
+#endif
+
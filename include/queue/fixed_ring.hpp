@@ -0,0 +1,621 @@
+/** @file
+ *
+ * @brief Owning fixed capacity ring buffer container, designed for use as the
+ * @c wait_queue container type.
+ *
+ * A @c fixed_ring owns its storage, either inline in the object (capacity specified as
+ * a template parameter) or allocated once at construction (capacity specified at run
+ * time, @c N is @c std::dynamic_extent). There is no memory allocation when pushing or
+ * popping elements, and no third-party dependencies.
+ *
+ * The storage is uninitialized until an element is pushed, so the element type does
+ * not need a default constructor (unlike a @c ring_span over an array). The capacity
+ * is always a power of two, so that indices are computed with a mask instead of a
+ * modulo operation. The read and write positions are free running counters, with the
+ * size computed as the difference.
+ *
+ * A @c fixed_ring supports @c full and @c capacity, which enables the @c wait_queue
+ * bounded mode methods (@c try_push and @c wait_and_push). As with a @c ring_span,
+ * @c push_back or @c emplace_back on a full @c fixed_ring overwrites (destroys) the
+ * oldest element.
+ *
+ * The contiguous elements at the front of the ring are available through @c front_span,
+ * which allows the @c wait_queue @c try_consume_span and @c wait_and_consume_span methods
+ * to process a batch of elements in place.
+ *
+ * Slots can also be reserved and later committed (the @c wait_queue @c reserve and
+ * @c commit methods), so that a producer can construct elements directly in the ring
+ * storage without holding the @c wait_queue lock. Reserved slots are not visible (to
+ * @c size, @c front, iteration, etc) until committed. Reservations can be committed in
+ * any order, with elements becoming visible in reservation order once all earlier
+ * reservations are committed. Three free running counters are kept (read, commit, and
+ * reservation positions), plus a committed flag bit per slot for out of order commits.
+ *
+ * The reservation support can be left out (the @c Reservable template parameter, or the
+ * @c lean_fixed_ring alias), removing the flag bits and the reservation counter. A lean
+ * compile time capacity ring (of at most 2^31 elements) also uses 32 bit counters, so
+ * that the object is the element storage plus 8 bytes.
+ *
+ * Example usage:
+ *
+ * @code
+ *   chops::wait_queue<int, chops::fixed_ring<int, 1024> > wq; // no heap memory
+ *   chops::wait_queue<int, chops::fixed_ring<int> > rt_wq { 1000 }; // capacity 1024
+ * @endcode
+ *
+ * @author Cliff Green
+ *
+ * @copyright (c) 2024 by Cliff Green
+ *
+ * Distributed under the Boost Software License, Version 1.0.
+ * (See accompanying file LICENSE.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+ *
+ */
+
+#ifndef FIXED_RING_HPP_INCLUDED
+#define FIXED_RING_HPP_INCLUDED
+
+#include <cassert> // assert
+#include <cstddef> // std::size_t, std::byte, std::ptrdiff_t
+#include <cstdint> // std::uint64_t
+#include <span> // std::span, std::dynamic_extent
+#include <bit> // std::bit_ceil
+#include <memory> // std::allocator, std::construct_at, std::destroy_at
+#include <iterator> // std::forward_iterator_tag
+#include <utility> // std::move, std::forward
+#include <algorithm> // std::fill_n
+#include <type_traits> // std::conditional_t, for requires clauses
+
+namespace chops {
+
+/**
+ * @brief Owning fixed capacity ring buffer, with uninitialized storage and power of two
+ * index masking.
+ *
+ * @tparam T Type of element.
+ *
+ * @tparam N Capacity, which must be a power of two, or @c std::dynamic_extent for a
+ * capacity specified at construction.
+ *
+ * @tparam Reservable If @c true (the default) the @c reserve, @c reserved_slot, @c commit,
+ * and @c pending methods are available, otherwise the ring has no reservation overhead.
+ *
+ */
+template <typename T, std::size_t N = std::dynamic_extent, bool Reservable = true>
+  requires (N == std::dynamic_extent) || ((N > 0u) && ((N & (N - 1u)) == 0u))
+class fixed_ring {
+public:
+
+  using value_type = T;
+  using size_type = std::size_t;
+  using difference_type = std::ptrdiff_t;
+  using reference = T&;
+  using const_reference = const T&;
+
+  /**
+   * @brief Reserved (uncommitted) slots, as returned from @c reserve.
+   */
+  struct reservation {
+    size_type pos;
+    size_type count;
+  };
+
+private:
+
+  static constexpr bool is_dynamic = (N == std::dynamic_extent);
+
+  static constexpr auto flag_words(size_type cap) noexcept -> size_type { return (cap + 63u) / 64u; }
+
+  // free running counters only need to hold the capacity, since sizes are differences
+  using counter_type = std::conditional_t<!Reservable && !is_dynamic &&
+                                          (N <= (std::size_t{1u} << 31u)), std::uint32_t, size_type>;
+
+  // distinct empty types, so that both unused members take no space
+  struct no_flags { };
+  struct no_reserve { };
+
+  struct static_flags {
+    std::uint64_t m_flags[flag_words(N)] { };
+  };
+
+  struct static_storage {
+    alignas(T) std::byte m_buf[sizeof(T) * N];
+    [[no_unique_address]] std::conditional_t<Reservable, static_flags, no_flags> m_bits;
+  };
+
+  struct dynamic_storage {
+    T*             m_ptr {nullptr};
+    size_type      m_cap {0u};
+    [[no_unique_address]] std::conditional_t<Reservable, std::uint64_t*, no_flags> m_flags { };
+  };
+
+  template <typename R, typename E>
+  class basic_iterator {
+  private:
+    R*           m_ring {nullptr};
+    counter_type m_pos {0u};
+
+  public:
+    using iterator_category = std::forward_iterator_tag;
+    using value_type = T;
+    using difference_type = std::ptrdiff_t;
+    using pointer = E*;
+    using reference = E&;
+
+    basic_iterator() = default;
+    basic_iterator(R* ring, counter_type pos) noexcept : m_ring(ring), m_pos(pos) { }
+
+    auto operator*() const noexcept -> E& { return *(m_ring->slot(m_pos)); }
+    auto operator->() const noexcept -> E* { return m_ring->slot(m_pos); }
+    auto operator++() noexcept -> basic_iterator& { ++m_pos; return *this; }
+    auto operator++(int) noexcept -> basic_iterator { auto tmp {*this}; ++m_pos; return tmp; }
+    auto operator==(const basic_iterator& rhs) const noexcept -> bool { return m_pos == rhs.m_pos; }
+  };
+
+  std::conditional_t<is_dynamic, dynamic_storage, static_storage> m_store;
+  counter_type m_head {0u}; // free running read position
+  counter_type m_tail {0u}; // free running commit position, elements before are visible
+  [[no_unique_address]] std::conditional_t<Reservable, counter_type, no_reserve>
+               m_reserve { }; // free running reservation (write) position
+
+public:
+
+  using iterator = basic_iterator<fixed_ring, T>;
+  using const_iterator = basic_iterator<const fixed_ring, const T>;
+
+  /**
+   * @brief Default construct a @c fixed_ring with the template parameter capacity.
+   *
+   * @post @c empty returns @c true.
+   */
+  fixed_ring() noexcept
+    requires (!is_dynamic)
+  {
+  }
+
+  /**
+   * @brief Construct a @c fixed_ring with a run time capacity, allocating the storage.
+   *
+   * @param cap Minimum capacity, which is rounded up to a power of two.
+   *
+   * @pre @c cap is greater than 0.
+   *
+   * @post @c empty returns @c true.
+   * @post @c capacity returns @c cap rounded up to a power of two.
+   */
+  explicit fixed_ring(size_type cap)
+    requires is_dynamic
+  {
+    assert(cap > 0u);
+    allocate(std::bit_ceil(cap));
+  }
+
+  // copy and move (construction and assignment) copy or move the visible elements, and
+  // must not be performed while there are outstanding reservations
+
+  fixed_ring(const fixed_ring& rhs)
+    requires std::is_copy_constructible_v<T>
+  {
+    if constexpr (is_dynamic) {
+      allocate(rhs.m_store.m_cap);
+    }
+    for (const auto& elem : rhs) {
+      emplace_back(elem);
+    }
+  }
+
+  fixed_ring(fixed_ring&& rhs) noexcept(is_dynamic || std::is_nothrow_move_constructible_v<T>) {
+    take(std::move(rhs));
+  }
+
+  auto operator=(const fixed_ring& rhs)
+        -> fixed_ring&
+    requires std::is_copy_constructible_v<T>
+  {
+    if (this != &rhs) {
+      clear();
+      if constexpr (is_dynamic) {
+        if (m_store.m_cap != rhs.m_store.m_cap) {
+          deallocate();
+          allocate(rhs.m_store.m_cap);
+        }
+      }
+      for (const auto& elem : rhs) {
+        emplace_back(elem);
+      }
+    }
+    return *this;
+  }
+
+  auto operator=(fixed_ring&& rhs) noexcept(is_dynamic || std::is_nothrow_move_constructible_v<T>)
+        -> fixed_ring&
+  {
+    if (this != &rhs) {
+      clear();
+      if constexpr (is_dynamic) {
+        deallocate();
+      }
+      take(std::move(rhs));
+    }
+    return *this;
+  }
+
+  ~fixed_ring() {
+    clear();
+    if constexpr (is_dynamic) {
+      deallocate();
+    }
+  }
+
+  // modifying methods
+
+  /**
+   * @brief Construct an element at the back of the ring, overwriting the oldest
+   * element if the ring is full.
+   *
+   * If there are outstanding reservations, the element is placed after the reserved
+   * slots. Only visible elements are overwritten, never reserved slots (or slots pushed
+   * after an outstanding reservation).
+   *
+   * @param args Arguments used to construct the element.
+   *
+   * @return Reference to the constructed element.
+   *
+   * @pre @c full returns @c false or @c empty returns @c false (the @c wait_queue push
+   * methods reject the push otherwise).
+   */
+  template <typename ... Args>
+  auto emplace_back(Args&&... args)
+        -> reference
+    requires std::is_constructible_v<T, Args...>
+  {
+    assert(capacity() > 0u);
+    assert(!full() || !empty());
+    if (full()) {
+      pop_front();
+    }
+    if constexpr (Reservable) {
+      T* p = std::construct_at(slot(m_reserve), std::forward<Args>(args)...);
+      if (m_tail == m_reserve) {
+        ++m_tail;
+      }
+      else { // visible once the outstanding reservations are committed
+        set_flag(m_reserve);
+      }
+      ++m_reserve;
+      return *p;
+    }
+    else {
+      T* p = std::construct_at(slot(m_tail), std::forward<Args>(args)...);
+      ++m_tail;
+      return *p;
+    }
+  }
+
+  /**
+   * @brief Copy an element to the back of the ring, overwriting the oldest element if
+   * the ring is full.
+   */
+  auto push_back(const T& val)
+        -> void
+    requires std::is_copy_constructible_v<T>
+  {
+    emplace_back(val);
+  }
+
+  /**
+   * @brief Move an element to the back of the ring, overwriting the oldest element if
+   * the ring is full.
+   */
+  auto push_back(T&& val)
+        -> void
+    requires std::is_move_constructible_v<T>
+  {
+    emplace_back(std::move(val));
+  }
+
+  /**
+   * @brief Destroy the oldest element.
+   *
+   * @pre @c empty returns @c false.
+   */
+  auto pop_front() noexcept
+        -> void
+  {
+    assert(!empty());
+    std::destroy_at(slot(m_head));
+    ++m_head;
+  }
+
+  /**
+   * @brief Destroy the oldest @c n elements.
+   *
+   * @pre @c n is less than or equal to @c size.
+   */
+  auto pop_front(size_type n) noexcept
+        -> void
+  {
+    assert(n <= size());
+    for (size_type i {0u}; i < n; ++i) {
+      pop_front();
+    }
+  }
+
+  /**
+   * @brief Destroy all elements.
+   *
+   * @pre There are no outstanding reservations.
+   *
+   * @post @c empty returns @c true.
+   */
+  auto clear() noexcept
+        -> void
+  {
+    if constexpr (Reservable) {
+      assert(pending() == 0u);
+    }
+    while (!empty()) {
+      pop_front();
+    }
+    m_head = m_tail = 0u;
+    if constexpr (Reservable) {
+      m_reserve = 0u;
+    }
+  }
+
+  /**
+   * @brief Reserve slots at the back of the ring, to be constructed in place and then
+   * committed.
+   *
+   * @param n Number of slots.
+   *
+   * @return A @c reservation, used to access the slot storage and to commit.
+   *
+   * @pre @c n is greater than 0 and less than or equal to @c available.
+   */
+  auto reserve(size_type n) noexcept
+        -> reservation
+    requires Reservable
+  {
+    assert(n > 0u && n <= available());
+    reservation res { m_reserve, n };
+    m_reserve += static_cast<counter_type>(n);
+    return res;
+  }
+
+  /**
+   * @brief Access the (uninitialized) storage of a reserved slot.
+   *
+   * The slot storage does not move while the reservation is outstanding, so an element
+   * can be constructed (e.g. with @c std::construct_at) without synchronizing with other
+   * users of the ring.
+   *
+   * @param res Reservation returned from @c reserve.
+   *
+   * @param idx Index of the slot within the reservation.
+   *
+   * @pre @c idx is less than @c res.count.
+   */
+  [[nodiscard]] auto reserved_slot(const reservation& res, size_type idx) noexcept
+        -> T*
+    requires Reservable
+  {
+    assert(idx < res.count);
+    return slot(res.pos + idx);
+  }
+
+  /**
+   * @brief Commit reserved slots, making them (and any subsequent committed slots)
+   * visible if all earlier reservations have been committed.
+   *
+   * @param res Reservation returned from @c reserve.
+   *
+   * @return Number of elements made visible, which may be 0 (if an earlier reservation
+   * is outstanding) or greater than @c res.count.
+   *
+   * @pre An element has been constructed in each slot of the reservation.
+   */
+  auto commit(const reservation& res) noexcept
+        -> size_type
+    requires Reservable
+  {
+    for (size_type i {0u}; i < res.count; ++i) {
+      set_flag(res.pos + i);
+    }
+    const counter_type old_tail = m_tail;
+    while (m_tail != m_reserve && test_flag(m_tail)) {
+      reset_flag(m_tail);
+      ++m_tail;
+    }
+    return static_cast<size_type>(m_tail - old_tail);
+  }
+
+  // element access
+
+  /**
+   * @pre @c empty returns @c false.
+   */
+  [[nodiscard]] auto front() noexcept -> reference { assert(!empty()); return *slot(m_head); }
+  [[nodiscard]] auto front() const noexcept -> const_reference { assert(!empty()); return *slot(m_head); }
+  [[nodiscard]] auto back() noexcept -> reference { assert(!empty()); return *slot(m_tail - 1u); }
+  [[nodiscard]] auto back() const noexcept -> const_reference { assert(!empty()); return *slot(m_tail - 1u); }
+
+  /**
+   * @brief Access the contiguous elements at the front of the ring, which is all of the
+   * elements unless they wrap around the end of the storage.
+   *
+   * @return @c std::span of the front elements, empty if the ring is empty.
+   */
+  [[nodiscard]] auto front_span() noexcept
+        -> std::span<T>
+  {
+    const size_type idx = m_head & (capacity() - 1u);
+    const size_type cnt = size();
+    return std::span<T> { data() + idx, (cnt < capacity() - idx) ? cnt : capacity() - idx };
+  }
+
+  [[nodiscard]] auto begin() noexcept -> iterator { return iterator { this, m_head }; }
+  [[nodiscard]] auto end() noexcept -> iterator { return iterator { this, m_tail }; }
+  [[nodiscard]] auto begin() const noexcept -> const_iterator { return const_iterator { this, m_head }; }
+  [[nodiscard]] auto end() const noexcept -> const_iterator { return const_iterator { this, m_tail }; }
+
+  // non-modifying methods
+
+  [[nodiscard]] auto empty() const noexcept -> bool { return m_head == m_tail; }
+  [[nodiscard]] auto full() const noexcept -> bool { return available() == 0u; }
+  [[nodiscard]] auto size() const noexcept -> size_type { return static_cast<size_type>(m_tail - m_head); }
+
+  /**
+   * @brief Number of slots that can be pushed or reserved without overwriting.
+   */
+  [[nodiscard]] auto available() const noexcept
+        -> size_type
+  {
+    return capacity() - static_cast<size_type>(write_pos() - m_head);
+  }
+
+  /**
+   * @brief Number of slots that are reserved, or pushed after an outstanding reservation,
+   * and not yet visible.
+   */
+  [[nodiscard]] auto pending() const noexcept
+        -> size_type
+    requires Reservable
+  {
+    return static_cast<size_type>(m_reserve - m_tail);
+  }
+
+  [[nodiscard]] auto capacity() const noexcept
+        -> size_type
+  {
+    if constexpr (is_dynamic) {
+      return m_store.m_cap;
+    }
+    else {
+      return N;
+    }
+  }
+
+private:
+
+  auto data() noexcept
+        -> T*
+  {
+    if constexpr (is_dynamic) {
+      return m_store.m_ptr;
+    }
+    else {
+      return reinterpret_cast<T*>(m_store.m_buf);
+    }
+  }
+
+  auto data() const noexcept
+        -> const T*
+  {
+    if constexpr (is_dynamic) {
+      return m_store.m_ptr;
+    }
+    else {
+      return reinterpret_cast<const T*>(m_store.m_buf);
+    }
+  }
+
+  auto slot(size_type pos) noexcept -> T* { return data() + (pos & (capacity() - 1u)); }
+  auto slot(size_type pos) const noexcept -> const T* { return data() + (pos & (capacity() - 1u)); }
+
+  auto write_pos() const noexcept
+        -> counter_type
+  {
+    if constexpr (Reservable) {
+      return m_reserve;
+    }
+    else {
+      return m_tail;
+    }
+  }
+
+  auto flags() noexcept
+        -> std::uint64_t*
+    requires Reservable
+  {
+    if constexpr (is_dynamic) {
+      return m_store.m_flags;
+    }
+    else {
+      return m_store.m_bits.m_flags;
+    }
+  }
+
+  auto set_flag(size_type pos) noexcept -> void {
+    const size_type idx = pos & (capacity() - 1u);
+    flags()[idx / 64u] |= (std::uint64_t{1u} << (idx % 64u));
+  }
+  auto reset_flag(size_type pos) noexcept -> void {
+    const size_type idx = pos & (capacity() - 1u);
+    flags()[idx / 64u] &= ~(std::uint64_t{1u} << (idx % 64u));
+  }
+  auto test_flag(size_type pos) noexcept -> bool {
+    const size_type idx = pos & (capacity() - 1u);
+    return (flags()[idx / 64u] & (std::uint64_t{1u} << (idx % 64u))) != 0u;
+  }
+
+  auto allocate(size_type cap)
+        -> void
+    requires is_dynamic
+  {
+    m_store.m_ptr = std::allocator<T>{}.allocate(cap);
+    if constexpr (Reservable) {
+      m_store.m_flags = std::allocator<std::uint64_t>{}.allocate(flag_words(cap));
+      std::fill_n(m_store.m_flags, flag_words(cap), std::uint64_t{0u});
+    }
+    m_store.m_cap = cap;
+  }
+
+  auto deallocate() noexcept
+        -> void
+    requires is_dynamic
+  {
+    if (m_store.m_ptr) {
+      std::allocator<T>{}.deallocate(m_store.m_ptr, m_store.m_cap);
+      if constexpr (Reservable) {
+        std::allocator<std::uint64_t>{}.deallocate(m_store.m_flags, flag_words(m_store.m_cap));
+      }
+    }
+    m_store = dynamic_storage { };
+  }
+
+  // storage is empty (and for dynamic, deallocated) on entry; rhs is left empty
+  // (and for dynamic, with no storage)
+  auto take(fixed_ring&& rhs)
+        -> void
+  {
+    if constexpr (is_dynamic) {
+      m_store = rhs.m_store;
+      m_head = rhs.m_head;
+      m_tail = rhs.m_tail;
+      m_reserve = rhs.m_reserve;
+      rhs.m_store = dynamic_storage { };
+      rhs.m_head = rhs.m_tail = 0u;
+      rhs.m_reserve = decltype(m_reserve) { };
+    }
+    else {
+      clear();
+      for (auto& elem : rhs) {
+        emplace_back(std::move(elem));
+      }
+      rhs.clear();
+    }
+  }
+
+};
+
+/**
+ * @brief @c fixed_ring without the slot reservation support (and overhead).
+ */
+template <typename T, std::size_t N = std::dynamic_extent>
+using lean_fixed_ring = fixed_ring<T, N, false>;
+
+} // end namespace
+
+#endif
+
@@ -0,0 +1,446 @@
+/** @file
+ *
+ * @brief Lock-free bounded multi producer / multi consumer (MPMC) wait queue with
+ * shutdown semantics.
+ *
+ * @c lock_free_wait_queue has the same API as @c spsc_wait_queue (and the same shape
+ * as @c wait_queue), but allows any number of writer and reader threads. Generic code
+ * templatized on the queue type can select between @c wait_queue, @c spsc_wait_queue, and
+ * @c lock_free_wait_queue through a template parameter.
+ *
+ * The implementation is a bounded ring of cells, where each cell contains a sequence
+ * number along with (uninitialized) storage for one element. A writer claims a cell by
+ * a compare and swap on the enqueue position, constructs the element, then publishes it
+ * by storing the cell sequence number. A reader does the same with the dequeue position.
+ * Writers and readers only contend on the same cache line when they are accessing the
+ * same cell, so there is no single serialization point (such as the mutex in
+ * @c wait_queue). The algorithm is Dmitry Vyukov's bounded MPMC queue.
+ *
+ * Reader threads calling @c wait_and_pop only block (through an @c event_count, using
+ * the C++ 20 atomic wait facilities) when the queue is empty. Similarly writer threads
+ * calling @c wait_and_push only block when the queue is full.
+ *
+ * The capacity is a template parameter and must be a power of two. No heap memory is
+ * allocated.
+ *
+ * Unlike @c wait_queue, a @c push on a full queue does not add the element (and returns
+ * @c false). As with any lock-free queue, @c empty and @c size return a snapshot value
+ * which may already be out of date when returned.
+ *
+ * Example usage:
+ *
+ * @code
+ *   chops::lock_free_wait_queue<int, 1024> wq;
+ *
+ *   // inside any number of writer threads
+ *   wq.wait_and_push(42);
+ *   ...
+ *   wq.request_stop();
+ *
+ *   // inside any number of reader threads
+ *   auto rtn_val = wq.wait_and_pop(); // return type is std::optional<int>
+ *   if (!rtn_val) { // empty value, request_stop has been called
+ *     // time to exit reader thread
+ *   }
+ * @endcode
+ *
+ * @author Cliff Green
+ *
+ * @copyright (c) 2024 by Cliff Green
+ *
+ * Distributed under the Boost Software License, Version 1.0.
+ * (See accompanying file LICENSE.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+ *
+ */
+
+#ifndef LOCK_FREE_WAIT_QUEUE_HPP_INCLUDED
+#define LOCK_FREE_WAIT_QUEUE_HPP_INCLUDED
+
+#include <cassert> // assert
+#include <cstddef> // std::size_t, std::byte, std::ptrdiff_t
+#include <atomic>
+#include <stop_token> // std::stop_source, std::stop_token, std::stop_callback
+#include <optional>
+#include <memory> // std::construct_at, std::destroy_at
+#include <new> // std::launder
+#include <utility> // std::move, std::move_if_noexcept, std::forward
+#include <type_traits> // for requires clauses and noexcept specs
+
+#include "queue/sync_utility.hpp"
+
+namespace chops {
+
+/**
+ * @brief Lock-free bounded MPMC wait queue with shutdown semantics.
+ *
+ * @tparam T Type of value that will be passed through the queue.
+ *
+ * @tparam N Capacity of the queue, which must be a power of two.
+ *
+ * @pre The value type must be either copy constructible or move constructible. A default
+ * constructor is not required.
+ *
+ */
+template <typename T, std::size_t N>
+  requires (std::is_copy_constructible_v<T> || std::is_move_constructible_v<T>) &&
+           (N > 0u) && ((N & (N - 1u)) == 0u)
+class lock_free_wait_queue {
+public:
+
+  using size_type = std::size_t;
+  using value_type = T;
+
+private:
+
+  struct cell {
+    std::atomic<size_type> m_seq;
+    alignas(T) std::byte   m_storage[sizeof(T)];
+
+    auto ptr() noexcept -> T* {
+      return std::launder(reinterpret_cast<T*>(m_storage));
+    }
+  };
+
+  struct stop_notifier {
+    lock_free_wait_queue* m_wq;
+    auto operator()() noexcept -> void {
+      m_wq->m_data_ev.notify_all();
+      m_wq->m_space_ev.notify_all();
+    }
+  };
+
+  static constexpr size_type mask = N - 1u;
+
+  alignas(cache_line_size) std::atomic<size_type> m_enqueue_pos {0u};
+  alignas(cache_line_size) std::atomic<size_type> m_dequeue_pos {0u};
+  alignas(cache_line_size) event_count       m_data_ev;
+  event_count                                m_space_ev;
+  std::optional<std::stop_source>            m_stop_src;
+  std::stop_token                            m_stop_tok;
+  std::stop_callback<stop_notifier>          m_stop_cb;
+  alignas(cache_line_size) cell              m_cells[N];
+
+public:
+
+  /**
+   * @brief Default construct a @c lock_free_wait_queue.
+   *
+   * An internal @c stop_source is used to provide a @c std::stop_token for
+   * coordinating shutdown.
+   *
+   * @post @c empty returns @c true.
+   * @post @c stop_requested returns @c false.
+   */
+  lock_free_wait_queue()
+      : m_stop_src(std::stop_source{}), m_stop_tok((*m_stop_src).get_token()),
+        m_stop_cb(m_stop_tok, stop_notifier{this})
+  {
+    init_cells();
+    assert(empty());
+    assert(!stop_requested());
+  }
+
+  /**
+   * @brief Construct a @c lock_free_wait_queue with an externally provided
+   * @c std::stop_token.
+   *
+   * @param stop_tok A @c std::stop_token which can be used to shutdown queue processing.
+   *
+   * @post @c empty returns @c true.
+   */
+  lock_free_wait_queue(std::stop_token stop_tok)
+      : m_stop_tok(stop_tok), m_stop_cb(m_stop_tok, stop_notifier{this})
+  {
+    init_cells();
+    assert(empty());
+  }
+
+  // disallow copy or move construction of the entire object
+  lock_free_wait_queue(const lock_free_wait_queue&) = delete;
+  lock_free_wait_queue(lock_free_wait_queue&&) = delete;
+
+  // disallow copy or move assigment of the entire object
+  lock_free_wait_queue& operator=(const lock_free_wait_queue&) = delete;
+  lock_free_wait_queue& operator=(lock_free_wait_queue&&) = delete;
+
+  /**
+   * @brief Destroy any elements remaining in the queue.
+   *
+   * @pre No other threads are accessing the queue.
+   */
+  ~lock_free_wait_queue() {
+    while (dequeue()) {
+    }
+  }
+
+  // modifying methods
+
+  /**
+   * @brief Request the @c lock_free_wait_queue to stop processing, unless a
+   * @c std::stop_token was passed in to a constructor.
+   *
+   * For an internal @c std::stop_token, all waiting reader and writer threads will be
+   * notified. Subsequent @c push operations will return @c false.
+   *
+   * @return @c true if an internal @c stop_source was used and the request returns
+   * @c true, @c false if an external @c std::stop_token was passed in.
+   */
+  auto request_stop() noexcept
+        -> bool
+  {
+    if (m_stop_src) {
+      return (*m_stop_src).request_stop();
+    }
+    return false;
+  }
+
+  /**
+   * @brief Push a value, by copying, to the @c lock_free_wait_queue if there is space.
+   *
+   * @param val Val to copy into the queue.
+   *
+   * @return @c true if successful, @c false if the queue is full or has been
+   * requested to stop.
+   */
+  auto push(const T& val) /* noexcept(std::is_nothrow_copy_constructible_v<T>) */
+        -> bool
+    requires std::is_copy_constructible_v<T>
+  {
+    return emplace_push(val);
+  }
+
+  /**
+   * @brief Push a value, either by moving or copying, to the @c lock_free_wait_queue
+   * if there is space.
+   *
+   * This method has the same semantics as the other @c push, except that the value will
+   * be moved (if possible) instead of copied. If @c false is returned the value has not
+   * been moved from.
+   */
+  auto push(T&& val) /* noexcept(std::is_nothrow_move_constructible_v<T>) */
+        -> bool
+  {
+    return emplace_push(std::move(val));
+  }
+
+  /**
+   * @brief Directly construct an object in a queue cell by forwarding the supplied
+   * arguments, if there is space.
+   *
+   * @param args Arguments to be used in constructing an element at the end of the queue.
+   *
+   * @return @c true if successful, @c false if the queue is full or has been
+   * requested to stop.
+   */
+  template <typename ... Args>
+  auto emplace_push(Args &&... args) /* noexcept(std::is_nothrow_constructible_v<T, Args...>)*/
+        -> bool
+    requires std::is_constructible_v<T, Args...>
+  {
+    if (m_stop_tok.stop_requested()) {
+      return false;
+    }
+    return enqueue(std::forward<Args>(args)...);
+  }
+
+  /**
+   * @brief Push a value, blocking and waiting for a reader thread to pop a value
+   * if the queue is full.
+   *
+   * @param val Val to copy or move into the queue.
+   *
+   * @return @c true if successful, @c false if the queue has been requested to stop
+   * (including while waiting for space).
+   */
+  template <typename U>
+  auto wait_and_push(U&& val) /* noexcept(std::is_nothrow_constructible_v<T, U&&>) */
+        -> bool
+    requires std::is_constructible_v<T, U&&>
+  {
+    while (true) {
+      if (m_stop_tok.stop_requested()) {
+        return false;
+      }
+      if (enqueue(std::forward<U>(val))) { // only moved from if successful
+        return true;
+      }
+      auto key = m_space_ev.prepare_wait();
+      if (!full() || m_stop_tok.stop_requested()) {
+        m_space_ev.cancel_wait();
+        continue;
+      }
+      m_space_ev.wait(key);
+    }
+  }
+
+  /**
+   * @brief Pop and return a value from the @c lock_free_wait_queue, blocking and waiting
+   * for a writer thread to push a value if one is not immediately available.
+   *
+   * @return A value from the queue. If the @c std::optional is empty, the queue has been
+   * requested to be stopped.
+   */
+  [[nodiscard]] auto wait_and_pop() /* noexcept(std::is_nothrow_constructible_v<T>) */
+        -> std::optional<T>
+  {
+    while (true) {
+      if (auto val = dequeue(); val) {
+        return val;
+      }
+      if (m_stop_tok.stop_requested()) {
+        return std::optional<T> {};
+      }
+      auto key = m_data_ev.prepare_wait();
+      if (!empty() || m_stop_tok.stop_requested()) {
+        m_data_ev.cancel_wait();
+        continue;
+      }
+      m_data_ev.wait(key);
+    }
+  }
+
+  /**
+   * @brief Pop and return a value from the @c lock_free_wait_queue if an element is
+   * immediately available, otherwise return an empty @c std::optional.
+   *
+   * @return A value from the queue or an empty @c std::optional if no values are
+   * available or if the queue has been requested to be stopped.
+   */
+  [[nodiscard]] auto try_pop() /* noexcept(std::is_nothrow_constructible_v<T>) */
+        -> std::optional<T>
+  {
+    if (m_stop_tok.stop_requested()) {
+      return std::optional<T> {};
+    }
+    return dequeue();
+  }
+
+  // non-modifying methods
+
+  /**
+   * Query whether a @ request_stop method has been called on the queue.
+   *
+   * @return @c true if the @c stop_requested has been called.
+   */
+  [[nodiscard]] auto stop_requested() const noexcept
+        -> bool
+  {
+    return m_stop_tok.stop_requested();
+  }
+
+  /**
+   * Query whether the @c lock_free_wait_queue is empty or not.
+   *
+   * @return @c true if the queue is empty (at the time of the query).
+   */
+  [[nodiscard]] auto empty() const noexcept
+        -> bool
+  {
+    return size() == size_type(0);
+  }
+
+  /**
+   * Get the number of elements in the @c lock_free_wait_queue.
+   *
+   * @return Number of elements in the queue (at the time of the query). Elements
+   * in the process of being pushed or popped may or may not be counted.
+   */
+  [[nodiscard]] auto size() const noexcept
+        -> size_type
+  {
+    const auto deq = m_dequeue_pos.load(std::memory_order_seq_cst);
+    const auto enq = m_enqueue_pos.load(std::memory_order_seq_cst);
+    // positions are loaded separately, so guard against a transiently negative count
+    return (enq > deq) ? (enq - deq) : size_type(0);
+  }
+
+  /**
+   * Get the capacity of the @c lock_free_wait_queue.
+   *
+   * @return Capacity, as specified by the template parameter.
+   */
+  [[nodiscard]] static constexpr auto capacity() noexcept
+        -> size_type
+  {
+    return N;
+  }
+
+private:
+
+  auto init_cells() noexcept
+        -> void
+  {
+    for (size_type i {0u}; i < N; ++i) {
+      m_cells[i].m_seq.store(i, std::memory_order_relaxed);
+    }
+  }
+
+  auto full() const noexcept
+        -> bool
+  {
+    return size() >= N;
+  }
+
+  template <typename ... Args>
+  auto enqueue(Args&&... args)
+        -> bool
+  {
+    auto pos = m_enqueue_pos.load(std::memory_order_relaxed);
+    cell* c = nullptr;
+    while (true) {
+      c = &m_cells[pos & mask];
+      const auto seq = c->m_seq.load(std::memory_order_acquire);
+      const auto dif = static_cast<std::ptrdiff_t>(seq - pos);
+      if (dif == 0) {
+        if (m_enqueue_pos.compare_exchange_weak(pos, pos + 1u, std::memory_order_relaxed)) {
+          break;
+        }
+      }
+      else if (dif < 0) {
+        return false; // full
+      }
+      else {
+        pos = m_enqueue_pos.load(std::memory_order_relaxed);
+      }
+    }
+    std::construct_at(c->ptr(), std::forward<Args>(args)...);
+    c->m_seq.store(pos + 1u, std::memory_order_release);
+    m_data_ev.notify_one();
+    return true;
+  }
+
+  auto dequeue()
+        -> std::optional<T>
+  {
+    auto pos = m_dequeue_pos.load(std::memory_order_relaxed);
+    cell* c = nullptr;
+    while (true) {
+      c = &m_cells[pos & mask];
+      const auto seq = c->m_seq.load(std::memory_order_acquire);
+      const auto dif = static_cast<std::ptrdiff_t>(seq - (pos + 1u));
+      if (dif == 0) {
+        if (m_dequeue_pos.compare_exchange_weak(pos, pos + 1u, std::memory_order_relaxed)) {
+          break;
+        }
+      }
+      else if (dif < 0) {
+        return std::optional<T> {}; // empty
+      }
+      else {
+        pos = m_dequeue_pos.load(std::memory_order_relaxed);
+      }
+    }
+    T* p = c->ptr();
+    std::optional<T> val {std::move_if_noexcept(*p)}; // move construct if possible
+    std::destroy_at(p);
+    c->m_seq.store(pos + N, std::memory_order_release);
+    m_space_ev.notify_one();
+    return val;
+  }
+
+};
+
+} // end namespace
+
+#endif
+
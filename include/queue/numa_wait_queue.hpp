@@ -0,0 +1,659 @@
+/** @file
+ *
+ * @brief NUMA aware placement of @c wait_queue objects, and a per-node MPMC wait queue
+ * where reader threads prefer their local node before stealing from remote nodes.
+ *
+ * On a multi-socket host the memory for a @c wait_queue (the control block, including
+ * the lock, and the container storage) ends up on whichever node first touches it,
+ * typically the node of the constructing thread. Threads on other nodes then pay remote
+ * memory latency on every push and pop.
+ *
+ * The @c chops::numa namespace contains the building blocks:
+ *
+ * - @c node_count, @c this_thread_node and @c pin_this_thread, to query the NUMA topology
+ * and bind a thread to the CPUs of a node.
+ *
+ * - @c node_memory_resource, a @c std::pmr::memory_resource whose memory is bound to a
+ * node (page granularity, intended as the upstream of a pooling memory resource).
+ *
+ * - @c make_on_node, which constructs any object in memory bound to a node, returning a
+ * @c std::unique_ptr.
+ *
+ * A @c numa_wait_queue contains one @c chops::pmr::wait_queue per node, each constructed
+ * (along with its pool memory resource) in memory bound to that node. A writer thread
+ * pushes to the sub-queue of the node it is running on, and a reader thread checks its
+ * local node's sub-queue first, then "steals" from the other nodes. The stop handling,
+ * local first pop, and reader blocking (on a shared @c event_count when every sub-queue
+ * is empty) are the same code as @c sharded_wait_queue (@c detail::stoppable_event), so
+ * the @c numa_wait_queue only adds the node placement. There is no ordering between
+ * values pushed from different nodes.
+ *
+ * The placement uses the Linux @c mbind and @c getcpu system calls directly (there is
+ * no dependency on @c libnuma). On other platforms, or if a system call fails (e.g. in a
+ * container without the permission), everything falls back to a single node with the
+ * default heap allocation, and the queue behaves like a single @c wait_queue.
+ *
+ * The node of a thread is determined the first time it is needed, and cached. Threads
+ * should be pinned to a node (for example with @c pin_this_thread, which updates the
+ * cache) so that the answer stays accurate.
+ *
+ * Example usage:
+ *
+ * @code
+ *   chops::numa_wait_queue<int> wq; // one sub-queue per online node
+ *
+ *   // inside any number of writer threads
+ *   chops::numa::pin_this_thread(1u);
+ *   wq.push(42); // pushed to the node 1 sub-queue
+ *   ...
+ *   wq.request_stop();
+ *
+ *   // inside any number of reader threads
+ *   chops::numa::pin_this_thread(1u);
+ *   auto rtn_val = wq.wait_and_pop(); // node 1 sub-queue checked first
+ * @endcode
+ *
+ * @author Cliff Green
+ *
+ * @copyright (c) 2024 by Cliff Green
+ *
+ * Distributed under the Boost Software License, Version 1.0.
+ * (See accompanying file LICENSE.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+ *
+ */
+
+#ifndef NUMA_WAIT_QUEUE_HPP_INCLUDED
+#define NUMA_WAIT_QUEUE_HPP_INCLUDED
+
+#include <cassert> // assert
+#include <cstddef> // std::size_t
+#include <atomic>
+#include <memory> // std::unique_ptr
+#include <memory_resource> // std::pmr::memory_resource, std::pmr::unsynchronized_pool_resource
+#include <new> // std::bad_alloc, std::align_val_t
+#include <stop_token> // std::stop_source, std::stop_token, std::stop_callback
+#include <optional>
+#include <utility> // std::move, std::forward
+#include <vector>
+#include <type_traits> // for requires clauses
+
+#if defined(__linux__)
+#include <fstream>
+#include <string>
+#include <sched.h> // sched_setaffinity, cpu_set_t
+#include <sys/mman.h> // mmap, munmap
+#include <sys/syscall.h> // SYS_mbind, SYS_getcpu
+#include <unistd.h> // syscall, sysconf
+#endif
+
+#include "queue/pmr_wait_queue.hpp"
+#include "queue/sync_utility.hpp"
+
+namespace chops {
+
+namespace numa {
+
+namespace detail {
+
+#if defined(__linux__)
+
+// parse a sysfs range list such as "0-3,8-11", calling the function for each value
+template <typename F>
+auto for_each_in_list(const std::string& list, F func)
+        -> void
+{
+  std::size_t pos {0u};
+  while (pos < list.size()) {
+    std::size_t first {0u};
+    std::size_t last {0u};
+    std::size_t cnt {0u};
+    auto parse = [&list, &pos, &cnt] (std::size_t& num) {
+      num = 0u;
+      while (pos < list.size() && list[pos] >= '0' && list[pos] <= '9') {
+        num = num * 10u + static_cast<std::size_t>(list[pos++] - '0');
+        ++cnt;
+      }
+    };
+    parse(first);
+    last = first;
+    if (pos < list.size() && list[pos] == '-') {
+      ++pos;
+      parse(last);
+    }
+    if (cnt == 0u) {
+      return; // malformed or trailing newline
+    }
+    for (std::size_t i {first}; i <= last; ++i) {
+      func(i);
+    }
+    ++pos; // skip ',' or newline
+  }
+}
+
+inline auto read_sysfs(const std::string& path)
+        -> std::string
+{
+  std::ifstream ifs { path };
+  std::string line;
+  std::getline(ifs, line);
+  return line;
+}
+
+// mbind policy from <numaif.h>, which is part of libnuma rather than the C library
+constexpr int mpol_preferred = 1;
+
+#endif
+
+inline auto cached_node() noexcept
+        -> std::size_t&
+{
+  thread_local std::size_t node { ~std::size_t{0u} };
+  return node;
+}
+
+} // end detail namespace
+
+/**
+ * @brief Query the number of NUMA nodes.
+ *
+ * @return One more than the highest online node number, or 1 if the topology is not
+ * available. The value is read once and cached.
+ */
+inline auto node_count() noexcept
+        -> std::size_t
+{
+  static const std::size_t cnt = [] {
+    std::size_t n {1u};
+#if defined(__linux__)
+    detail::for_each_in_list(detail::read_sysfs("/sys/devices/system/node/online"),
+                             [&n] (std::size_t node) { n = (node + 1u > n) ? node + 1u : n; } );
+#endif
+    return n;
+  } ();
+  return cnt;
+}
+
+/**
+ * @brief Query the NUMA node the calling thread is running on.
+ *
+ * The node is determined the first time this is called in a thread (or set by
+ * @c pin_this_thread) and cached.
+ *
+ * @return Node number, always less than @c node_count.
+ */
+inline auto this_thread_node() noexcept
+        -> std::size_t
+{
+  auto& node = detail::cached_node();
+  if (node == ~std::size_t{0u}) {
+    node = 0u;
+#if defined(__linux__)
+    unsigned cpu {0u};
+    unsigned nd {0u};
+    if (::syscall(SYS_getcpu, &cpu, &nd, nullptr) == 0 && nd < node_count()) {
+      node = nd;
+    }
+#endif
+  }
+  return node;
+}
+
+/**
+ * @brief Bind the calling thread to the CPUs of a NUMA node.
+ *
+ * @param node Node number.
+ *
+ * @return @c true if the thread is now bound to the node, @c false if the node does not
+ * exist or the affinity could not be set. The node returned by @c this_thread_node is
+ * updated only on success.
+ */
+inline auto pin_this_thread([[maybe_unused]] std::size_t node) noexcept
+        -> bool
+{
+#if defined(__linux__)
+  if (node >= node_count()) {
+    return false;
+  }
+  cpu_set_t cpus;
+  CPU_ZERO(&cpus);
+  std::size_t cnt {0u};
+  try {
+    detail::for_each_in_list(
+        detail::read_sysfs("/sys/devices/system/node/node" + std::to_string(node) + "/cpulist"),
+        [&cpus, &cnt] (std::size_t cpu) {
+          if (cpu < CPU_SETSIZE) {
+            CPU_SET(cpu, &cpus);
+            ++cnt;
+          }
+        } );
+  }
+  catch (...) {
+    return false;
+  }
+  if (cnt == 0u || ::sched_setaffinity(0, sizeof(cpus), &cpus) != 0) {
+    return false;
+  }
+  detail::cached_node() = node;
+  return true;
+#else
+  return false;
+#endif
+}
+
+/**
+ * @brief A @c std::pmr::memory_resource allocating memory bound to a NUMA node.
+ *
+ * On Linux each allocation is a separate anonymous memory mapping, rounded up to a page,
+ * with a preferred node memory policy (if the node is out of memory the kernel falls back
+ * to other nodes rather than failing). This is intended as the upstream resource of a
+ * pooling memory resource, not for small allocations directly. On other platforms the
+ * global aligned @c operator @c new is used.
+ *
+ * The memory resource holds no state other than the node number, so any two
+ * @c node_memory_resource objects for the same node compare equal.
+ */
+class node_memory_resource : public std::pmr::memory_resource {
+private:
+  std::size_t    m_node;
+
+public:
+
+  /**
+   * @brief Construct a @c node_memory_resource for a node.
+   *
+   * @param node Node number, which must be less than @c node_count.
+   */
+  explicit node_memory_resource(std::size_t node) noexcept : m_node(node) {
+    assert(node < node_count());
+  }
+
+  /**
+   * @brief Query the node of this memory resource.
+   */
+  [[nodiscard]] auto node() const noexcept
+        -> std::size_t
+  {
+    return m_node;
+  }
+
+private:
+
+#if defined(__linux__)
+  static auto mapped_size(std::size_t bytes) noexcept
+        -> std::size_t
+  {
+    static const std::size_t page = static_cast<std::size_t>(::sysconf(_SC_PAGESIZE));
+    return (bytes + page - 1u) / page * page;
+  }
+#endif
+
+  auto do_allocate(std::size_t bytes, [[maybe_unused]] std::size_t alignment)
+        -> void* override
+  {
+#if defined(__linux__)
+    assert(alignment <= mapped_size(1u));
+    const auto len = mapped_size(bytes);
+    void* ptr = ::mmap(nullptr, len, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (ptr == MAP_FAILED) {
+      throw std::bad_alloc {};
+    }
+    if (node_count() > 1u) {
+      constexpr std::size_t bits = sizeof(unsigned long) * 8u;
+      unsigned long mask[(CPU_SETSIZE + bits - 1u) / bits] { };
+      mask[m_node / bits] = 1ul << (m_node % bits);
+      // best effort, the mapping is still usable (on the first touching node) on failure
+      (void) ::syscall(SYS_mbind, ptr, len, detail::mpol_preferred, mask,
+                       sizeof(mask) * 8u + 1u, 0u);
+    }
+    return ptr;
+#else
+    return ::operator new(bytes, std::align_val_t{alignment});
+#endif
+  }
+
+  auto do_deallocate(void* ptr, [[maybe_unused]] std::size_t bytes,
+                     [[maybe_unused]] std::size_t alignment)
+        -> void override
+  {
+#if defined(__linux__)
+    ::munmap(ptr, mapped_size(bytes));
+#else
+    ::operator delete(ptr, std::align_val_t{alignment});
+#endif
+  }
+
+  auto do_is_equal(const std::pmr::memory_resource& other) const noexcept
+        -> bool override
+  {
+    auto* rhs = dynamic_cast<const node_memory_resource*>(&other);
+    return rhs != nullptr && rhs->m_node == m_node;
+  }
+
+};
+
+/**
+ * @brief Deleter for objects constructed by @c make_on_node.
+ */
+template <typename T>
+struct node_deleter {
+  std::size_t    m_node;
+
+  auto operator()(T* ptr) const noexcept -> void {
+    ptr->~T();
+    node_memory_resource { m_node }.deallocate(ptr, sizeof(T), alignof(T));
+  }
+};
+
+/**
+ * @brief Construct an object in memory bound to a NUMA node.
+ *
+ * The object is constructed (and therefore first touched) in node bound memory, so
+ * for example a @c wait_queue control block, including the lock, lives on the node.
+ * Container storage is a separate allocation, see @c numa_wait_queue for placing both.
+ *
+ * @param node Node number, which must be less than @c node_count.
+ *
+ * @param args Arguments used in constructing the object.
+ *
+ * @return A @c std::unique_ptr owning the object.
+ */
+template <typename T, typename ... Args>
+auto make_on_node(std::size_t node, Args&&... args)
+        -> std::unique_ptr<T, node_deleter<T>>
+{
+  node_memory_resource res { node };
+  void* mem = res.allocate(sizeof(T), alignof(T));
+  try {
+    return std::unique_ptr<T, node_deleter<T>> { ::new (mem) T(std::forward<Args>(args)...),
+                                                  node_deleter<T>{node} };
+  }
+  catch (...) {
+    res.deallocate(mem, sizeof(T), alignof(T));
+    throw;
+  }
+}
+
+} // end numa namespace
+
+/**
+ * @brief MPMC wait queue with one sub-queue per NUMA node, each placed on its node.
+ *
+ * @tparam T Type of value that will be passed through the queue.
+ *
+ * @tparam WaitPolicy Wait policy of each @c chops::pmr::wait_queue sub-queue.
+ *
+ * @pre The value type must be either copy constructible or move constructible.
+ *
+ */
+template <typename T, wait_policy WaitPolicy = block_wait>
+  requires (std::is_copy_constructible_v<T> || std::is_move_constructible_v<T>)
+class numa_wait_queue {
+public:
+
+  using node_queue_type = chops::pmr::wait_queue<T, WaitPolicy>;
+  using size_type = std::size_t;
+  using value_type = T;
+
+private:
+
+  // constructed in node bound memory, the pool hands out container blocks from
+  // node bound pages; all container memory operations are under the sub-queue lock
+  struct alignas(cache_line_size) node_queue {
+    numa::node_memory_resource             m_upstream;
+    std::pmr::unsynchronized_pool_resource m_pool;
+    node_queue_type                        m_wq;
+
+    node_queue(std::size_t node, std::stop_token stop_tok)
+        : m_upstream(node), m_pool(&m_upstream), m_wq(stop_tok, &m_pool) { }
+  };
+
+  using node_ptr = std::unique_ptr<node_queue, numa::node_deleter<node_queue>>;
+
+  static auto make_nodes(std::size_t nodes, std::stop_token stop_tok)
+        -> std::vector<node_ptr>
+  {
+    std::vector<node_ptr> vec;
+    vec.reserve(nodes);
+    for (std::size_t i {0u}; i < nodes; ++i) {
+      vec.push_back(numa::make_on_node<node_queue>(i, i, stop_tok));
+    }
+    return vec;
+  }
+
+  detail::stoppable_event                    m_sync;
+  std::vector<node_ptr>                      m_nodes;
+
+public:
+
+  /**
+   * @brief Default construct a @c numa_wait_queue, with one sub-queue per node.
+   *
+   * An internal @c stop_source is used to provide a @c std::stop_token for
+   * coordinating shutdown.
+   *
+   * @param nodes Number of sub-queues, defaulting to @c numa::node_count (must not be
+   * larger than @c numa::node_count).
+   *
+   * @post @c empty returns @c true.
+   * @post @c stop_requested returns @c false.
+   */
+  explicit numa_wait_queue(size_type nodes = numa::node_count())
+      : m_sync(), m_nodes(make_nodes(nodes, m_sync.token()))
+  {
+    assert(nodes > 0u && nodes <= numa::node_count());
+    assert(empty());
+    assert(!stop_requested());
+  }
+
+  /**
+   * @brief Construct a @c numa_wait_queue with an externally provided
+   * @c std::stop_token.
+   *
+   * @param stop_tok A @c std::stop_token which can be used to shutdown queue processing.
+   *
+   * @param nodes Number of sub-queues, defaulting to @c numa::node_count.
+   *
+   * @post @c empty returns @c true.
+   */
+  numa_wait_queue(std::stop_token stop_tok, size_type nodes = numa::node_count())
+      : m_sync(stop_tok), m_nodes(make_nodes(nodes, m_sync.token()))
+  {
+    assert(nodes > 0u && nodes <= numa::node_count());
+    assert(empty());
+  }
+
+  // disallow copy or move construction of the entire object
+  numa_wait_queue(const numa_wait_queue&) = delete;
+  numa_wait_queue(numa_wait_queue&&) = delete;
+
+  // disallow copy or move assigment of the entire object
+  numa_wait_queue& operator=(const numa_wait_queue&) = delete;
+  numa_wait_queue& operator=(numa_wait_queue&&) = delete;
+
+  // modifying methods
+
+  /**
+   * @brief Request the @c numa_wait_queue to stop processing, unless a
+   * @c std::stop_token was passed in to a constructor.
+   *
+   * @return @c true if an internal @c stop_source was used and the request returns
+   * @c true, @c false if an external @c std::stop_token was passed in.
+   */
+  auto request_stop() noexcept
+        -> bool
+  {
+    return m_sync.request_stop();
+  }
+
+  /**
+   * @brief Push a value, by copying, to the sub-queue of the calling thread's node.
+   *
+   * @param val Val to copy into the queue.
+   *
+   * @return @c true if successful, @c false if the queue has been requested to stop.
+   */
+  auto push(const T& val) /* noexcept(std::is_nothrow_copy_constructible_v<T>) */
+        -> bool
+  {
+    return emplace_push_to(numa::this_thread_node(), val);
+  }
+
+  /**
+   * @brief Push a value, either by moving or copying, to the sub-queue of the calling
+   * thread's node.
+   *
+   * This method has the same semantics as the other @c push, except that the value will
+   * be moved (if possible) instead of copied.
+   */
+  auto push(T&& val) /* noexcept(std::is_nothrow_move_constructible_v<T>) */
+        -> bool
+  {
+    return emplace_push_to(numa::this_thread_node(), std::move(val));
+  }
+
+  /**
+   * @brief Directly construct an object in the sub-queue of the calling thread's node.
+   *
+   * @param args Arguments to be used in constructing an element.
+   *
+   * @return @c true if successful, @c false if the queue has been requested to stop.
+   */
+  template <typename ... Args>
+  auto emplace_push(Args &&... args) /* noexcept(std::is_nothrow_constructible_v<T, Args...>)*/
+        -> bool
+  {
+    return emplace_push_to(numa::this_thread_node(), std::forward<Args>(args)...);
+  }
+
+  /**
+   * @brief Directly construct an object in the sub-queue of a specific node.
+   *
+   * @param node Node number (modulo the number of sub-queues).
+   *
+   * @param args Arguments to be used in constructing an element.
+   *
+   * @return @c true if successful, @c false if the queue has been requested to stop.
+   */
+  template <typename ... Args>
+  auto emplace_push_to(std::size_t node, Args &&... args) /* noexcept */
+        -> bool
+  {
+    if (!m_nodes[node % m_nodes.size()]->m_wq.emplace_push(std::forward<Args>(args)...)) {
+      return false;
+    }
+    m_sync.notify_one();
+    return true;
+  }
+
+  /**
+   * @brief Pop and return a value, preferring the calling thread's node, blocking and
+   * waiting for a writer thread to push a value if every sub-queue is empty.
+   *
+   * @return A value from the queue. If the @c std::optional is empty, the queue has been
+   * requested to be stopped.
+   */
+  [[nodiscard]] auto wait_and_pop() /* noexcept(std::is_nothrow_constructible_v<T>) */
+        -> std::optional<T>
+  {
+    return m_sync.wait_and_pop([this] { return try_pop(); });
+  }
+
+  /**
+   * @brief Pop and return a value if one is immediately available, otherwise return an
+   * empty @c std::optional.
+   *
+   * The calling thread's node sub-queue is checked first, then the other nodes in turn.
+   *
+   * @return A value from the queue or an empty @c std::optional if every sub-queue is
+   * empty or the queue has been requested to be stopped.
+   */
+  [[nodiscard]] auto try_pop() /* noexcept(std::is_nothrow_constructible_v<T>) */
+        -> std::optional<T>
+  {
+    return detail::try_pop_each(numa::this_thread_node(), m_nodes.size(),
+                                [this] (std::size_t idx) { return m_nodes[idx]->m_wq.try_pop(); });
+  }
+
+  /**
+   * @brief Pop and return a value from the calling thread's node sub-queue only, never
+   * stealing from a remote node.
+   *
+   * @return A value from the local sub-queue or an empty @c std::optional.
+   */
+  [[nodiscard]] auto try_pop_local() /* noexcept(std::is_nothrow_constructible_v<T>) */
+        -> std::optional<T>
+  {
+    return m_nodes[numa::this_thread_node() % m_nodes.size()]->m_wq.try_pop();
+  }
+
+  // non-modifying methods
+
+  /**
+   * Query whether a @ request_stop method has been called on the queue.
+   *
+   * @return @c true if the @c stop_requested has been called.
+   */
+  [[nodiscard]] auto stop_requested() const noexcept
+        -> bool
+  {
+    return m_sync.stop_requested();
+  }
+
+  /**
+   * Query whether every sub-queue is empty.
+   *
+   * @return @c true if every sub-queue is empty (each is checked in turn, so the result
+   * may be out of date if other threads are pushing or popping).
+   */
+  [[nodiscard]] auto empty() const /* noexcept */
+        -> bool
+  {
+    for (const auto& nq : m_nodes) {
+      if (!nq->m_wq.empty()) {
+        return false;
+      }
+    }
+    return true;
+  }
+
+  /**
+   * Get the number of elements in all sub-queues.
+   *
+   * @return Total number of elements (each sub-queue is checked in turn).
+   */
+  [[nodiscard]] auto size() const /* noexcept */
+        -> size_type
+  {
+    size_type sz {0u};
+    for (const auto& nq : m_nodes) {
+      sz += nq->m_wq.size();
+    }
+    return sz;
+  }
+
+  /**
+   * Get the number of elements in the sub-queue of a node.
+   *
+   * @param node Node number (modulo the number of sub-queues).
+   */
+  [[nodiscard]] auto node_size(std::size_t node) const /* noexcept */
+        -> size_type
+  {
+    return m_nodes[node % m_nodes.size()]->m_wq.size();
+  }
+
+  /**
+   * Get the number of sub-queues.
+   */
+  [[nodiscard]] auto node_count() const noexcept
+        -> size_type
+  {
+    return m_nodes.size();
+  }
+
+};
+
+} // end namespace
+
+#endif
+
@@ -0,0 +1,66 @@
+/** @file
+ *
+ * @brief Polymorphic memory resource (PMR) alias for @c wait_queue.
+ *
+ * The default @c wait_queue container, @c std::deque, allocates and deallocates blocks
+ * of memory as the queue grows and shrinks. A @c chops::pmr::wait_queue uses a
+ * @c std::pmr::deque, with the memory allocated from a @c std::pmr::memory_resource
+ * passed in to the constructor. With a pooling memory resource the blocks are recycled
+ * within the pool, so once the queue has reached its steady state size, pushes and pops
+ * do not call the general purpose heap allocator.
+ *
+ * A @c std::pmr::unsynchronized_pool_resource (or a @c monotonic_buffer_resource over
+ * a pre-allocated buffer, as an upstream resource) can be used when the memory resource
+ * is dedicated to one @c wait_queue, since all container memory operations are performed
+ * while the internal lock is held. The exception is the container returned from the
+ * @c drain and @c wait_and_drain methods (which uses the same memory resource), which
+ * must then be destroyed while no other thread is accessing the @c wait_queue. Otherwise
+ * a @c std::pmr::synchronized_pool_resource can be used.
+ *
+ * Example usage:
+ *
+ * @code
+ *   std::pmr::unsynchronized_pool_resource pool;
+ *   chops::pmr::wait_queue<int> wq { &pool };
+ *   // push and pop same as code with default container
+ * @endcode
+ *
+ * @author Cliff Green
+ *
+ * @copyright (c) 2024 by Cliff Green
+ *
+ * Distributed under the Boost Software License, Version 1.0.
+ * (See accompanying file LICENSE.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+ *
+ */
+
+#ifndef PMR_WAIT_QUEUE_HPP_INCLUDED
+#define PMR_WAIT_QUEUE_HPP_INCLUDED
+
+#include <deque> // std::pmr::deque
+#include <memory_resource> // std::pmr::memory_resource, std::pmr::polymorphic_allocator
+
+#include "queue/wait_queue.hpp"
+
+namespace chops {
+
+namespace pmr {
+
+/**
+ * @brief @c wait_queue using a @c std::pmr::deque container.
+ *
+ * The memory resource is passed in to the constructor as a @c std::pmr::memory_resource
+ * pointer (or a @c std::pmr::polymorphic_allocator), optionally along with a
+ * @c std::stop_token. If no memory resource is passed in, the default memory resource
+ * (@c std::pmr::get_default_resource) is used.
+ */
+template <typename T, wait_policy WaitPolicy = block_wait, stats_policy StatsPolicy = null_stats,
+          layout_policy LayoutPolicy = compact_layout>
+using wait_queue = chops::wait_queue<T, std::pmr::deque<T>, WaitPolicy, StatsPolicy, LayoutPolicy>;
+
+} // end pmr namespace
+
+} // end namespace
+
+#endif
+
@@ -0,0 +1,494 @@
+/** @file
+ *
+ * @brief Priority ordered container types for use as the @c wait_queue container, plus
+ * priority @c wait_queue aliases.
+ *
+ * A @c wait_queue pops the element returned from the container @c front method, so a
+ * container that keeps the highest priority element at the front turns a @c wait_queue
+ * into a priority queue, with all of the locking, shutdown and notification semantics
+ * unchanged. This allows (for example) control messages to overtake bulk data, using one
+ * queue instead of polling multiple queues.
+ *
+ * Two containers are provided:
+ *
+ * - @c priority_heap, a d-ary heap (binary by default) ordered by a user supplied
+ *   comparator, with O(log n) @c push_back and @c pop_front. As with @c std::priority_queue,
+ *   the front element is the greatest according to the comparator (e.g. with @c std::less,
+ *   the largest value). Elements that compare equal are not guaranteed to be popped in
+ *   the order they were pushed.
+ *
+ * - @c priority_lanes, a small fixed number of FIFO lanes (one per priority level) plus a
+ *   bitmask of non-empty lanes, with O(1) @c push_back and @c pop_front. This is a good
+ *   fit when the priorities are a small enum. A user supplied function object maps each
+ *   element to its lane, with lane 0 the highest priority. Elements within a lane are
+ *   popped in FIFO order.
+ *
+ * Example usage:
+ *
+ * @code
+ *   chops::priority_wait_queue<int> wq; // largest int popped first
+ *
+ *   enum class prio : std::size_t { control = 0, normal = 1, bulk = 2 };
+ *   struct msg { prio m_prio; std::string m_body; };
+ *   struct msg_lane {
+ *     auto operator()(const msg& m) const noexcept -> std::size_t {
+ *       return static_cast<std::size_t>(m.m_prio);
+ *     }
+ *   };
+ *   chops::lane_wait_queue<msg, 3, msg_lane> lwq;
+ * @endcode
+ *
+ * @note Iteration (e.g. through the @c wait_queue @c apply method) visits the elements of
+ * a @c priority_heap in heap order, not priority order. A @c priority_lanes is visited in
+ * priority order.
+ *
+ * @note The @c wait_queue @c drain methods that return a container default construct the
+ * new container, so a stateful comparator or lane function object is not carried over.
+ *
+ * @author Cliff Green
+ *
+ * @copyright (c) 2024 by Cliff Green
+ *
+ * Distributed under the Boost Software License, Version 1.0.
+ * (See accompanying file LICENSE.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+ *
+ */
+
+#ifndef PRIORITY_CONTAINER_HPP_INCLUDED
+#define PRIORITY_CONTAINER_HPP_INCLUDED
+
+#include <cassert> // assert
+#include <cstddef> // std::size_t, std::ptrdiff_t
+#include <cstdint> // std::uint64_t
+#include <vector>
+#include <deque>
+#include <array>
+#include <functional> // std::less, std::invoke
+#include <bit> // std::countr_zero
+#include <iterator> // std::forward_iterator_tag
+#include <utility> // std::move, std::forward
+#include <type_traits> // for requires clauses
+
+#include "queue/wait_queue.hpp"
+
+namespace chops {
+
+/**
+ * @brief D-ary heap container, with the greatest element (according to the comparator)
+ * at the front.
+ *
+ * @tparam T Type of element.
+ *
+ * @tparam Compare Comparator, a strict weak ordering; defaults to @c std::less<T>.
+ *
+ * @tparam Arity Number of children per heap node, 2 for a binary heap. A larger arity
+ * (e.g. 4) makes the heap shallower, with fewer cache misses when pushing.
+ *
+ */
+template <typename T, typename Compare = std::less<T>, std::size_t Arity = 2u>
+  requires (Arity >= 2u) && std::is_move_constructible_v<T> && std::is_move_assignable_v<T>
+class priority_heap {
+public:
+
+  using value_type = T;
+  using size_type = typename std::vector<T>::size_type;
+  using reference = T&;
+  using const_reference = const T&;
+  using iterator = typename std::vector<T>::iterator;
+  using const_iterator = typename std::vector<T>::const_iterator;
+
+private:
+
+  std::vector<T> m_data;
+  [[no_unique_address]] Compare m_cmp;
+
+public:
+
+  /**
+   * @brief Default construct an empty heap.
+   */
+  priority_heap()
+    requires std::is_default_constructible_v<Compare>
+        = default;
+
+  /**
+   * @brief Construct an empty heap with a comparator object, for stateful comparators.
+   *
+   * To use with a @c wait_queue, construct the @c wait_queue with the container (e.g.
+   * @c wait_queue<T, priority_heap<T, C>> wq { priority_heap<T, C> { cmp } }).
+   *
+   * @param cmp Comparator object.
+   */
+  explicit priority_heap(const Compare& cmp) : m_data(), m_cmp(cmp) { }
+
+  // modifying methods
+
+  /**
+   * @brief Add an element, restoring the heap order.
+   */
+  auto push_back(const T& val)
+        -> void
+    requires std::is_copy_constructible_v<T>
+  {
+    m_data.push_back(val);
+    sift_up(m_data.size() - 1u);
+  }
+
+  auto push_back(T&& val)
+        -> void
+  {
+    m_data.push_back(std::move(val));
+    sift_up(m_data.size() - 1u);
+  }
+
+  /**
+   * @brief Construct an element in place, restoring the heap order.
+   *
+   * @return Reference to the front (greatest) element, since the constructed element
+   * may have moved within the heap.
+   */
+  template <typename ... Args>
+  auto emplace_back(Args&&... args)
+        -> reference
+    requires std::is_constructible_v<T, Args...>
+  {
+    m_data.emplace_back(std::forward<Args>(args)...);
+    sift_up(m_data.size() - 1u);
+    return m_data.front();
+  }
+
+  /**
+   * @brief Remove the greatest element.
+   *
+   * @pre @c empty returns @c false.
+   */
+  auto pop_front()
+        -> void
+  {
+    assert(!empty());
+    if (m_data.size() > 1u) {
+      m_data.front() = std::move(m_data.back());
+      m_data.pop_back();
+      sift_down(0u);
+      return;
+    }
+    m_data.pop_back();
+  }
+
+  auto clear() noexcept -> void { m_data.clear(); }
+
+  /**
+   * @brief Reserve memory for the underlying @c std::vector.
+   */
+  auto reserve(size_type sz) -> void { m_data.reserve(sz); }
+
+  // element access
+
+  /**
+   * @brief Access the greatest element.
+   *
+   * @note Modifying the element through the returned reference (other than moving from
+   * it immediately before a @c pop_front) breaks the heap order.
+   *
+   * @pre @c empty returns @c false.
+   */
+  [[nodiscard]] auto front() noexcept -> reference { assert(!empty()); return m_data.front(); }
+  [[nodiscard]] auto front() const noexcept -> const_reference { assert(!empty()); return m_data.front(); }
+
+  [[nodiscard]] auto begin() noexcept -> iterator { return m_data.begin(); }
+  [[nodiscard]] auto end() noexcept -> iterator { return m_data.end(); }
+  [[nodiscard]] auto begin() const noexcept -> const_iterator { return m_data.cbegin(); }
+  [[nodiscard]] auto end() const noexcept -> const_iterator { return m_data.cend(); }
+
+  // non-modifying methods
+
+  [[nodiscard]] auto empty() const noexcept -> bool { return m_data.empty(); }
+  [[nodiscard]] auto size() const noexcept -> size_type { return m_data.size(); }
+
+private:
+
+  // hole based sifting, one move per level instead of a swap
+  auto sift_up(size_type idx)
+        -> void
+  {
+    T val (std::move(m_data[idx]));
+    while (idx > 0u) {
+      size_type parent = (idx - 1u) / Arity;
+      if (!m_cmp(m_data[parent], val)) {
+        break;
+      }
+      m_data[idx] = std::move(m_data[parent]);
+      idx = parent;
+    }
+    m_data[idx] = std::move(val);
+  }
+
+  auto sift_down(size_type idx)
+        -> void
+  {
+    const size_type sz = m_data.size();
+    T val (std::move(m_data[idx]));
+    while (true) {
+      size_type first = (idx * Arity) + 1u;
+      if (first >= sz) {
+        break;
+      }
+      size_type last = (sz - first) < Arity ? sz : first + Arity;
+      size_type best = first;
+      for (size_type c {first + 1u}; c < last; ++c) {
+        if (m_cmp(m_data[best], m_data[c])) {
+          best = c;
+        }
+      }
+      if (!m_cmp(val, m_data[best])) {
+        break;
+      }
+      m_data[idx] = std::move(m_data[best]);
+      idx = best;
+    }
+    m_data[idx] = std::move(val);
+  }
+
+};
+
+/**
+ * @brief Fixed number of FIFO priority lanes, with lane 0 the highest priority.
+ *
+ * @tparam T Type of element.
+ *
+ * @tparam Lanes Number of lanes (priority levels), from 1 to 64.
+ *
+ * @tparam LaneOf Function object type, invoked with a @c const @c T& and returning the
+ * lane index for the element.
+ *
+ * @tparam Lane FIFO container type for each lane, defaulting to @c std::deque<T>.
+ *
+ */
+template <typename T, std::size_t Lanes, typename LaneOf, typename Lane = std::deque<T>>
+  requires (Lanes > 0u) && (Lanes <= 64u) &&
+           std::is_default_constructible_v<Lane> &&
+           std::is_invocable_r_v<std::size_t, const LaneOf&, const T&>
+class priority_lanes {
+public:
+
+  using value_type = T;
+  using size_type = std::size_t;
+  using reference = T&;
+  using const_reference = const T&;
+
+private:
+
+  std::array<Lane, Lanes> m_lanes;
+  std::uint64_t m_mask {0u}; // bit set for each non-empty lane
+  size_type m_size {0u};
+  [[no_unique_address]] LaneOf m_lane_of;
+
+public:
+
+  /**
+   * @brief Forward iterator, visiting the elements in priority order.
+   */
+  class const_iterator {
+  private:
+    using lane_iter = typename Lane::const_iterator;
+
+    const std::array<Lane, Lanes>* m_lanes {nullptr};
+    size_type m_lane {Lanes};
+    lane_iter m_it { };
+
+    auto skip_empty() -> void {
+      while (m_lane < Lanes && m_it == (*m_lanes)[m_lane].cend()) {
+        if (++m_lane < Lanes) {
+          m_it = (*m_lanes)[m_lane].cbegin();
+        }
+      }
+    }
+
+  public:
+    using iterator_category = std::forward_iterator_tag;
+    using value_type = T;
+    using difference_type = std::ptrdiff_t;
+    using pointer = const T*;
+    using reference = const T&;
+
+    const_iterator() = default;
+    const_iterator(const std::array<Lane, Lanes>* lanes, size_type lane) :
+        m_lanes(lanes), m_lane(lane) {
+      if (m_lane < Lanes) {
+        m_it = (*m_lanes)[m_lane].cbegin();
+        skip_empty();
+      }
+    }
+
+    auto operator*() const -> const T& { return *m_it; }
+    auto operator->() const -> const T* { return &(*m_it); }
+    auto operator++() -> const_iterator& { ++m_it; skip_empty(); return *this; }
+    auto operator++(int) -> const_iterator { auto tmp {*this}; ++(*this); return tmp; }
+    auto operator==(const const_iterator& rhs) const -> bool {
+      return (m_lane == rhs.m_lane) && (m_lane == Lanes || m_it == rhs.m_it);
+    }
+  };
+
+  /**
+   * @brief Default construct with all lanes empty.
+   */
+  priority_lanes()
+    requires std::is_default_constructible_v<LaneOf>
+        = default;
+
+  /**
+   * @brief Construct with a lane function object, for stateful function objects.
+   *
+   * @param lane_of Function object mapping an element to a lane index.
+   */
+  explicit priority_lanes(const LaneOf& lane_of) : m_lanes(), m_lane_of(lane_of) { }
+
+  // modifying methods
+
+  /**
+   * @brief Add an element to the back of its lane.
+   *
+   * @pre The lane index for @c val is less than @c Lanes.
+   */
+  auto push_back(const T& val)
+        -> void
+    requires std::is_copy_constructible_v<T>
+  {
+    const auto idx = lane_index(val);
+    m_lanes[idx].push_back(val);
+    mark_pushed(idx);
+  }
+
+  auto push_back(T&& val)
+        -> void
+  {
+    const auto idx = lane_index(val);
+    m_lanes[idx].push_back(std::move(val));
+    mark_pushed(idx);
+  }
+
+  /**
+   * @brief Construct an element, then move it to the back of its lane (the element must
+   * exist before its lane is known).
+   *
+   * @return Reference to the element in its lane.
+   */
+  template <typename ... Args>
+  auto emplace_back(Args&&... args)
+        -> reference
+    requires std::is_constructible_v<T, Args...> && std::is_move_constructible_v<T>
+  {
+    T val (std::forward<Args>(args)...);
+    const auto idx = lane_index(val);
+    m_lanes[idx].push_back(std::move(val));
+    mark_pushed(idx);
+    return m_lanes[idx].back();
+  }
+
+  /**
+   * @brief Remove the oldest element of the highest priority non-empty lane.
+   *
+   * @pre @c empty returns @c false.
+   */
+  auto pop_front()
+        -> void
+  {
+    assert(!empty());
+    const auto idx = top_lane();
+    m_lanes[idx].pop_front();
+    --m_size;
+    if (m_lanes[idx].empty()) {
+      m_mask &= ~(std::uint64_t{1u} << idx);
+    }
+  }
+
+  auto clear()
+        -> void
+  {
+    for (auto& lane : m_lanes) {
+      lane.clear();
+    }
+    m_mask = 0u;
+    m_size = 0u;
+  }
+
+  // element access
+
+  /**
+   * @brief Access the oldest element of the highest priority non-empty lane.
+   *
+   * @pre @c empty returns @c false.
+   */
+  [[nodiscard]] auto front() -> reference { assert(!empty()); return m_lanes[top_lane()].front(); }
+  [[nodiscard]] auto front() const -> const_reference { assert(!empty()); return m_lanes[top_lane()].front(); }
+
+  [[nodiscard]] auto begin() const -> const_iterator { return const_iterator { &m_lanes, 0u }; }
+  [[nodiscard]] auto end() const -> const_iterator { return const_iterator { &m_lanes, Lanes }; }
+
+  // non-modifying methods
+
+  [[nodiscard]] auto empty() const noexcept -> bool { return m_size == 0u; }
+  [[nodiscard]] auto size() const noexcept -> size_type { return m_size; }
+
+  /**
+   * @brief Number of elements in one lane.
+   *
+   * @pre @c idx is less than @c Lanes.
+   */
+  [[nodiscard]] auto lane_size(size_type idx) const noexcept
+        -> size_type
+  {
+    assert(idx < Lanes);
+    return m_lanes[idx].size();
+  }
+
+private:
+
+  auto top_lane() const noexcept
+        -> size_type
+  {
+    return static_cast<size_type>(std::countr_zero(m_mask));
+  }
+
+  auto lane_index(const T& val) const
+        -> size_type
+  {
+    const size_type idx = std::invoke(m_lane_of, val);
+    assert(idx < Lanes);
+    return idx;
+  }
+
+  // called after a successful push, so the bookkeeping is unchanged if the push throws
+  auto mark_pushed(size_type idx) noexcept
+        -> void
+  {
+    m_mask |= (std::uint64_t{1u} << idx);
+    ++m_size;
+  }
+
+};
+
+/**
+ * @brief @c wait_queue popping the greatest element (according to the comparator) first,
+ * backed by a @c priority_heap.
+ */
+template <typename T, typename Compare = std::less<T>,
+          wait_policy WaitPolicy = block_wait, stats_policy StatsPolicy = null_stats,
+          layout_policy LayoutPolicy = compact_layout>
+using priority_wait_queue = wait_queue<T, priority_heap<T, Compare>, WaitPolicy, StatsPolicy,
+                                       LayoutPolicy>;
+
+/**
+ * @brief @c wait_queue popping the oldest element of the highest priority lane first,
+ * backed by a @c priority_lanes container.
+ */
+template <typename T, std::size_t Lanes, typename LaneOf,
+          wait_policy WaitPolicy = block_wait, stats_policy StatsPolicy = null_stats,
+          layout_policy LayoutPolicy = compact_layout>
+using lane_wait_queue = wait_queue<T, priority_lanes<T, Lanes, LaneOf>, WaitPolicy, StatsPolicy,
+                                   LayoutPolicy>;
+
+} // end namespace
+
+#endif
+
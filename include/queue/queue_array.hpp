@@ -0,0 +1,164 @@
+/** @file
+ *
+ * @brief Fixed size array of queues, where each queue owns its own cache lines.
+ *
+ * A @c std::array (or @c std::vector) of @c wait_queue objects places the queues next to
+ * each other in memory, so the end of one queue and the beginning of the next can share
+ * a cache line. Writes to one queue (e.g. the lock) then invalidate the cache line for
+ * threads accessing the adjacent queue (false sharing). A @c queue_array wraps each
+ * queue in a @c cache_aligned wrapper, guaranteeing that no two queues share a cache line.
+ *
+ * Any of the queue class templates in this library can be used as the element type.
+ * Since the queues are not copyable or movable, they are constructed in place, either
+ * default constructed or all constructed with the same @c std::stop_token.
+ *
+ * Example usage:
+ *
+ * @code
+ *   chops::queue_array<chops::wait_queue<int>, 16> qs; // e.g. one queue per device
+ *   qs[3].push(42);
+ *   ...
+ *   qs.request_stop(); // all queues
+ * @endcode
+ *
+ * @author Cliff Green
+ *
+ * @copyright (c) 2024 by Cliff Green
+ *
+ * Distributed under the Boost Software License, Version 1.0.
+ * (See accompanying file LICENSE.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+ *
+ */
+
+#ifndef QUEUE_ARRAY_HPP_INCLUDED
+#define QUEUE_ARRAY_HPP_INCLUDED
+
+#include <cassert> // assert
+#include <cstddef> // std::size_t
+#include <array>
+#include <stop_token> // std::stop_token
+#include <utility> // std::index_sequence
+#include <type_traits> // for requires clauses
+
+#include "queue/sync_utility.hpp" // cache_aligned
+
+namespace chops {
+
+/**
+ * @brief Fixed size array of cache line isolated queues.
+ *
+ * @tparam Q Queue type, for example @c wait_queue<int>.
+ *
+ * @tparam N Number of queues.
+ *
+ */
+template <typename Q, std::size_t N>
+  requires (N > 0u)
+class queue_array {
+public:
+
+  using size_type = std::size_t;
+  using value_type = cache_aligned<Q>;
+  using iterator = typename std::array<value_type, N>::iterator;
+  using const_iterator = typename std::array<value_type, N>::const_iterator;
+
+private:
+
+  template <std::size_t ... Is>
+  static auto make_queues(std::stop_token stop_tok, std::index_sequence<Is...>)
+        -> std::array<value_type, N>
+  {
+    return std::array<value_type, N> { ((void)Is, value_type{stop_tok})... };
+  }
+
+  std::array<value_type, N> m_queues;
+
+public:
+
+  /**
+   * @brief Default construct each queue.
+   */
+  queue_array()
+    requires std::is_default_constructible_v<Q>
+        = default;
+
+  /**
+   * @brief Construct each queue with the same externally provided @c std::stop_token.
+   *
+   * @param stop_tok A @c std::stop_token which can be used to shutdown all of the queues.
+   */
+  explicit queue_array(std::stop_token stop_tok)
+    requires std::is_constructible_v<Q, std::stop_token>
+      : m_queues(make_queues(stop_tok, std::make_index_sequence<N>{}))
+  {
+  }
+
+  // disallow copy or move construction of the entire object
+  queue_array(const queue_array&) = delete;
+  queue_array(queue_array&&) = delete;
+
+  // disallow copy or move assigment of the entire object
+  queue_array& operator=(const queue_array&) = delete;
+  queue_array& operator=(queue_array&&) = delete;
+
+  /**
+   * @brief Access a queue.
+   *
+   * @param idx Index of the queue.
+   *
+   * @return Reference to the queue.
+   *
+   * @pre @c idx is less than @c N.
+   */
+  [[nodiscard]] auto operator[](size_type idx) noexcept
+        -> Q&
+  {
+    assert(idx < N);
+    return m_queues[idx];
+  }
+
+  [[nodiscard]] auto operator[](size_type idx) const noexcept
+        -> const Q&
+  {
+    assert(idx < N);
+    return m_queues[idx];
+  }
+
+  /**
+   * @brief Request each queue to stop processing.
+   *
+   * @return @c true if every queue returned @c true from its @c request_stop (i.e.
+   * internal @c std::stop_source objects were used).
+   */
+  auto request_stop() noexcept
+        -> bool
+  {
+    bool all {true};
+    for (auto& q : m_queues) {
+      all = q.request_stop() && all;
+    }
+    return all;
+  }
+
+  [[nodiscard]] auto begin() noexcept -> iterator { return m_queues.begin(); }
+  [[nodiscard]] auto end() noexcept -> iterator { return m_queues.end(); }
+  [[nodiscard]] auto begin() const noexcept -> const_iterator { return m_queues.cbegin(); }
+  [[nodiscard]] auto end() const noexcept -> const_iterator { return m_queues.cend(); }
+
+  /**
+   * Get the number of queues.
+   *
+   * @return Number of queues, as specified by the template parameter.
+   */
+  [[nodiscard]] static constexpr auto size() noexcept
+        -> size_type
+  {
+    return N;
+  }
+
+};
+
+} // end namespace
+
+#endif
+
@@ -0,0 +1,340 @@
+/** @file
+ *
+ * @brief Sharded (striped) MPMC wait queue, trading global FIFO ordering for writer
+ * thread scalability.
+ *
+ * A @c sharded_wait_queue contains a fixed number of @c wait_queue shards, each on its
+ * own cache lines and each with its own lock. A writer thread pushes to one shard,
+ * selected either by a per-thread affinity (each writer thread is assigned a shard the
+ * first time it pushes, round-robin) or by a caller supplied hint (e.g. a hash of a key).
+ * Writers on different shards do not contend with each other.
+ *
+ * A reader thread checks every shard, starting with its own affinity shard and then
+ * "stealing" from the other shards. If every shard is empty the reader blocks on a
+ * shared @c event_count, which writers notify after each push (the notification is a
+ * fence and a load when no readers are blocked).
+ *
+ * Values pushed by one writer thread (with the default affinity) are popped in FIFO
+ * order relative to each other, but there is no ordering between values pushed by
+ * different writer threads.
+ *
+ * Shutdown semantics are the same as @c wait_queue: a @c std::stop_token can be passed in
+ * to the constructor, or @c request_stop called. All shards share the same stop token.
+ * Once a stop is requested, @c wait_and_pop and @c try_pop return an empty
+ * @c std::optional.
+ *
+ * Example usage:
+ *
+ * @code
+ *   chops::sharded_wait_queue<int> wq; // std::deque container, 8 shards
+ *
+ *   // inside any number of writer threads
+ *   wq.push(42);
+ *   ...
+ *   wq.request_stop();
+ *
+ *   // inside any number of reader threads
+ *   auto rtn_val = wq.wait_and_pop(); // return type is std::optional<int>
+ *   if (!rtn_val) { // empty value, request_stop has been called
+ *     // time to exit reader thread
+ *   }
+ * @endcode
+ *
+ * @author Cliff Green
+ *
+ * @copyright (c) 2024 by Cliff Green
+ *
+ * Distributed under the Boost Software License, Version 1.0.
+ * (See accompanying file LICENSE.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+ *
+ */
+
+#ifndef SHARDED_WAIT_QUEUE_HPP_INCLUDED
+#define SHARDED_WAIT_QUEUE_HPP_INCLUDED
+
+#include <cassert> // assert
+#include <cstddef> // std::size_t
+#include <array>
+#include <atomic>
+#include <deque>
+#include <stop_token> // std::stop_source, std::stop_token, std::stop_callback
+#include <optional>
+#include <utility> // std::move, std::forward, std::index_sequence
+#include <type_traits> // for requires clauses
+
+#include "queue/wait_queue.hpp"
+#include "queue/sync_utility.hpp"
+
+namespace chops {
+
+namespace detail {
+
+// per-thread index, assigned round-robin the first time a thread calls it
+inline auto this_thread_shard_hint() noexcept
+        -> std::size_t
+{
+  static std::atomic<std::size_t> next {0u};
+  thread_local const std::size_t hint { next.fetch_add(1u, std::memory_order_relaxed) };
+  return hint;
+}
+
+} // end detail namespace
+
+/**
+ * @brief Sharded MPMC wait queue with shutdown semantics.
+ *
+ * @tparam T Type of value that will be passed through the queue.
+ *
+ * @tparam Container Type of container used in each @c wait_queue shard, which must be
+ * default constructible.
+ *
+ * @tparam Shards Number of @c wait_queue shards.
+ *
+ * @pre The value type must be either copy constructible or move constructible.
+ *
+ */
+template <typename T, typename Container = std::deque<T>, std::size_t Shards = 8u>
+  requires (std::is_copy_constructible_v<T> || std::is_move_constructible_v<T>) &&
+           std::is_default_constructible_v<Container> && (Shards > 0u)
+class sharded_wait_queue {
+public:
+
+  using shard_type = wait_queue<T, Container>;
+  using size_type = std::size_t;
+  using value_type = T;
+
+private:
+
+  // each shard owns its cache lines, avoiding false sharing between shard locks
+  struct alignas(cache_line_size) shard {
+    shard_type m_wq;
+    explicit shard(std::stop_token stop_tok) : m_wq(stop_tok) { }
+  };
+
+  template <std::size_t ... Is>
+  static auto make_shards(std::stop_token stop_tok, std::index_sequence<Is...>)
+        -> std::array<shard, Shards>
+  {
+    return std::array<shard, Shards> { ((void)Is, shard{stop_tok})... };
+  }
+
+  detail::stoppable_event                    m_sync;
+  std::array<shard, Shards>                  m_shards;
+
+public:
+
+  /**
+   * @brief Default construct a @c sharded_wait_queue.
+   *
+   * An internal @c stop_source is used to provide a @c std::stop_token for
+   * coordinating shutdown.
+   *
+   * @post @c empty returns @c true.
+   * @post @c stop_requested returns @c false.
+   */
+  sharded_wait_queue()
+      : m_sync(), m_shards(make_shards(m_sync.token(), std::make_index_sequence<Shards>{}))
+  {
+    assert(empty());
+    assert(!stop_requested());
+  }
+
+  /**
+   * @brief Construct a @c sharded_wait_queue with an externally provided
+   * @c std::stop_token.
+   *
+   * @param stop_tok A @c std::stop_token which can be used to shutdown queue processing.
+   *
+   * @post @c empty returns @c true.
+   */
+  sharded_wait_queue(std::stop_token stop_tok)
+      : m_sync(stop_tok), m_shards(make_shards(m_sync.token(), std::make_index_sequence<Shards>{}))
+  {
+    assert(empty());
+  }
+
+  // disallow copy or move construction of the entire object
+  sharded_wait_queue(const sharded_wait_queue&) = delete;
+  sharded_wait_queue(sharded_wait_queue&&) = delete;
+
+  // disallow copy or move assigment of the entire object
+  sharded_wait_queue& operator=(const sharded_wait_queue&) = delete;
+  sharded_wait_queue& operator=(sharded_wait_queue&&) = delete;
+
+  // modifying methods
+
+  /**
+   * @brief Request the @c sharded_wait_queue to stop processing, unless a
+   * @c std::stop_token was passed in to a constructor.
+   *
+   * @return @c true if an internal @c stop_source was used and the request returns
+   * @c true, @c false if an external @c std::stop_token was passed in.
+   */
+  auto request_stop() noexcept
+        -> bool
+  {
+    return m_sync.request_stop();
+  }
+
+  /**
+   * @brief Push a value, by copying, to the shard assigned to the calling thread.
+   *
+   * @param val Val to copy into the queue.
+   *
+   * @return @c true if successful, @c false if the queue has been requested to stop.
+   */
+  auto push(const T& val) /* noexcept(std::is_nothrow_copy_constructible_v<T>) */
+        -> bool
+    requires supports_emplace_back<Container, const T&>
+  {
+    return emplace_push_to(detail::this_thread_shard_hint(), val);
+  }
+
+  /**
+   * @brief Push a value, either by moving or copying, to the shard assigned to the
+   * calling thread.
+   *
+   * This method has the same semantics as the other @c push, except that the value will
+   * be moved (if possible) instead of copied.
+   */
+  auto push(T&& val) /* noexcept(std::is_nothrow_move_constructible_v<T>) */
+        -> bool
+    requires supports_emplace_back<Container, T>
+  {
+    return emplace_push_to(detail::this_thread_shard_hint(), std::move(val));
+  }
+
+  /**
+   * @brief Directly construct an object in the shard assigned to the calling thread.
+   *
+   * @param args Arguments to be used in constructing an element.
+   *
+   * @return @c true if successful, @c false if the queue has been requested to stop.
+   */
+  template <typename ... Args>
+  auto emplace_push(Args &&... args) /* noexcept(std::is_nothrow_constructible_v<T, Args...>)*/
+        -> bool
+    requires supports_emplace_back<Container, Args...>
+  {
+    return emplace_push_to(detail::this_thread_shard_hint(), std::forward<Args>(args)...);
+  }
+
+  /**
+   * @brief Directly construct an object in a shard selected by a hint.
+   *
+   * This allows the caller to select the shard, for example by a hash of a key, so
+   * that all values with the same key are popped in FIFO order relative to each other.
+   *
+   * @param hint Value used to select the shard (modulo the number of shards).
+   *
+   * @param args Arguments to be used in constructing an element.
+   *
+   * @return @c true if successful, @c false if the queue has been requested to stop.
+   */
+  template <typename ... Args>
+  auto emplace_push_to(std::size_t hint, Args &&... args) /* noexcept */
+        -> bool
+    requires supports_emplace_back<Container, Args...>
+  {
+    if (!m_shards[hint % Shards].m_wq.emplace_push(std::forward<Args>(args)...)) {
+      return false;
+    }
+    m_sync.notify_one();
+    return true;
+  }
+
+  /**
+   * @brief Pop and return a value from any shard, blocking and waiting for a writer
+   * thread to push a value if every shard is empty.
+   *
+   * @return A value from the queue. If the @c std::optional is empty, the queue has been
+   * requested to be stopped.
+   */
+  [[nodiscard]] auto wait_and_pop() /* noexcept(std::is_nothrow_constructible_v<T>) */
+        -> std::optional<T>
+      requires supports_empty<Container> && supports_pop_front<Container>
+  {
+    return m_sync.wait_and_pop([this] { return try_pop(); });
+  }
+
+  /**
+   * @brief Pop and return a value from any shard if one is immediately available,
+   * otherwise return an empty @c std::optional.
+   *
+   * Shards are checked starting with the calling thread's affinity shard.
+   *
+   * @return A value from the queue or an empty @c std::optional if every shard is
+   * empty or the queue has been requested to be stopped.
+   */
+  [[nodiscard]] auto try_pop() /* noexcept(std::is_nothrow_constructible_v<T>) */
+        -> std::optional<T>
+      requires supports_empty<Container> && supports_pop_front<Container>
+  {
+    return detail::try_pop_each(detail::this_thread_shard_hint(), Shards,
+                                [this] (std::size_t idx) { return m_shards[idx].m_wq.try_pop(); });
+  }
+
+  // non-modifying methods
+
+  /**
+   * Query whether a @ request_stop method has been called on the queue.
+   *
+   * @return @c true if the @c stop_requested has been called.
+   */
+  [[nodiscard]] auto stop_requested() const noexcept
+        -> bool
+  {
+    return m_sync.stop_requested();
+  }
+
+  /**
+   * Query whether every shard is empty.
+   *
+   * @return @c true if every shard is empty (each shard is checked in turn, so the
+   * result may be out of date if other threads are pushing or popping).
+   */
+  [[nodiscard]] auto empty() const /* noexcept */
+        -> bool
+      requires supports_empty<Container>
+  {
+    for (const auto& sh : m_shards) {
+      if (!sh.m_wq.empty()) {
+        return false;
+      }
+    }
+    return true;
+  }
+
+  /**
+   * Get the number of elements in all shards.
+   *
+   * @return Total number of elements (each shard is checked in turn).
+   */
+  [[nodiscard]] auto size() const /* noexcept */
+        -> size_type
+      requires supports_size<Container>
+  {
+    size_type sz {0u};
+    for (const auto& sh : m_shards) {
+      sz += sh.m_wq.size();
+    }
+    return sz;
+  }
+
+  /**
+   * Get the number of shards.
+   *
+   * @return Number of shards, as specified by the template parameter.
+   */
+  [[nodiscard]] static constexpr auto shard_count() noexcept
+        -> size_type
+  {
+    return Shards;
+  }
+
+};
+
+} // end namespace
+
+#endif
+
@@ -0,0 +1,520 @@
+/** @file
+ *
+ * @brief Inter-process wait queue, placed in a POSIX shared memory region.
+ *
+ * A @c shm_wait_queue transfers values between processes (e.g. a producer and a
+ * consumer run in separate processes for fault isolation) without serializing them
+ * through a socket. All of the queue state, a fixed capacity ring of values plus a
+ * @c PTHREAD_PROCESS_SHARED mutex and condition variables, is placed in one region of
+ * shared memory with a fixed layout. Each process maps the region and uses the same
+ * push and pop API as @c spsc_wait_queue (@c push methods returning a @c bool, pop
+ * methods returning a @c std::optional), with any number of writers and readers in any
+ * number of processes.
+ *
+ * The value type must be trivially copyable, since values are copied byte for byte
+ * in and out of the region (pointers inside a value are not meaningful in another
+ * process). The capacity is a template parameter and must be a power of two.
+ *
+ * A region is created (and initialized) by one process with @c create, which uses
+ * @c shm_open and @c mmap, and attached by other processes with @c open. Alternatively,
+ * @c init and @c attach use caller supplied memory, for example an anonymous
+ * @c MAP_SHARED mapping created before a @c fork. The process that created a named
+ * region removes the name (@c shm_unlink) when its @c shm_wait_queue is destroyed;
+ * processes that already have the region mapped can continue to use it.
+ *
+ * A @c std::stop_source cannot be shared between processes, so shutdown is signaled
+ * through a flag in the region. @c request_stop (in any process) sets the flag and
+ * wakes up all waiting threads in all processes, after which pushes fail and pops
+ * return an empty @c std::optional, as with @c wait_queue.
+ *
+ * The mutex is robust, so if a process dies while holding the lock, the next process
+ * to lock it recovers it, and the queue remains usable. The ring indices are only
+ * updated after a value is completely copied, so the ring is always consistent.
+ *
+ * Example usage:
+ *
+ * @code
+ *   // producer process
+ *   auto wq = chops::shm_wait_queue<msg, 1024>::create("/md_feed");
+ *   if (!wq) { // creation failed, e.g. the name already exists
+ *   }
+ *   wq->wait_and_push(msg{...});
+ *
+ *   // consumer process
+ *   auto wq = chops::shm_wait_queue<msg, 1024>::open("/md_feed");
+ *   while (auto val = wq->wait_and_pop()) {
+ *     ...
+ *   }
+ * @endcode
+ *
+ * @note This header requires POSIX shared memory and process shared pthread
+ * objects, and is not available on Windows.
+ *
+ * @author Cliff Green
+ *
+ * @copyright (c) 2024 by Cliff Green
+ *
+ * Distributed under the Boost Software License, Version 1.0.
+ * (See accompanying file LICENSE.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+ *
+ */
+
+#ifndef SHM_WAIT_QUEUE_HPP_INCLUDED
+#define SHM_WAIT_QUEUE_HPP_INCLUDED
+
+#include <cassert> // assert
+#include <cstddef> // std::size_t, std::byte
+#include <cstdint> // std::uint64_t, std::uint32_t
+#include <cstring> // std::memcpy
+#include <cerrno> // EOWNERDEAD
+#include <atomic>
+#include <bit> // std::bit_cast
+#include <new> // placement new
+#include <optional>
+#include <string>
+#include <string_view>
+#include <utility> // std::exchange, std::move
+#include <type_traits> // std::is_trivially_copyable_v
+
+#include <pthread.h>
+#include <fcntl.h> // O_CREAT, O_RDWR
+#include <sys/mman.h> // shm_open, mmap
+#include <sys/stat.h> // fstat
+#include <unistd.h> // ftruncate, close
+
+namespace chops {
+
+namespace detail {
+
+// fixed layout of the shared memory region; only address free (lock-free) atomics
+// and process shared pthread objects are used, so the region can be mapped at a
+// different address in each process
+template <typename T, std::size_t N>
+struct shm_region {
+  static constexpr std::uint64_t magic_value = 0x63686f70737171ull; // "chopsqq"
+
+  std::atomic<std::uint64_t> m_magic; // set last, when the region is initialized
+  std::uint64_t              m_layout_size;
+  pthread_mutex_t            m_mut;
+  pthread_cond_t             m_data_cond;
+  pthread_cond_t             m_space_cond;
+  std::atomic<std::uint64_t> m_head; // only modified with the lock held, read without
+  std::atomic<std::uint64_t> m_tail;
+  std::atomic<std::uint32_t> m_stop;
+  alignas(T) std::byte       m_buf[N * sizeof(T)];
+};
+
+} // end detail namespace
+
+/**
+ * @brief Inter-process MPMC wait queue over POSIX shared memory.
+ *
+ * @tparam T Type of value that will be passed through the queue, which must be trivially
+ * copyable. A default constructor is not required.
+ *
+ * @tparam N Capacity of the queue, which must be a power of two.
+ *
+ */
+template <typename T, std::size_t N>
+  requires std::is_trivially_copyable_v<T> && (N > 0u) && ((N & (N - 1u)) == 0u)
+class shm_wait_queue {
+public:
+
+  using size_type = std::size_t;
+  using value_type = T;
+
+private:
+
+  using region_type = detail::shm_region<T, N>;
+
+  static_assert(std::atomic<std::uint64_t>::is_always_lock_free &&
+                std::atomic<std::uint32_t>::is_always_lock_free,
+                "shared memory atomics must be lock-free to be address free");
+
+  // raw bytes of a value, used to copy a value out of the ring without requiring a
+  // default constructor
+  struct value_bytes {
+    alignas(T) std::byte m_bytes[sizeof(T)];
+  };
+
+  class region_lock {
+  public:
+    explicit region_lock(region_type* rg) noexcept : m_rg(rg) {
+      recover(pthread_mutex_lock(&m_rg->m_mut));
+    }
+    ~region_lock() { pthread_mutex_unlock(&m_rg->m_mut); }
+    region_lock(const region_lock&) = delete;
+    region_lock& operator=(const region_lock&) = delete;
+
+    auto wait(pthread_cond_t& cond) noexcept -> void {
+      recover(pthread_cond_wait(&cond, &m_rg->m_mut));
+    }
+
+  private:
+    // the previous owner died holding the lock; the ring indices are only updated
+    // after a complete copy, so the state is consistent
+    auto recover(int rc) noexcept -> void {
+      if (rc == EOWNERDEAD) {
+        pthread_mutex_consistent(&m_rg->m_mut);
+      }
+    }
+
+    region_type* m_rg;
+  };
+
+  region_type* m_region {nullptr};
+  std::string  m_name; // non-empty if this object created (and will unlink) the name
+  bool         m_mapped {false}; // true if this object unmaps the region
+
+  shm_wait_queue(region_type* rg, std::string name, bool mapped) noexcept :
+      m_region(rg), m_name(std::move(name)), m_mapped(mapped) { }
+
+public:
+
+  /**
+   * @brief Size of the shared memory region, for callers supplying their own memory.
+   */
+  [[nodiscard]] static constexpr auto region_size() noexcept
+        -> std::size_t
+  {
+    return sizeof(region_type);
+  }
+
+  /**
+   * @brief Create and initialize a named shared memory region.
+   *
+   * @param name Shared memory object name, e.g. @c "/md_feed".
+   *
+   * @return A @c shm_wait_queue, or an empty @c std::optional if the region could
+   * not be created (e.g. the name already exists).
+   */
+  [[nodiscard]] static auto create(std::string_view name)
+        -> std::optional<shm_wait_queue>
+  {
+    std::string nm { name };
+    int fd = ::shm_open(nm.c_str(), O_CREAT | O_EXCL | O_RDWR, 0600);
+    if (fd < 0) {
+      return std::optional<shm_wait_queue> {};
+    }
+    void* mem = (::ftruncate(fd, static_cast<off_t>(region_size())) == 0) ?
+        ::mmap(nullptr, region_size(), PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0) : MAP_FAILED;
+    ::close(fd);
+    if (mem == MAP_FAILED) {
+      ::shm_unlink(nm.c_str());
+      return std::optional<shm_wait_queue> {};
+    }
+    return std::optional<shm_wait_queue> { shm_wait_queue { init_region(mem), std::move(nm), true } };
+  }
+
+  /**
+   * @brief Attach to a named shared memory region created by another process.
+   *
+   * @param name Shared memory object name, as passed to @c create.
+   *
+   * @return A @c shm_wait_queue, or an empty @c std::optional if the region does not
+   * exist, has a different layout (value type or capacity), or is not yet initialized.
+   */
+  [[nodiscard]] static auto open(std::string_view name)
+        -> std::optional<shm_wait_queue>
+  {
+    std::string nm { name };
+    int fd = ::shm_open(nm.c_str(), O_RDWR, 0600);
+    if (fd < 0) {
+      return std::optional<shm_wait_queue> {};
+    }
+    struct stat st { };
+    void* mem = (::fstat(fd, &st) == 0 && static_cast<std::size_t>(st.st_size) == region_size()) ?
+        ::mmap(nullptr, region_size(), PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0) : MAP_FAILED;
+    ::close(fd);
+    if (mem == MAP_FAILED) {
+      return std::optional<shm_wait_queue> {};
+    }
+    auto* rg = static_cast<region_type*>(mem);
+    if (!valid_region(rg)) {
+      ::munmap(mem, region_size());
+      return std::optional<shm_wait_queue> {};
+    }
+    return std::optional<shm_wait_queue> { shm_wait_queue { rg, std::string { }, true } };
+  }
+
+  /**
+   * @brief Initialize a region in caller supplied shared memory.
+   *
+   * @param mem Memory of at least @c region_size bytes, suitably aligned (e.g. the
+   * start of an @c mmap region), and not already in use by a @c shm_wait_queue.
+   *
+   * @note The memory is not unmapped by the @c shm_wait_queue.
+   */
+  [[nodiscard]] static auto init(void* mem) noexcept
+        -> shm_wait_queue
+  {
+    return shm_wait_queue { init_region(mem), std::string { }, false };
+  }
+
+  /**
+   * @brief Attach to an already initialized region in caller supplied shared memory.
+   *
+   * @return A @c shm_wait_queue, or an empty @c std::optional if the memory does not
+   * contain an initialized region with the same layout.
+   */
+  [[nodiscard]] static auto attach(void* mem) noexcept
+        -> std::optional<shm_wait_queue>
+  {
+    auto* rg = static_cast<region_type*>(mem);
+    if (!valid_region(rg)) {
+      return std::optional<shm_wait_queue> {};
+    }
+    return std::optional<shm_wait_queue> { shm_wait_queue { rg, std::string { }, false } };
+  }
+
+  shm_wait_queue(shm_wait_queue&& rhs) noexcept :
+      m_region(std::exchange(rhs.m_region, nullptr)), m_name(std::move(rhs.m_name)),
+      m_mapped(std::exchange(rhs.m_mapped, false)) {
+    rhs.m_name.clear();
+  }
+
+  shm_wait_queue& operator=(shm_wait_queue&& rhs) noexcept {
+    if (this != &rhs) {
+      release();
+      m_region = std::exchange(rhs.m_region, nullptr);
+      m_name = std::move(rhs.m_name);
+      rhs.m_name.clear();
+      m_mapped = std::exchange(rhs.m_mapped, false);
+    }
+    return *this;
+  }
+
+  shm_wait_queue(const shm_wait_queue&) = delete;
+  shm_wait_queue& operator=(const shm_wait_queue&) = delete;
+
+  /**
+   * @brief Unmap the region, and remove the name if this object created it.
+   */
+  ~shm_wait_queue() {
+    release();
+  }
+
+  /**
+   * @brief Request the queue to stop processing in all processes.
+   *
+   * All waiting reader and writer threads (in any process) are woken up.
+   *
+   * @return @c true if this call set the stop flag, @c false if it was already set.
+   */
+  auto request_stop() noexcept
+        -> bool
+  {
+    region_lock lk {m_region};
+    const bool first = m_region->m_stop.exchange(1u, std::memory_order_relaxed) == 0u;
+    pthread_cond_broadcast(&m_region->m_data_cond);
+    pthread_cond_broadcast(&m_region->m_space_cond);
+    return first;
+  }
+
+  /**
+   * @brief Push a value if there is space, without blocking.
+   *
+   * @return @c true if the value was pushed, @c false if the queue is full or has been
+   * requested to stop.
+   */
+  auto push(const T& val) noexcept
+        -> bool
+  {
+    region_lock lk {m_region};
+    if (stopped() || full_locked()) {
+      return false;
+    }
+    push_locked(val);
+    return true;
+  }
+
+  /**
+   * @brief Push a value, blocking until there is space.
+   *
+   * @return @c true if the value was pushed, @c false if the queue has been requested
+   * to stop.
+   */
+  auto wait_and_push(const T& val) noexcept
+        -> bool
+  {
+    region_lock lk {m_region};
+    while (!stopped() && full_locked()) {
+      lk.wait(m_region->m_space_cond);
+    }
+    if (stopped()) {
+      return false;
+    }
+    push_locked(val);
+    return true;
+  }
+
+  /**
+   * @brief Pop a value, blocking until one is available.
+   *
+   * @return A value, or an empty @c std::optional if the queue has been requested to
+   * stop.
+   */
+  [[nodiscard]] auto wait_and_pop() noexcept
+        -> std::optional<T>
+  {
+    region_lock lk {m_region};
+    while (!stopped() && empty_locked()) {
+      lk.wait(m_region->m_data_cond);
+    }
+    if (stopped()) {
+      return std::optional<T> {};
+    }
+    return std::optional<T> {pop_locked()};
+  }
+
+  /**
+   * @brief Pop a value if one is available, without blocking.
+   *
+   * @return A value, or an empty @c std::optional if the queue is empty or has been
+   * requested to stop.
+   */
+  [[nodiscard]] auto try_pop() noexcept
+        -> std::optional<T>
+  {
+    region_lock lk {m_region};
+    if (stopped() || empty_locked()) {
+      return std::optional<T> {};
+    }
+    return std::optional<T> {pop_locked()};
+  }
+
+  /**
+   * Query whether a @c request_stop method has been called, in any process.
+   */
+  [[nodiscard]] auto stop_requested() const noexcept
+        -> bool
+  {
+    return stopped();
+  }
+
+  /**
+   * Query whether the queue is empty, as a snapshot value.
+   */
+  [[nodiscard]] auto empty() const noexcept
+        -> bool
+  {
+    return size() == 0u;
+  }
+
+  /**
+   * Get the number of elements in the queue, as a snapshot value.
+   */
+  [[nodiscard]] auto size() const noexcept
+        -> size_type
+  {
+    const auto head = m_region->m_head.load(std::memory_order_acquire);
+    const auto tail = m_region->m_tail.load(std::memory_order_acquire);
+    // the indices are read separately, so clamp a transiently inconsistent snapshot
+    const auto cnt = (tail > head) ? static_cast<size_type>(tail - head) : 0u;
+    return (cnt < N) ? cnt : N;
+  }
+
+  /**
+   * Get the capacity of the queue.
+   *
+   * @return Capacity, as specified by the template parameter.
+   */
+  [[nodiscard]] static constexpr auto capacity() noexcept
+        -> size_type
+  {
+    return N;
+  }
+
+private:
+
+  static auto init_region(void* mem) noexcept
+        -> region_type*
+  {
+    assert(mem != nullptr);
+    auto* rg = ::new (mem) region_type;
+    rg->m_layout_size = sizeof(region_type);
+    rg->m_head.store(0u, std::memory_order_relaxed);
+    rg->m_tail.store(0u, std::memory_order_relaxed);
+    rg->m_stop.store(0u, std::memory_order_relaxed);
+
+    pthread_mutexattr_t mattr;
+    pthread_mutexattr_init(&mattr);
+    pthread_mutexattr_setpshared(&mattr, PTHREAD_PROCESS_SHARED);
+    pthread_mutexattr_setrobust(&mattr, PTHREAD_MUTEX_ROBUST);
+    pthread_mutex_init(&rg->m_mut, &mattr);
+    pthread_mutexattr_destroy(&mattr);
+
+    pthread_condattr_t cattr;
+    pthread_condattr_init(&cattr);
+    pthread_condattr_setpshared(&cattr, PTHREAD_PROCESS_SHARED);
+    pthread_cond_init(&rg->m_data_cond, &cattr);
+    pthread_cond_init(&rg->m_space_cond, &cattr);
+    pthread_condattr_destroy(&cattr);
+
+    rg->m_magic.store(region_type::magic_value, std::memory_order_release);
+    return rg;
+  }
+
+  static auto valid_region(const region_type* rg) noexcept
+        -> bool
+  {
+    return rg->m_magic.load(std::memory_order_acquire) == region_type::magic_value &&
+           rg->m_layout_size == sizeof(region_type);
+  }
+
+  auto release() noexcept
+        -> void
+  {
+    if (m_region != nullptr && m_mapped) {
+      ::munmap(m_region, region_size());
+    }
+    if (!m_name.empty()) {
+      ::shm_unlink(m_name.c_str());
+      m_name.clear();
+    }
+    m_region = nullptr;
+    m_mapped = false;
+  }
+
+  auto stopped() const noexcept
+        -> bool
+  {
+    return m_region->m_stop.load(std::memory_order_relaxed) != 0u;
+  }
+
+  // lock must be held by caller for the following methods
+  auto empty_locked() const noexcept -> bool { return size() == 0u; }
+  auto full_locked() const noexcept -> bool { return size() == N; }
+
+  auto slot(std::uint64_t idx) noexcept
+        -> std::byte*
+  {
+    return m_region->m_buf + (static_cast<std::size_t>(idx & (N - 1u)) * sizeof(T));
+  }
+
+  auto push_locked(const T& val) noexcept
+        -> void
+  {
+    const auto tail = m_region->m_tail.load(std::memory_order_relaxed);
+    std::memcpy(slot(tail), &val, sizeof(T));
+    m_region->m_tail.store(tail + 1u, std::memory_order_release);
+    pthread_cond_signal(&m_region->m_data_cond);
+  }
+
+  auto pop_locked() noexcept
+        -> T
+  {
+    const auto head = m_region->m_head.load(std::memory_order_relaxed);
+    value_bytes raw;
+    std::memcpy(raw.m_bytes, slot(head), sizeof(T));
+    m_region->m_head.store(head + 1u, std::memory_order_release);
+    pthread_cond_signal(&m_region->m_space_cond);
+    return std::bit_cast<T>(raw);
+  }
+
+};
+
+} // end namespace
+
+#endif
+
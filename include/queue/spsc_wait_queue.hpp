@@ -0,0 +1,436 @@
+/** @file
+ *
+ * @brief Lock-free single producer / single consumer (SPSC) wait queue with shutdown
+ * semantics.
+ *
+ * @c spsc_wait_queue has the same API shape as @c wait_queue (@c push methods returning
+ * a @c bool, pop methods returning a @c std::optional, @c request_stop or an external
+ * @c std::stop_token for shutdown), but is restricted to exactly one writer thread and
+ * exactly one reader thread. There is no mutex in the implementation. The writer and
+ * reader each own an atomic index into a fixed size ring of uninitialized storage, and
+ * each index is kept on its own cache line. A blocking call (@c wait_and_pop or
+ * @c wait_and_push) only waits (through an @c event_count, which uses the C++ 20
+ * atomic wait facilities, typically a futex) when the ring is actually empty (or full).
+ *
+ * The capacity is a template parameter and must be a power of two, which allows index
+ * wrap around to be computed by masking. No heap memory is allocated.
+ *
+ * Calling the @c push methods from more than one thread, or the @c pop methods from more
+ * than one thread, is undefined behavior. Use @c wait_queue for MPMC scenarios. The
+ * non-modifying methods (@c empty, @c size, @c stop_requested) can be called from any
+ * thread, with @c empty and @c size returning a snapshot value.
+ *
+ * Unlike @c wait_queue, a @c push on a full queue does not add the element (and
+ * returns @c false). @c wait_and_push blocks until space is available.
+ *
+ * Example usage:
+ *
+ * @code
+ *   chops::spsc_wait_queue<int, 1024> wq;
+ *
+ *   // inside writer thread
+ *   wq.wait_and_push(42);
+ *   ...
+ *   wq.request_stop();
+ *
+ *   // inside reader thread
+ *   auto rtn_val = wq.wait_and_pop(); // return type is std::optional<int>
+ *   if (!rtn_val) { // empty value, request_stop has been called
+ *     // time to exit reader thread
+ *   }
+ * @endcode
+ *
+ * @author Cliff Green
+ *
+ * @copyright (c) 2024 by Cliff Green
+ *
+ * Distributed under the Boost Software License, Version 1.0.
+ * (See accompanying file LICENSE.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+ *
+ */
+
+#ifndef SPSC_WAIT_QUEUE_HPP_INCLUDED
+#define SPSC_WAIT_QUEUE_HPP_INCLUDED
+
+#include <cassert> // assert
+#include <cstddef> // std::size_t, std::byte
+#include <atomic>
+#include <stop_token> // std::stop_source, std::stop_token, std::stop_callback
+#include <optional>
+#include <memory> // std::construct_at, std::destroy_at
+#include <new> // std::launder
+#include <utility> // std::move, std::move_if_noexcept, std::forward
+#include <type_traits> // for requires clauses and noexcept specs
+
+#include "queue/sync_utility.hpp"
+
+namespace chops {
+
+/**
+ * @brief Lock-free SPSC wait queue with shutdown semantics.
+ *
+ * @tparam T Type of value that will be passed through the queue.
+ *
+ * @tparam N Capacity of the queue, which must be a power of two.
+ *
+ * @pre The value type must be either copy constructible or move constructible. A default
+ * constructor is not required.
+ *
+ */
+template <typename T, std::size_t N>
+  requires (std::is_copy_constructible_v<T> || std::is_move_constructible_v<T>) &&
+           (N > 0u) && ((N & (N - 1u)) == 0u)
+class spsc_wait_queue {
+public:
+
+  using size_type = std::size_t;
+  using value_type = T;
+
+private:
+
+  struct stop_notifier {
+    spsc_wait_queue* m_wq;
+    auto operator()() noexcept -> void {
+      m_wq->m_data_ev.notify_all();
+      m_wq->m_space_ev.notify_all();
+    }
+  };
+
+  static constexpr size_type mask = N - 1u;
+
+  // reader side, m_cached_tail is only accessed by the reader thread
+  alignas(cache_line_size) std::atomic<size_type> m_head {0u};
+  size_type                                  m_cached_tail {0u};
+
+  // writer side, m_cached_head is only accessed by the writer thread
+  alignas(cache_line_size) std::atomic<size_type> m_tail {0u};
+  size_type                                  m_cached_head {0u};
+
+  alignas(cache_line_size) event_count       m_data_ev;
+  event_count                                m_space_ev;
+  std::optional<std::stop_source>            m_stop_src;
+  std::stop_token                            m_stop_tok;
+  std::stop_callback<stop_notifier>          m_stop_cb;
+
+  alignas(cache_line_size) alignas(T) std::byte m_buf[N * sizeof(T)];
+
+public:
+
+  /**
+   * @brief Default construct a @c spsc_wait_queue.
+   *
+   * An internal @c stop_source is used to provide a @c std::stop_token for
+   * coordinating shutdown.
+   *
+   * @post @c empty returns @c true.
+   * @post @c stop_requested returns @c false.
+   */
+  spsc_wait_queue()
+      : m_stop_src(std::stop_source{}), m_stop_tok((*m_stop_src).get_token()),
+        m_stop_cb(m_stop_tok, stop_notifier{this})
+  {
+    assert(empty());
+    assert(!stop_requested());
+  }
+
+  /**
+   * @brief Construct a @c spsc_wait_queue with an externally provided @c std::stop_token.
+   *
+   * @param stop_tok A @c std::stop_token which can be used to shutdown @c spsc_wait_queue
+   * processing.
+   *
+   * @post @c empty returns @c true.
+   */
+  spsc_wait_queue(std::stop_token stop_tok)
+      : m_stop_tok(stop_tok), m_stop_cb(m_stop_tok, stop_notifier{this})
+  {
+    assert(empty());
+  }
+
+  // disallow copy or move construction of the entire object
+  spsc_wait_queue(const spsc_wait_queue&) = delete;
+  spsc_wait_queue(spsc_wait_queue&&) = delete;
+
+  // disallow copy or move assigment of the entire object
+  spsc_wait_queue& operator=(const spsc_wait_queue&) = delete;
+  spsc_wait_queue& operator=(spsc_wait_queue&&) = delete;
+
+  /**
+   * @brief Destroy any elements remaining in the queue.
+   */
+  ~spsc_wait_queue() {
+    const auto tail = m_tail.load(std::memory_order_acquire);
+    for (auto head = m_head.load(std::memory_order_relaxed); head != tail; ++head) {
+      std::destroy_at(slot(head));
+    }
+  }
+
+  // modifying methods
+
+  /**
+   * @brief Request the @c spsc_wait_queue to stop processing, unless a @c std::stop_token
+   * was passed in to a constructor.
+   *
+   * For an internal @c std::stop_token, the waiting reader (and writer) thread will be
+   * notified. Subsequent @c push operations will return @c false.
+   *
+   * @return @c true if an internal @c stop_source was used and the request returns
+   * @c true, @c false if an external @c std::stop_token was passed in.
+   */
+  auto request_stop() noexcept
+        -> bool
+  {
+    if (m_stop_src) {
+      return (*m_stop_src).request_stop();
+    }
+    return false;
+  }
+
+  /**
+   * @brief Push a value, by copying, to the @c spsc_wait_queue if there is space.
+   *
+   * Must only be called from the single writer thread.
+   *
+   * @param val Val to copy into the queue.
+   *
+   * @return @c true if successful, @c false if the queue is full or has been
+   * requested to stop.
+   */
+  auto push(const T& val) /* noexcept(std::is_nothrow_copy_constructible_v<T>) */
+        -> bool
+    requires std::is_copy_constructible_v<T>
+  {
+    return emplace_push(val);
+  }
+
+  /**
+   * @brief Push a value, either by moving or copying, to the @c spsc_wait_queue
+   * if there is space.
+   *
+   * This method has the same semantics as the other @c push, except that the value will
+   * be moved (if possible) instead of copied. If @c false is returned the value has not
+   * been moved from.
+   */
+  auto push(T&& val) /* noexcept(std::is_nothrow_move_constructible_v<T>) */
+        -> bool
+  {
+    return emplace_push(std::move(val));
+  }
+
+  /**
+   * @brief Directly construct an object in the ring storage by forwarding the supplied
+   * arguments, if there is space.
+   *
+   * Must only be called from the single writer thread.
+   *
+   * @param args Arguments to be used in constructing an element at the end of the queue.
+   *
+   * @return @c true if successful, @c false if the queue is full or has been
+   * requested to stop.
+   */
+  template <typename ... Args>
+  auto emplace_push(Args &&... args) /* noexcept(std::is_nothrow_constructible_v<T, Args...>)*/
+        -> bool
+    requires std::is_constructible_v<T, Args...>
+  {
+    if (m_stop_tok.stop_requested()) {
+      return false;
+    }
+    const auto tail = m_tail.load(std::memory_order_relaxed);
+    if (!has_space(tail)) {
+      return false;
+    }
+    publish(tail, std::forward<Args>(args)...);
+    return true;
+  }
+
+  /**
+   * @brief Push a value, blocking and waiting for the reader thread to pop a value
+   * if the queue is full.
+   *
+   * Must only be called from the single writer thread.
+   *
+   * @param val Val to copy or move into the queue.
+   *
+   * @return @c true if successful, @c false if the queue has been requested to stop
+   * (including while waiting for space).
+   */
+  template <typename U>
+  auto wait_and_push(U&& val) /* noexcept(std::is_nothrow_constructible_v<T, U&&>) */
+        -> bool
+    requires std::is_constructible_v<T, U&&>
+  {
+    const auto tail = m_tail.load(std::memory_order_relaxed);
+    while (true) {
+      if (m_stop_tok.stop_requested()) {
+        return false;
+      }
+      if (has_space(tail)) {
+        break;
+      }
+      auto key = m_space_ev.prepare_wait();
+      if (has_space(tail) || m_stop_tok.stop_requested()) {
+        m_space_ev.cancel_wait();
+        continue;
+      }
+      m_space_ev.wait(key);
+    }
+    publish(tail, std::forward<U>(val));
+    return true;
+  }
+
+  /**
+   * @brief Pop and return a value from the @c spsc_wait_queue, blocking and waiting for
+   * the writer thread to push a value if one is not immediately available.
+   *
+   * Must only be called from the single reader thread.
+   *
+   * @return A value from the queue. If the @c std::optional is empty, the queue has been
+   * requested to be stopped.
+   */
+  [[nodiscard]] auto wait_and_pop() /* noexcept(std::is_nothrow_constructible_v<T>) */
+        -> std::optional<T>
+  {
+    const auto head = m_head.load(std::memory_order_relaxed);
+    while (!has_data(head)) {
+      if (m_stop_tok.stop_requested()) {
+        return std::optional<T> {};
+      }
+      auto key = m_data_ev.prepare_wait();
+      if (has_data(head) || m_stop_tok.stop_requested()) {
+        m_data_ev.cancel_wait();
+        continue;
+      }
+      m_data_ev.wait(key);
+    }
+    return consume(head);
+  }
+
+  /**
+   * @brief Pop and return a value from the @c spsc_wait_queue if an element is
+   * immediately available, otherwise return an empty @c std::optional.
+   *
+   * Must only be called from the single reader thread.
+   *
+   * @return A value from the queue or an empty @c std::optional if no values are
+   * available or if the queue has been requested to be stopped.
+   */
+  [[nodiscard]] auto try_pop() /* noexcept(std::is_nothrow_constructible_v<T>) */
+        -> std::optional<T>
+  {
+    if (m_stop_tok.stop_requested()) {
+      return std::optional<T> {};
+    }
+    const auto head = m_head.load(std::memory_order_relaxed);
+    if (!has_data(head)) {
+      return std::optional<T> {};
+    }
+    return consume(head);
+  }
+
+  // non-modifying methods
+
+  /**
+   * Query whether a @ request_stop method has been called on the @c spsc_wait_queue.
+   *
+   * @return @c true if the @c stop_requested has been called.
+   */
+  [[nodiscard]] auto stop_requested() const noexcept
+        -> bool
+  {
+    return m_stop_tok.stop_requested();
+  }
+
+  /**
+   * Query whether the @c spsc_wait_queue is empty or not.
+   *
+   * @return @c true if the queue is empty (at the time of the query).
+   */
+  [[nodiscard]] auto empty() const noexcept
+        -> bool
+  {
+    return size() == size_type(0);
+  }
+
+  /**
+   * Get the number of elements in the @c spsc_wait_queue.
+   *
+   * @return Number of elements in the queue (at the time of the query).
+   */
+  [[nodiscard]] auto size() const noexcept
+        -> size_type
+  {
+    const auto head = m_head.load(std::memory_order_acquire);
+    const auto tail = m_tail.load(std::memory_order_acquire);
+    return tail - head;
+  }
+
+  /**
+   * Get the capacity of the @c spsc_wait_queue.
+   *
+   * @return Capacity, as specified by the template parameter.
+   */
+  [[nodiscard]] static constexpr auto capacity() noexcept
+        -> size_type
+  {
+    return N;
+  }
+
+private:
+
+  auto slot(size_type idx) noexcept
+        -> T*
+  {
+    return std::launder(reinterpret_cast<T*>(m_buf + (idx & mask) * sizeof(T)));
+  }
+
+  // writer thread only
+  auto has_space(size_type tail) noexcept
+        -> bool
+  {
+    if (tail - m_cached_head < N) {
+      return true;
+    }
+    m_cached_head = m_head.load(std::memory_order_acquire);
+    return tail - m_cached_head < N;
+  }
+
+  // writer thread only
+  template <typename ... Args>
+  auto publish(size_type tail, Args&&... args)
+        -> void
+  {
+    std::construct_at(slot(tail), std::forward<Args>(args)...);
+    m_tail.store(tail + 1u, std::memory_order_release);
+    m_data_ev.notify_one();
+  }
+
+  // reader thread only
+  auto has_data(size_type head) noexcept
+        -> bool
+  {
+    if (head != m_cached_tail) {
+      return true;
+    }
+    m_cached_tail = m_tail.load(std::memory_order_acquire);
+    return head != m_cached_tail;
+  }
+
+  // reader thread only
+  auto consume(size_type head)
+        -> std::optional<T>
+  {
+    T* p = slot(head);
+    std::optional<T> val {std::move_if_noexcept(*p)}; // move construct if possible
+    std::destroy_at(p);
+    m_head.store(head + 1u, std::memory_order_release);
+    m_space_ev.notify_one();
+    return val;
+  }
+
+};
+
+} // end namespace
+
+#endif
+
@@ -0,0 +1,65 @@
+/** @file
+ *
+ * @brief Compile time fixed capacity alias for @c wait_queue, with inline storage.
+ *
+ * A @c chops::static_wait_queue<T, N> is a @c wait_queue using a @c lean_fixed_ring with
+ * the capacity as a template parameter. The storage is an inline array of uninitialized
+ * bytes within the @c wait_queue object, so there is no heap memory use at all (useful
+ * in embedded or deterministic environments), the element type does not need a default
+ * constructor, and, since the capacity is a power of two constant, index wrap around
+ * compiles to a mask.
+ *
+ * The ring has no slot reservation support, so that the container is only the element
+ * storage and two 32 bit counters, smaller than a @c jm::circular_buffer of the same
+ * capacity. The @c wait_queue bounded mode methods (@c try_push, @c wait_and_push) and
+ * in place consume methods are available. A @c push on a full queue overwrites the
+ * oldest element, as with a @c ring_span. For the @c reserve and @c commit methods use
+ * a @c wait_queue with a (reservable) @c fixed_ring.
+ *
+ * The @c wait_queue @c try_pop and @c wait_and_pop overloads taking a @c T& assign the
+ * popped value to a caller supplied object, instead of constructing a @c std::optional
+ * for every element.
+ *
+ * Example usage:
+ *
+ * @code
+ *   chops::static_wait_queue<sensor_msg, 256> wq; // no heap memory
+ *   sensor_msg msg;
+ *   while (wq.wait_and_pop(msg)) {
+ *     ...
+ *   }
+ * @endcode
+ *
+ * @author Cliff Green
+ *
+ * @copyright (c) 2024 by Cliff Green
+ *
+ * Distributed under the Boost Software License, Version 1.0.
+ * (See accompanying file LICENSE.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+ *
+ */
+
+#ifndef STATIC_WAIT_QUEUE_HPP_INCLUDED
+#define STATIC_WAIT_QUEUE_HPP_INCLUDED
+
+#include <cstddef> // std::size_t
+
+#include "queue/wait_queue.hpp"
+#include "queue/fixed_ring.hpp"
+
+namespace chops {
+
+/**
+ * @brief @c wait_queue with a compile time capacity and inline @c lean_fixed_ring storage.
+ *
+ * @tparam N Capacity, which must be a power of two.
+ */
+template <typename T, std::size_t N, wait_policy WaitPolicy = block_wait,
+          stats_policy StatsPolicy = null_stats, layout_policy LayoutPolicy = compact_layout>
+  requires (N != std::dynamic_extent)
+using static_wait_queue = wait_queue<T, lean_fixed_ring<T, N>, WaitPolicy, StatsPolicy, LayoutPolicy>;
+
+} // end namespace
+
+#endif
+
@@ -0,0 +1,311 @@
+/** @file
+ *
+ * @brief Low level synchronization utilities shared by the queue class templates.
+ *
+ * The utilities include a cache line size constant and a cache line aligning wrapper
+ * (used to keep independently written data on separate cache lines, avoiding false 
+ * sharing), a CPU "relax" hint for spin loops, and an "event count", which allows a 
+ * thread to block until notified without a mutex, in combination with a lock-free 
+ * check of some condition.
+ *
+ * An event count is used in the following manner by a waiting thread:
+ *
+ * @code
+ *   while (true) {
+ *     if (condition_is_true()) { break; }
+ *     auto key = ev.prepare_wait();
+ *     if (condition_is_true()) { ev.cancel_wait(); break; }
+ *     ev.wait(key);
+ *   }
+ * @endcode
+ *
+ * The notifying thread makes the condition true (e.g. stores an atomic index) and then
+ * calls @c notify_one or @c notify_all. A notify call is cheap (a fence and a load)
+ * when there are no waiting threads, which means the futex or OS wait facility is
+ * only used when a thread is actually blocked.
+ *
+ * The multiple sub-queue class templates (@c sharded_wait_queue, @c numa_wait_queue,
+ * and @c work_stealing_queue) share their shutdown state and reader blocking loop, an
+ * event count combined with a stop token, through @c detail::stoppable_event.
+ *
+ * The design is adapted from Dmitry Vyukov's event count, as well as the Facebook
+ * Folly @c EventCount class.
+ *
+ * @author Cliff Green
+ *
+ * @copyright (c) 2024 by Cliff Green
+ *
+ * Distributed under the Boost Software License, Version 1.0.
+ * (See accompanying file LICENSE.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+ *
+ */
+
+#ifndef SYNC_UTILITY_HPP_INCLUDED
+#define SYNC_UTILITY_HPP_INCLUDED
+
+#include <cstddef> // std::size_t
+#include <cstdint> // std::uint32_t
+#include <atomic>
+#include <new> // std::hardware_destructive_interference_size
+#include <thread> // std::this_thread::yield
+#include <stop_token> // std::stop_source, std::stop_token, std::stop_callback
+#include <optional>
+
+#if defined(_MSC_VER) && (defined(_M_X64) || defined(_M_IX86))
+#include <immintrin.h> // _mm_pause
+#endif
+
+namespace chops {
+
+/**
+ * @brief Size used for aligning data which should not share a cache line.
+ *
+ * The std library value is only used when it is considered ABI stable by the compiler
+ * (g++ and clang warn that the value may change between compiler versions or tuning
+ * flags), otherwise the common value of 64 bytes is used.
+ */
+#if defined(__cpp_lib_hardware_interference_size) && !defined(__GNUC__)
+inline constexpr std::size_t cache_line_size = std::hardware_destructive_interference_size;
+#else
+inline constexpr std::size_t cache_line_size = 64u;
+#endif
+
+/**
+ * @brief Wrapper which aligns an object (typically a queue) to a cache line boundary
+ * and pads its size to a multiple of the cache line size.
+ *
+ * No other object will share a cache line with the wrapped object, which prevents
+ * false sharing between adjacent queues (e.g. in an array) or between a queue and
+ * unrelated frequently written data. All constructors of the wrapped type are 
+ * inherited.
+ *
+ * @tparam Q Type to be wrapped.
+ */
+template <typename Q>
+struct alignas(cache_line_size) cache_aligned : public Q {
+  using Q::Q;
+};
+
+/**
+ * @brief Hint to the CPU that the calling thread is in a spin wait loop.
+ *
+ * On x86 this is the @c pause instruction, on ARM the @c yield instruction, which
+ * reduces power usage and memory order contention while spinning. On other platforms
+ * the thread yields to the OS scheduler.
+ */
+inline auto cpu_relax() noexcept
+        -> void
+{
+#if defined(_MSC_VER) && (defined(_M_X64) || defined(_M_IX86))
+  _mm_pause();
+#elif defined(__x86_64__) || defined(__i386__)
+  __builtin_ia32_pause();
+#elif defined(__aarch64__) || defined(__arm__)
+  asm volatile("yield" ::: "memory");
+#else
+  std::this_thread::yield();
+#endif
+}
+
+/**
+ * @brief Blocking wait and notify primitive for use with lock-free conditions.
+ *
+ * A waiting thread calls @c prepare_wait, re-checks the condition, then either calls
+ * @c cancel_wait (if the condition is now true) or @c wait. Without the @c prepare_wait
+ * step a notification between the condition check and the wait would be lost.
+ *
+ * All methods are @c noexcept and there is no dynamic memory allocation.
+ */
+class event_count {
+public:
+
+  using key_type = std::uint32_t;
+
+private:
+  std::atomic<key_type>      m_epoch {0u};
+  std::atomic<std::uint32_t> m_waiters {0u};
+
+public:
+
+  event_count() = default;
+
+  event_count(const event_count&) = delete;
+  event_count& operator=(const event_count&) = delete;
+
+  /**
+   * @brief Register the calling thread as a waiter, returning a key to be passed
+   * to @c wait.
+   *
+   * @return Key representing the current notification epoch.
+   */
+  [[nodiscard]] auto prepare_wait() noexcept
+        -> key_type
+  {
+    m_waiters.fetch_add(1u, std::memory_order_seq_cst);
+    return m_epoch.load(std::memory_order_seq_cst);
+  }
+
+  /**
+   * @brief Deregister the calling thread as a waiter, used when the condition
+   * became true after @c prepare_wait was called.
+   */
+  auto cancel_wait() noexcept
+        -> void
+  {
+    m_waiters.fetch_sub(1u, std::memory_order_seq_cst);
+  }
+
+  /**
+   * @brief Block until a notification has been performed after the corresponding
+   * @c prepare_wait.
+   *
+   * Spurious wakeups are possible, so the condition must be re-checked by the caller.
+   *
+   * @param key Value returned from @c prepare_wait.
+   */
+  auto wait(key_type key) noexcept
+        -> void
+  {
+    m_epoch.wait(key, std::memory_order_seq_cst);
+    m_waiters.fetch_sub(1u, std::memory_order_seq_cst);
+  }
+
+  /**
+   * @brief Wake up one waiting thread, if there are any.
+   */
+  auto notify_one() noexcept
+        -> void
+  {
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    if (m_waiters.load(std::memory_order_seq_cst) != 0u) {
+      m_epoch.fetch_add(1u, std::memory_order_seq_cst);
+      m_epoch.notify_one();
+    }
+  }
+
+  /**
+   * @brief Wake up all waiting threads, if there are any.
+   */
+  auto notify_all() noexcept
+        -> void
+  {
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    if (m_waiters.load(std::memory_order_seq_cst) != 0u) {
+      m_epoch.fetch_add(1u, std::memory_order_seq_cst);
+      m_epoch.notify_all();
+    }
+  }
+
+  /**
+   * Query whether any threads are registered as waiters.
+   *
+   * @return @c true if at least one thread has called @c prepare_wait without
+   * a corresponding @c cancel_wait or return from @c wait.
+   */
+  [[nodiscard]] auto has_waiters() const noexcept
+        -> bool
+  {
+    return m_waiters.load(std::memory_order_seq_cst) != 0u;
+  }
+
+};
+
+namespace detail {
+
+/**
+ * @brief Stop state and reader wakeup for a queue made of multiple sub-queues.
+ *
+ * Holds an internal @c std::stop_source (or an externally provided @c std::stop_token),
+ * an @c event_count notified by writers after each push to any sub-queue, and a stop
+ * callback waking all blocked readers when a stop is requested.
+ */
+class stoppable_event {
+private:
+
+  struct stop_notifier {
+    event_count* m_ev;
+    auto operator()() noexcept -> void { m_ev->notify_all(); }
+  };
+
+  std::optional<std::stop_source>      m_stop_src;
+  std::stop_token                      m_stop_tok;
+  alignas(cache_line_size) event_count m_ev;
+  std::stop_callback<stop_notifier>    m_stop_cb;
+
+public:
+
+  stoppable_event()
+      : m_stop_src(std::stop_source{}), m_stop_tok((*m_stop_src).get_token()),
+        m_stop_cb(m_stop_tok, stop_notifier{&m_ev}) { }
+
+  explicit stoppable_event(std::stop_token stop_tok)
+      : m_stop_tok(stop_tok), m_stop_cb(m_stop_tok, stop_notifier{&m_ev}) { }
+
+  stoppable_event(const stoppable_event&) = delete;
+  stoppable_event& operator=(const stoppable_event&) = delete;
+
+  // false if an external std::stop_token was passed in
+  auto request_stop() noexcept
+        -> bool
+  {
+    if (m_stop_src) {
+      return (*m_stop_src).request_stop();
+    }
+    return false;
+  }
+
+  [[nodiscard]] auto stop_requested() const noexcept -> bool { return m_stop_tok.stop_requested(); }
+
+  [[nodiscard]] auto token() const noexcept -> std::stop_token { return m_stop_tok; }
+
+  // called by a writer after a successful push to any sub-queue
+  auto notify_one() noexcept -> void { m_ev.notify_one(); }
+
+  // calls try_pop (returning a std::optional) until it returns a value, blocking on the
+  // event count in between, or returns an empty std::optional once a stop is requested
+  template <typename F>
+  auto wait_and_pop(F try_pop)
+        -> decltype(try_pop())
+  {
+    while (true) {
+      if (auto val = try_pop(); val) {
+        return val;
+      }
+      if (m_stop_tok.stop_requested()) {
+        return decltype(try_pop()) {};
+      }
+      auto key = m_ev.prepare_wait();
+      if (auto val = try_pop(); val) {
+        m_ev.cancel_wait();
+        return val;
+      }
+      if (m_stop_tok.stop_requested()) {
+        m_ev.cancel_wait();
+        return decltype(try_pop()) {};
+      }
+      m_ev.wait(key);
+    }
+  }
+
+};
+
+// calls try_pop_at (returning a std::optional) for each of count sub-queue indices from
+// start (wrapping around), a local sub-queue first and then stealing from the others
+template <typename F>
+auto try_pop_each(std::size_t start, std::size_t count, F try_pop_at)
+        -> decltype(try_pop_at(start))
+{
+  for (std::size_t i {0u}; i < count; ++i) {
+    if (auto val = try_pop_at((start + i) % count); val) {
+      return val;
+    }
+  }
+  return decltype(try_pop_at(start)) {};
+}
+
+} // end detail namespace
+
+} // end namespace
+
+#endif
+
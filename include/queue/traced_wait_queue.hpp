@@ -0,0 +1,435 @@
+/** @file
+ *
+ * @brief Latency tracing @c wait_queue, recording queue residency time in a
+ * lock-free histogram.
+ *
+ * When end-to-end latency spikes, it is useful to know whether the time went to
+ * waiting in a queue or to processing by the consumer. A @c traced_wait_queue wraps a
+ * @c wait_queue, stamping each element with a time when it is pushed. When an element
+ * is popped, the time it spent in the queue (the residency time) is recorded in a
+ * @c residency_histogram, which can be read at any time from any thread.
+ *
+ * The time source is a trace policy template parameter:
+ *
+ * - @c steady_trace, using @c std::chrono::steady_clock, recording nanoseconds.
+ *
+ * - @c tsc_trace (x86 only), reading the CPU time stamp counter, recording TSC ticks.
+ *   This is cheaper than a clock call, but the tick rate is CPU dependent.
+ *
+ * - @c no_trace, which compiles the tracing out. The element stamp is an empty type
+ *   (taking no space) and no histogram is kept, so a @c traced_wait_queue<T, no_trace>
+ *   has the same overhead as a @c wait_queue.
+ *
+ * The @c residency_histogram is log-linear (similar to an HDR histogram): values are
+ * grouped by their highest set bit, with each group split into 8 linear sub-buckets,
+ * giving a relative error of at most 12.5% over the full 64-bit range in a fixed
+ * size array. Recording is a few relaxed atomic increments, with no locking.
+ *
+ * Example usage:
+ *
+ * @code
+ *   chops::traced_wait_queue<int> wq;
+ *   // push and pop as with a wait_queue
+ *   ...
+ *   auto p99 = wq.histogram().percentile(0.99); // nanoseconds
+ * @endcode
+ *
+ * @author Cliff Green
+ *
+ * @copyright (c) 2024 by Cliff Green
+ *
+ * Distributed under the Boost Software License, Version 1.0.
+ * (See accompanying file LICENSE.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+ *
+ */
+
+#ifndef TRACED_WAIT_QUEUE_HPP_INCLUDED
+#define TRACED_WAIT_QUEUE_HPP_INCLUDED
+
+#include <cassert> // assert
+#include <cstddef> // std::size_t
+#include <cstdint> // std::uint64_t
+#include <array>
+#include <atomic>
+#include <bit> // std::bit_width
+#include <chrono>
+#include <deque>
+#include <optional>
+#include <stop_token> // std::stop_token
+#include <utility> // std::move, std::forward
+#include <type_traits> // std::conditional_t, for requires clauses
+#include <concepts> // std::convertible_to
+
+#if defined(_MSC_VER) && (defined(_M_X64) || defined(_M_IX86))
+#include <intrin.h> // __rdtsc
+#endif
+
+#include "queue/wait_queue.hpp"
+
+namespace chops {
+
+/**
+ * @brief Lock-free log-linear histogram of 64-bit values.
+ *
+ * Any number of threads can record values and read the histogram concurrently; a read
+ * that overlaps recording may see a partially updated histogram.
+ */
+class residency_histogram {
+public:
+
+  static constexpr std::size_t sub_bits = 3u;
+  static constexpr std::size_t sub_buckets = std::size_t{1u} << sub_bits;
+  static constexpr std::size_t num_buckets = (64u - sub_bits + 1u) * sub_buckets;
+
+private:
+
+  std::array<std::atomic<std::uint64_t>, num_buckets> m_buckets { };
+  std::atomic<std::uint64_t> m_count {0u};
+  std::atomic<std::uint64_t> m_sum {0u};
+  std::atomic<std::uint64_t> m_max {0u};
+
+public:
+
+  residency_histogram() = default;
+
+  residency_histogram(const residency_histogram&) = delete;
+  residency_histogram& operator=(const residency_histogram&) = delete;
+
+  /**
+   * @brief Bucket index for a value.
+   */
+  [[nodiscard]] static constexpr auto bucket_index(std::uint64_t val) noexcept
+        -> std::size_t
+  {
+    if (val < sub_buckets) {
+      return static_cast<std::size_t>(val);
+    }
+    const std::size_t msb = static_cast<std::size_t>(std::bit_width(val)) - 1u;
+    const std::size_t shift = msb - sub_bits;
+    return ((shift + 1u) * sub_buckets) + static_cast<std::size_t>((val >> shift) & (sub_buckets - 1u));
+  }
+
+  /**
+   * @brief Highest value recorded in a bucket.
+   */
+  [[nodiscard]] static constexpr auto bucket_upper(std::size_t idx) noexcept
+        -> std::uint64_t
+  {
+    assert(idx < num_buckets);
+    if (idx < sub_buckets) {
+      return idx;
+    }
+    const std::size_t shift = (idx / sub_buckets) - 1u;
+    const std::uint64_t low = (std::uint64_t{sub_buckets} | (idx % sub_buckets)) << shift;
+    return low + ((std::uint64_t{1u} << shift) - 1u);
+  }
+
+  /**
+   * @brief Record a value.
+   */
+  auto record(std::uint64_t val) noexcept
+        -> void
+  {
+    m_buckets[bucket_index(val)].fetch_add(1u, std::memory_order_relaxed);
+    m_count.fetch_add(1u, std::memory_order_relaxed);
+    m_sum.fetch_add(val, std::memory_order_relaxed);
+    auto old = m_max.load(std::memory_order_relaxed);
+    while (val > old && !m_max.compare_exchange_weak(old, val, std::memory_order_relaxed)) {
+      ;
+    }
+  }
+
+  /**
+   * @brief Value at or below which the requested fraction of recorded values lie, as
+   * the upper bound of the containing bucket.
+   *
+   * @param fraction Fraction between 0.0 and 1.0, e.g. 0.99 for the 99th percentile.
+   *
+   * @return Percentile value, 0 if no values have been recorded.
+   */
+  [[nodiscard]] auto percentile(double fraction) const noexcept
+        -> std::uint64_t
+  {
+    assert(fraction >= 0.0 && fraction <= 1.0);
+    const auto cnt = count();
+    if (cnt == 0u) {
+      return 0u;
+    }
+    auto target = static_cast<std::uint64_t>(fraction * static_cast<double>(cnt));
+    target = (target == 0u) ? 1u : target;
+    std::uint64_t seen {0u};
+    for (std::size_t i {0u}; i < num_buckets; ++i) {
+      seen += m_buckets[i].load(std::memory_order_relaxed);
+      if (seen >= target) {
+        const auto upper = bucket_upper(i);
+        return (upper < max()) ? upper : max();
+      }
+    }
+    return max();
+  }
+
+  /**
+   * @brief Number of values recorded in a bucket.
+   */
+  [[nodiscard]] auto bucket_count(std::size_t idx) const noexcept
+        -> std::uint64_t
+  {
+    assert(idx < num_buckets);
+    return m_buckets[idx].load(std::memory_order_relaxed);
+  }
+
+  [[nodiscard]] auto count() const noexcept -> std::uint64_t { return m_count.load(std::memory_order_relaxed); }
+  [[nodiscard]] auto max() const noexcept -> std::uint64_t { return m_max.load(std::memory_order_relaxed); }
+
+  [[nodiscard]] auto mean() const noexcept
+        -> double
+  {
+    const auto cnt = count();
+    return (cnt == 0u) ? 0.0 : static_cast<double>(m_sum.load(std::memory_order_relaxed)) /
+                               static_cast<double>(cnt);
+  }
+
+  /**
+   * @brief Reset all counts to 0.
+   *
+   * @note Values recorded concurrently with a reset may be partially lost.
+   */
+  auto reset() noexcept
+        -> void
+  {
+    for (auto& b : m_buckets) {
+      b.store(0u, std::memory_order_relaxed);
+    }
+    m_count.store(0u, std::memory_order_relaxed);
+    m_sum.store(0u, std::memory_order_relaxed);
+    m_max.store(0u, std::memory_order_relaxed);
+  }
+
+};
+
+// requirements for traced_wait_queue trace policy
+
+template <typename P>
+concept trace_policy = requires (typename P::stamp_type stamp) {
+  { P::enabled } -> std::convertible_to<bool>;
+  { P::now() } -> std::convertible_to<typename P::stamp_type>;
+  { P::elapsed(stamp) } -> std::convertible_to<std::uint64_t>;
+};
+
+/**
+ * @brief Trace policy using @c std::chrono::steady_clock, recording nanoseconds.
+ */
+struct steady_trace {
+  static constexpr bool enabled = true;
+  using stamp_type = std::chrono::steady_clock::time_point;
+  static auto now() noexcept -> stamp_type { return std::chrono::steady_clock::now(); }
+  static auto elapsed(stamp_type start) noexcept -> std::uint64_t {
+    return static_cast<std::uint64_t>(
+      std::chrono::duration_cast<std::chrono::nanoseconds>(now() - start).count());
+  }
+};
+
+#if defined(__x86_64__) || defined(__i386__) || defined(_M_X64) || defined(_M_IX86)
+/**
+ * @brief Trace policy reading the x86 time stamp counter, recording TSC ticks.
+ */
+struct tsc_trace {
+  static constexpr bool enabled = true;
+  using stamp_type = std::uint64_t;
+  static auto now() noexcept -> stamp_type {
+#if defined(_MSC_VER)
+    return __rdtsc();
+#else
+    return __builtin_ia32_rdtsc();
+#endif
+  }
+  static auto elapsed(stamp_type start) noexcept -> std::uint64_t {
+    const auto cur = now();
+    return (cur > start) ? (cur - start) : 0u; // TSC may differ slightly between cores
+  }
+};
+#endif
+
+/**
+ * @brief Trace policy compiling the tracing out.
+ */
+struct no_trace {
+  static constexpr bool enabled = false;
+  struct stamp_type { };
+  static auto now() noexcept -> stamp_type { return stamp_type { }; }
+  static auto elapsed(stamp_type) noexcept -> std::uint64_t { return 0u; }
+};
+
+/**
+ * @brief Element stored in a @c traced_wait_queue container, a value plus the push
+ * time stamp.
+ */
+template <typename T, typename Stamp>
+struct traced_element {
+  T                           m_val;
+  [[no_unique_address]] Stamp m_stamp;
+
+  template <typename ... Args>
+  explicit traced_element(Stamp stamp, Args&&... args) :
+      m_val(std::forward<Args>(args)...), m_stamp(stamp) { }
+};
+
+/**
+ * @brief @c wait_queue wrapper recording the queue residency time of each element.
+ *
+ * @tparam T Type of element.
+ *
+ * @tparam TracePolicy @c steady_trace (the default), @c tsc_trace or @c no_trace.
+ *
+ * @tparam Container Container of @c traced_element objects.
+ *
+ * @tparam WaitPolicy Reader wait policy, as in @c wait_queue.
+ *
+ */
+template <typename T, trace_policy TracePolicy = steady_trace,
+          typename Container = std::deque<traced_element<T, typename TracePolicy::stamp_type>>,
+          wait_policy WaitPolicy = block_wait>
+class traced_wait_queue {
+public:
+
+  using element_type = traced_element<T, typename TracePolicy::stamp_type>;
+  using queue_type = wait_queue<element_type, Container, WaitPolicy>;
+  using size_type = typename queue_type::size_type;
+  using value_type = T;
+
+private:
+
+  struct no_histogram { };
+
+  queue_type m_wq;
+  [[no_unique_address]]
+    std::conditional_t<TracePolicy::enabled, residency_histogram, no_histogram> m_hist;
+
+public:
+
+  /**
+   * @brief Default construct a @c traced_wait_queue, with an internal @c stop_source.
+   */
+  traced_wait_queue() = default;
+
+  /**
+   * @brief Construct a @c traced_wait_queue with an externally provided
+   * @c std::stop_token.
+   */
+  explicit traced_wait_queue(std::stop_token stop_tok) : m_wq(stop_tok) { }
+
+  // disallow copy or move construction or assignment of the entire object
+  traced_wait_queue(const traced_wait_queue&) = delete;
+  traced_wait_queue(traced_wait_queue&&) = delete;
+  traced_wait_queue& operator=(const traced_wait_queue&) = delete;
+  traced_wait_queue& operator=(traced_wait_queue&&) = delete;
+
+  /**
+   * @brief Request the @c traced_wait_queue to stop processing, see @c wait_queue.
+   */
+  auto request_stop() noexcept -> bool { return m_wq.request_stop(); }
+
+  /**
+   * @brief Close the @c traced_wait_queue, readers drain the remaining values, see
+   * @c wait_queue.
+   */
+  auto close() -> bool { return m_wq.close(); }
+
+  /**
+   * @brief Push a value, stamped with the current time.
+   *
+   * @return @c true if successful, @c false if the queue has been requested to stop.
+   */
+  auto push(const T& val)
+        -> bool
+      requires std::is_copy_constructible_v<T>
+  {
+    return m_wq.emplace_push(TracePolicy::now(), val);
+  }
+
+  auto push(T&& val)
+        -> bool
+      requires std::is_move_constructible_v<T>
+  {
+    return m_wq.emplace_push(TracePolicy::now(), std::move(val));
+  }
+
+  /**
+   * @brief Construct a value in place, stamped with the current time.
+   *
+   * @return @c true if successful, @c false if the queue has been requested to stop.
+   */
+  template <typename ... Args>
+  auto emplace_push(Args&&... args)
+        -> bool
+      requires std::is_constructible_v<T, Args...>
+  {
+    return m_wq.emplace_push(TracePolicy::now(), std::forward<Args>(args)...);
+  }
+
+  /**
+   * @brief Pop a value, blocking until one is available, recording its residency time.
+   *
+   * @return A value, or an empty @c std::optional if the queue has been requested
+   * to stop.
+   */
+  [[nodiscard]] auto wait_and_pop()
+        -> std::optional<T>
+  {
+    return unwrap(m_wq.wait_and_pop());
+  }
+
+  /**
+   * @brief Pop a value if one is available, recording its residency time.
+   *
+   * @return A value, or an empty @c std::optional if the queue is empty or has been
+   * requested to stop.
+   */
+  [[nodiscard]] auto try_pop()
+        -> std::optional<T>
+  {
+    return unwrap(m_wq.try_pop());
+  }
+
+  /**
+   * @brief Access the residency histogram, in nanoseconds for @c steady_trace or
+   * TSC ticks for @c tsc_trace.
+   */
+  [[nodiscard]] auto histogram() noexcept
+        -> residency_histogram&
+      requires TracePolicy::enabled
+  {
+    return m_hist;
+  }
+
+  [[nodiscard]] auto histogram() const noexcept
+        -> const residency_histogram&
+      requires TracePolicy::enabled
+  {
+    return m_hist;
+  }
+
+  [[nodiscard]] auto stop_requested() const noexcept -> bool { return m_wq.stop_requested(); }
+  [[nodiscard]] auto empty() const -> bool { return m_wq.empty(); }
+  [[nodiscard]] auto size() const -> size_type { return m_wq.size(); }
+
+private:
+
+  auto unwrap(std::optional<element_type>&& elem)
+        -> std::optional<T>
+  {
+    if (!elem) {
+      return std::optional<T> {};
+    }
+    if constexpr (TracePolicy::enabled) {
+      m_hist.record(TracePolicy::elapsed(elem->m_stamp));
+    }
+    return std::optional<T> { std::move(elem->m_val) };
+  }
+
+};
+
+} // end namespace
+
+#endif
+
@@ -0,0 +1,309 @@
+/** @file
+ *
+ * @brief Wait on multiple @c wait_queue objects with one blocking call.
+ *
+ * A @c wait_queue reader blocks on the internal condition variable of one queue, so a
+ * thread reading from several queues (e.g. control, data and timer queues) otherwise
+ * needs either a thread per queue or a polling loop of @c try_pop calls. A
+ * @c queue_select attaches one @c event_count to each of its queues (through the
+ * @c wait_queue @c set_notifier method). Every push to any of the queues signals the
+ * @c event_count, and a thread blocked in @c queue_select::wait_any wakes up and pops
+ * from a queue with data.
+ *
+ * The popped value is returned in a @c std::variant, where the variant index is the
+ * index of the queue the value was popped from (the variant may contain the same type
+ * more than once). The queues are checked in index order (@c select_order::priority,
+ * the default, where a lower index queue is always popped first) or starting from the
+ * queue after the last popped one (@c select_order::round_robin, so that a busy queue
+ * cannot starve the others).
+ *
+ * An empty @c std::optional (end of stream) is returned when each of the queues has
+ * been requested to stop or has been closed and drained (see @c wait_queue::close), or
+ * when the (optional) @c std::stop_token passed to @c wait_any is requested to stop.
+ *
+ * Example usage:
+ *
+ * @code
+ *   chops::wait_queue<ctl_msg> ctl_q;
+ *   chops::wait_queue<data_msg> data_q;
+ *   chops::queue_select sel { ctl_q, data_q };
+ *   while (auto val = sel.wait_any()) {
+ *     if (val->index() == 0u) { handle_ctl(std::get<0>(*val)); }
+ *     else { handle_data(std::get<1>(*val)); }
+ *   }
+ *
+ *   // or without a long lived queue_select object
+ *   auto val = chops::wait_any(ctl_q, data_q);
+ * @endcode
+ *
+ * @note Each queue can be attached to one @c queue_select at a time. Multiple threads
+ * can call @c wait_any on the same @c queue_select object.
+ *
+ * @author Cliff Green
+ *
+ * @copyright (c) 2024 by Cliff Green
+ *
+ * Distributed under the Boost Software License, Version 1.0.
+ * (See accompanying file LICENSE.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+ *
+ */
+
+#ifndef WAIT_ANY_HPP_INCLUDED
+#define WAIT_ANY_HPP_INCLUDED
+
+#include <cstddef> // std::size_t
+#include <tuple>
+#include <variant>
+#include <optional>
+#include <atomic>
+#include <stop_token> // std::stop_token, std::stop_callback
+#include <utility> // std::index_sequence, std::in_place_index, std::move
+#include <concepts> // std::same_as, std::convertible_to
+
+#include "queue/sync_utility.hpp" // event_count
+#include "queue/wait_queue.hpp"
+
+namespace chops {
+
+/**
+ * @brief Order in which @c queue_select checks its queues.
+ */
+enum class select_order { priority, round_robin };
+
+/**
+ * @brief Requirements for a queue used with @c queue_select.
+ */
+template <typename Q>
+concept selectable_queue = requires (Q q, event_count* ev) {
+  typename Q::value_type;
+  { q.try_pop() } -> std::same_as<std::optional<typename Q::value_type>>;
+  { q.stop_requested() } -> std::convertible_to<bool>;
+  { q.closed() } -> std::convertible_to<bool>;
+  { q.empty() } -> std::convertible_to<bool>;
+  q.set_notifier(ev);
+};
+
+/**
+ * @brief Select (wait on) a set of queues, popping from whichever queue has data.
+ *
+ * @tparam Qs Queue types, each a @c wait_queue instantiation.
+ *
+ */
+template <typename ... Qs>
+  requires (sizeof...(Qs) > 0u) && (selectable_queue<Qs> && ...)
+class queue_select {
+public:
+
+  using result_type = std::variant<typename Qs::value_type...>;
+
+private:
+
+  static constexpr std::size_t num_queues = sizeof...(Qs);
+
+  struct stop_notifier {
+    event_count* m_ev;
+    auto operator()() noexcept -> void { m_ev->notify_all(); }
+  };
+
+  std::tuple<Qs&...>       m_queues;
+  select_order             m_order;
+  std::atomic<std::size_t> m_next {0u}; // round robin starting index
+  event_count              m_ev;
+
+public:
+
+  /**
+   * @brief Attach to each of the queues.
+   *
+   * @param qs Queues to select on.
+   *
+   * @pre None of the queues is attached to another @c queue_select.
+   */
+  explicit queue_select(Qs&... qs) : queue_select(select_order::priority, qs...) { }
+
+  /**
+   * @brief Attach to each of the queues, specifying the order in which the queues are
+   * checked.
+   *
+   * @param order @c select_order::priority or @c select_order::round_robin.
+   *
+   * @param qs Queues to select on.
+   */
+  queue_select(select_order order, Qs&... qs) : m_queues(qs...), m_order(order) {
+    std::apply([this] (auto&... q) { (q.set_notifier(&m_ev), ...); }, m_queues);
+  }
+
+  /**
+   * @brief Detach from each of the queues.
+   */
+  ~queue_select() {
+    std::apply([] (auto&... q) { (q.set_notifier(nullptr), ...); }, m_queues);
+  }
+
+  queue_select(const queue_select&) = delete;
+  queue_select(queue_select&&) = delete;
+  queue_select& operator=(const queue_select&) = delete;
+  queue_select& operator=(queue_select&&) = delete;
+
+  /**
+   * @brief Pop a value from the first queue (in the select order) with data, without
+   * blocking.
+   *
+   * @return The popped value, with the variant index the queue index, or an empty
+   * @c std::optional if no queue has data.
+   */
+  [[nodiscard]] auto try_any()
+        -> std::optional<result_type>
+  {
+    const std::size_t start = (m_order == select_order::round_robin) ?
+                 m_next.load(std::memory_order_relaxed) : 0u;
+    for (std::size_t i {0u}; i < num_queues; ++i) {
+      const std::size_t idx = (start + i) % num_queues;
+      auto res = try_at(idx, std::make_index_sequence<num_queues>{});
+      if (res) {
+        if (m_order == select_order::round_robin) {
+          m_next.store((idx + 1u) % num_queues, std::memory_order_relaxed);
+        }
+        return res;
+      }
+    }
+    return std::optional<result_type> {};
+  }
+
+  /**
+   * @brief Pop a value from a queue with data, blocking until a value is pushed to any
+   * of the queues.
+   *
+   * @return The popped value, with the variant index the queue index, or an empty
+   * @c std::optional if each of the queues has been requested to stop or has been
+   * closed and drained.
+   */
+  [[nodiscard]] auto wait_any()
+        -> std::optional<result_type>
+  {
+    return wait_any(std::stop_token { });
+  }
+
+  /**
+   * @brief Pop a value from a queue with data, blocking until a value is pushed to any
+   * of the queues or a stop is requested.
+   *
+   * @param stop_tok Combined stop token, for example shared by a set of gateway threads.
+   *
+   * @return The popped value, with the variant index the queue index, or an empty
+   * @c std::optional if @c stop_tok has been requested to stop, or each of the queues
+   * has been requested to stop or has been closed and drained.
+   */
+  [[nodiscard]] auto wait_any(std::stop_token stop_tok)
+        -> std::optional<result_type>
+  {
+    std::stop_callback<stop_notifier> cb { stop_tok, stop_notifier{&m_ev} };
+    while (true) {
+      if (stop_tok.stop_requested() || all_done()) {
+        return std::optional<result_type> {};
+      }
+      if (auto res = try_any()) {
+        return res;
+      }
+      auto key = m_ev.prepare_wait();
+      if (stop_tok.stop_requested() || all_done()) {
+        m_ev.cancel_wait();
+        return std::optional<result_type> {};
+      }
+      if (auto res = try_any()) {
+        m_ev.cancel_wait();
+        return res;
+      }
+      m_ev.wait(key);
+    }
+  }
+
+  /**
+   * @brief Query whether all of the queues have been requested to stop.
+   */
+  [[nodiscard]] auto all_stopped() const noexcept
+        -> bool
+  {
+    return std::apply([] (const auto&... q) { return (q.stop_requested() && ...); }, m_queues);
+  }
+
+  /**
+   * @brief Query whether there will be no more values from any of the queues, each
+   * queue having been requested to stop or closed and drained.
+   */
+  [[nodiscard]] auto all_done() const /* noexcept */
+        -> bool
+  {
+    // a closed queue accepts no more pushes, so once empty it stays empty
+    return std::apply([] (const auto&... q) {
+        return ((q.stop_requested() || (q.closed() && q.empty())) && ...);
+      }, m_queues);
+  }
+
+  /**
+   * Get the number of queues.
+   */
+  [[nodiscard]] static constexpr auto size() noexcept
+        -> std::size_t
+  {
+    return num_queues;
+  }
+
+private:
+
+  template <std::size_t I>
+  auto try_one(std::optional<result_type>& res)
+        -> void
+  {
+    if (auto val = std::get<I>(m_queues).try_pop()) {
+      res.emplace(std::in_place_index<I>, std::move(*val));
+    }
+  }
+
+  template <std::size_t ... Is>
+  auto try_at(std::size_t idx, std::index_sequence<Is...>)
+        -> std::optional<result_type>
+  {
+    std::optional<result_type> res;
+    ((Is == idx ? try_one<Is>(res) : void()), ...);
+    return res;
+  }
+
+};
+
+/**
+ * @brief Pop a value from whichever of the queues first has data, blocking until a value
+ * is available or each of the queues has been requested to stop or closed and drained.
+ *
+ * A temporary @c queue_select is attached to the queues for the duration of the call.
+ *
+ * @return See @c queue_select::wait_any.
+ */
+template <typename ... Qs>
+  requires (sizeof...(Qs) > 0u) && (selectable_queue<Qs> && ...)
+[[nodiscard]] auto wait_any(Qs&... qs)
+        -> std::optional<typename queue_select<Qs...>::result_type>
+{
+  queue_select<Qs...> sel { qs... };
+  return sel.wait_any();
+}
+
+/**
+ * @brief Pop a value from whichever of the queues first has data, blocking until a value
+ * is available or a stop is requested.
+ *
+ * @return See @c queue_select::wait_any.
+ */
+template <typename ... Qs>
+  requires (sizeof...(Qs) > 0u) && (selectable_queue<Qs> && ...)
+[[nodiscard]] auto wait_any(std::stop_token stop_tok, Qs&... qs)
+        -> std::optional<typename queue_select<Qs...>::result_type>
+{
+  queue_select<Qs...> sel { qs... };
+  return sel.wait_any(stop_tok);
+}
+
+} // end namespace
+
+#endif
+
@@ -36,6 +36,11 @@
  *   directly owning the container, so there are differences in construction and
  *   container management.
  *
+ * - Provides its own owning ring buffer container, @c fixed_ring (in @c fixed_ring.hpp),
+ *   with the capacity specified either as a template parameter (storage inside the
+ *   @c wait_queue object) or at construction (storage allocated once). The element type
+ *   does not need to be default constructible.
+ *
  * - Does not throw or catch exceptions anywhere in its code base. If a value being pushed
  *   on to the queue throws an exception, it can be caught by the pushing code (or higher
  *   up in the call chain). Exceptions may be thrown by C++ std library concurrency calls 
@@ -72,6 +77,97 @@
  * requested. For the @c try_pop method, if the return value is not present it means either 
  * the queue was empty at that moment, or that a shutdown was requested.
  *
+ * If the container type supports a @c full method (e.g. a ring buffer or circular
+ * buffer), the @c wait_queue can be used in a bounded mode. The @c push methods keep 
+ * the semantics of the underlying container (a @c ring_span overwrites the oldest element
+ * when full), while the @c wait_and_push methods block the writer thread until space 
+ * is available and the @c try_push methods immediately fail if the container is full. 
+ * This provides back-pressure to writers when readers fall behind, without losing data
+ * and without unbounded memory growth.
+ *
+ * The way reader threads wait for data is customizable through a wait policy template
+ * parameter. The default @c block_wait immediately blocks on the condition variable 
+ * (an OS sleep and wake up, typically a futex). @c spin_then_block_wait spins (checking 
+ * for data, with a CPU relax hint) a fixed number of times before blocking, and 
+ * @c busy_poll_wait never blocks. Spinning trades CPU usage for lower wake up latency, 
+ * which matters for latency critical readers. 
+ *
+ * Timed versions of @c wait_and_pop are available (@c wait_and_pop_for and 
+ * @c wait_and_pop_until). These return a @c timed_pop_result, which distinguishes
+ * between a timeout and a shutdown request (a @c std::optional by itself cannot), 
+ * allowing reader threads to periodically wake up for other processing without polling.
+ *
+ * Bulk versions of push and pop are available (@c push_range, @c wait_and_pop_many,
+ * @c try_pop_many). These transfer a batch of elements while acquiring the internal
+ * lock only once, and (for the push) notify reader threads only once, which amortizes 
+ * the locking and notification cost when data arrives in bursts.
+ * A @c producer_handle buffers pushes from one producer thread and flushes them with
+ * @c push_range when a batch size is reached, after a maximum delay (checked on each
+ * push and by @c flush_if_due), or on destruction, so that producers pushing many small values do not have to hand-roll their own
+ * buffering.
+ *
+ * All of the elements in the queue can be removed at once with the @c drain and
+ * @c wait_and_drain methods. For containers that are default constructible and 
+ * swappable, the internal container is swapped out under the lock (an O(1) operation 
+ * for most containers), optionally with a caller supplied (e.g. pre-reserved) container. 
+ * For other containers (such as @c ring_span) the elements are moved to an output 
+ * iterator while the lock is held once.
+ *
+ * Elements can be consumed in place, without moving them out of the container, with
+ * the @c try_consume and @c wait_and_consume methods, which invoke a function object on
+ * the front element (under the lock) and then pop it. For containers with contiguous
+ * storage such as @c fixed_ring, @c try_consume_span and @c wait_and_consume_span hand
+ * the function object a @c std::span of the front elements.
+ *
+ * A specific element can be removed with @c try_pop_if and @c wait_and_pop_if, which
+ * search for the first element matching a predicate and erase it in one critical 
+ * section (for containers supporting @c erase, such as @c std::deque), without 
+ * reordering the remaining elements.
+ *
+ * Writers can also push in two phases with @c reserve (or @c try_reserve) and
+ * @c commit, for containers such as @c fixed_ring. Slots are reserved under the lock,
+ * elements are constructed directly in the container storage without the lock held,
+ * and then committed (published and readers notified) under the lock.
+ *
+ * The @c empty and @c size methods acquire the internal lock. For monitoring or load
+ * balancing (e.g. picking the shortest of many queues), @c approx_empty and
+ * @c approx_size read an atomic element count without locking. The count is updated 
+ * inside the lock protected sections that change the container, so the result is 
+ * exact at some recent point in time but may be stale when used. The same count lets
+ * spinning readers (@c spin_then_block_wait and @c busy_poll_wait) wait for data 
+ * without repeatedly trying the lock.
+ *
+ * A @c request_stop makes blocking pops return immediately, dropping any values still
+ * in the queue. For a lossless shutdown, @c close rejects further pushes while readers
+ * continue to pop (or drain) the remaining values, with the blocking pops returning an
+ * empty result (end of stream) only once the queue is empty.
+ *
+ * Coroutines can pop (and, in bounded mode, push) without blocking a thread, using 
+ * @c co_await with the @c async_pop and @c async_push methods. A suspended coroutine 
+ * is kept in an intrusive list within the @c wait_queue and is resumed directly by a 
+ * writer (or reader) thread, or posted to a user supplied executor. A stop request 
+ * resumes all suspended coroutines.
+ *
+ * Instrumentation counters (pushes, pops, pushes rejected after a stop request or a
+ * @c close, high water depth, and reader blocked time) are enabled with the @c atomic_stats policy 
+ * template parameter. The counters are kept in relaxed atomics and read without the 
+ * internal lock through the @c stats method. The default @c null_stats policy has no
+ * overhead.
+ *
+ * An allocator (or a @c std::pmr::memory_resource, for a @c std::pmr::deque container)
+ * can be passed in through the constructors. A pooling memory resource makes steady 
+ * state pushes and pops free of general purpose heap allocation, while still allowing 
+ * the queue to grow (which a fixed size container cannot do). A @c chops::pmr::wait_queue 
+ * alias is provided in @c pmr_wait_queue.hpp.
+ *
+ * By default the internal data members are packed together. With the @c padded_layout 
+ * policy template parameter they are laid out so that the read-mostly stop state, the 
+ * lock protected state, and the reader and writer blocking state are on separate cache 
+ * lines. Placing multiple @c wait_queue objects next to each other (or next to other
+ * frequently written data) can result in false sharing at the object boundaries, 
+ * which the @c cache_aligned wrapper and @c queue_array class template (in 
+ * @c queue_array.hpp) prevent, with either layout.
+ *
  * A @c std::stop_token can be passed in through the constructors, which allows
  * aa external @c std::stop_source to @c request_stop. Alternatively, an
  * internal @c stop_token will be used, allowing the @c wait_queue 
@@ -110,11 +206,18 @@
  *   // push and pop same as code with default container
  * @endcode
  *
+ * Example usage with the library provided @c fixed_ring:
+ *
+ * @code
+ *   chops::wait_queue<int, chops::fixed_ring<int, 32> > wq;
+ * @endcode
+ *
  * The container type must support the following (depending on which 
  * methods are called): default construction, construction with an initial size, 
  * @c push_back (preferably overloaded for both copy and move semantics), 
  * @c emplace_back (with a template parameter pack), @c front, @c pop_front, 
- * @c empty, and @c size. The container must also have a @c size_type
+ * @c empty, and @c size (plus @c full for the bounded @c try_push and @c wait_and_push 
+ * methods). The container must also have a @c size_type
  * defined. Type constraints and concepts are defined for the various
  * type requirements.
  *
@@ -153,14 +256,27 @@
 #define WAIT_QUEUE_HPP_INCLUDED
 
 #include <cassert> // assert
+#include <cstddef> // std::size_t
 #include <deque>
+#include <vector> // std::vector, for producer_handle
 #include <mutex> // std::scoped_lock, std::mutex
 #include <condition_variable>
 #include <stop_token> // std::stop_source, std::stop_token
 #include <optional>
-#include <utility> // std::move, std::move_if_noexcept, std::forward
+#include <utility> // std::move, std::move_if_noexcept, std::forward, std::as_const
 #include <type_traits> // for requires clauses and noexcept specs
-// #include <concepts> 
+#include <memory> // std::construct_at
+#include <iterator> // std::input_iterator, std::output_iterator, std::make_move_iterator
+#include <ranges> // std::ranges::input_range, std::ranges::begin, std::ranges::end
+#include <chrono> // std::chrono::time_point, std::chrono::duration, std::chrono::steady_clock
+#include <concepts> // std::convertible_to, std::same_as, std::swappable
+#include <limits> // std::numeric_limits
+#include <cstdint> // std::uint64_t
+#include <atomic> // std::atomic, for atomic_stats and approx_size
+#include <coroutine> // std::coroutine_handle, for async_pop and async_push
+#include <span> // std::span, for try_consume_span and wait_and_consume_span
+
+#include "queue/sync_utility.hpp" // cpu_relax
 
 namespace chops {
 
@@ -191,6 +307,329 @@ concept supports_size = requires (Ctr ctr) {
   ctr.size();
 };
 
+template <typename Ctr>
+concept supports_full = requires (Ctr ctr) {
+  ctr.full();
+};
+
+// reserve and commit slots in place, e.g. fixed_ring
+template <typename Ctr>
+concept supports_reserve = requires (Ctr ctr, typename Ctr::size_type n, 
+                                     typename Ctr::reservation res) {
+  { ctr.reserve(n) } -> std::same_as<typename Ctr::reservation>;
+  { ctr.reserved_slot(res, n) } -> std::same_as<typename Ctr::value_type*>;
+  { ctr.commit(res) } -> std::convertible_to<typename Ctr::size_type>;
+  { ctr.available() } -> std::convertible_to<typename Ctr::size_type>;
+  { ctr.pending() } -> std::convertible_to<typename Ctr::size_type>;
+};
+
+// contiguous front elements, e.g. fixed_ring
+template <typename Ctr>
+concept supports_front_span = requires (Ctr ctr, typename Ctr::size_type n) {
+  { ctr.front_span() } -> std::convertible_to<std::span<typename Ctr::value_type>>;
+  ctr.pop_front(n);
+};
+
+// erase of an element found by iteration, e.g. std::deque
+template <typename Ctr>
+concept supports_erase = requires (Ctr ctr) {
+  ctr.erase(ctr.begin());
+  ctr.end();
+};
+
+// requirements for wait_queue wait policy
+
+template <typename P>
+concept wait_policy = requires {
+  { P::spin_count } -> std::convertible_to<std::size_t>;
+  { P::blocking } -> std::convertible_to<bool>;
+  P::relax();
+};
+
+/**
+ * @brief Wait policy where reader threads immediately block (the default).
+ */
+struct block_wait {
+  static constexpr std::size_t spin_count = 0u;
+  static constexpr bool blocking = true;
+  static auto relax() noexcept -> void { }
+};
+
+/**
+ * @brief Wait policy where reader threads spin a fixed number of times, checking
+ * for data, before blocking.
+ *
+ * @tparam N Number of spin iterations before blocking.
+ */
+template <std::size_t N = 1000u>
+struct spin_then_block_wait {
+  static constexpr std::size_t spin_count = N;
+  static constexpr bool blocking = true;
+  static auto relax() noexcept -> void { cpu_relax(); }
+};
+
+/**
+ * @brief Wait policy where reader threads never block, continuously polling
+ * for data (or a stop request, or timeout).
+ *
+ * @note A busy polling reader thread uses a full CPU core while waiting.
+ */
+struct busy_poll_wait {
+  static constexpr std::size_t spin_count = 0u;
+  static constexpr bool blocking = false;
+  static auto relax() noexcept -> void { cpu_relax(); }
+};
+
+// requirements for wait_queue layout policy
+
+template <typename P>
+concept layout_policy = requires {
+  { P::padded } -> std::convertible_to<bool>;
+};
+
+/**
+ * @brief Layout policy where the data members are packed together (the default),
+ * keeping the @c wait_queue object small.
+ */
+struct compact_layout {
+  static constexpr bool padded = false;
+};
+
+/**
+ * @brief Layout policy where the lock protected state and the reader and writer blocking
+ * state each start on their own cache line, separate from the read-mostly stop state.
+ *
+ * This trades a larger (and cache line aligned) @c wait_queue object for less false
+ * sharing between threads using different parts of the queue.
+ */
+struct padded_layout {
+  static constexpr bool padded = true;
+};
+
+// requirements for wait_queue stats policy
+
+struct queue_stats;
+
+template <typename S>
+concept stats_policy = std::is_default_constructible_v<S> && 
+                       requires (S st, const S cst, std::size_t cnt, std::chrono::nanoseconds dur) {
+  { S::enabled } -> std::convertible_to<bool>;
+  st.record_push(cnt, cnt);
+  st.record_pop(cnt);
+  st.record_reject();
+  st.record_wait(dur);
+  { cst.snapshot() } -> std::same_as<queue_stats>;
+};
+
+/**
+ * @brief Snapshot of @c wait_queue instrumentation counters, as returned from the 
+ * @c wait_queue @c stats method.
+ *
+ * Since each counter is read independently (without a lock), the values are not
+ * guaranteed to be consistent with each other (e.g. @c pops may briefly exceed 
+ * @c pushes).
+ */
+struct queue_stats {
+  std::uint64_t pushes {0u};          ///< Total elements pushed
+  std::uint64_t pops {0u};            ///< Total elements popped (including drained)
+  /// Pushes (including reservations and suspended @c async_push calls) refused by the
+  /// queue: after a stop request or a @c close, or an overwriting push that would
+  /// destroy a slot waiting for an earlier commit. A full container in the bounded
+  /// @c try_push and @c try_reserve methods is back-pressure, and not counted.
+  std::uint64_t rejected_pushes {0u};
+  std::uint64_t high_water {0u};      ///< Maximum number of elements in the queue
+  std::uint64_t total_wait_ns {0u};   ///< Cumulative time readers were blocked
+  std::uint64_t max_wait_ns {0u};     ///< Maximum time a single reader was blocked
+};
+
+/**
+ * @brief Stats policy with no instrumentation (the default).
+ *
+ * All of the methods are empty and the @c wait_queue data member is declared 
+ * @c [[no_unique_address]], so there is no space or time overhead.
+ */
+struct null_stats {
+  static constexpr bool enabled = false;
+  auto record_push(std::size_t, std::size_t) noexcept -> void { }
+  auto record_pop(std::size_t) noexcept -> void { }
+  auto record_reject() noexcept -> void { }
+  auto record_wait(std::chrono::nanoseconds) noexcept -> void { }
+  auto snapshot() const noexcept -> queue_stats { return queue_stats { }; }
+};
+
+/**
+ * @brief Stats policy keeping instrumentation counters in relaxed atomics.
+ *
+ * Counters updated by writer threads and counters updated by reader threads are on
+ * separate cache lines. Counters are updated while the @c wait_queue lock is held 
+ * (except for the wait times), but @c snapshot does not take the lock, so a metrics 
+ * thread can poll the counters without contending with writers and readers.
+ */
+class atomic_stats {
+private:
+  // writer side
+  alignas(cache_line_size) std::atomic<std::uint64_t> m_pushes {0u};
+  std::atomic<std::uint64_t>                          m_rejected_pushes {0u};
+  std::atomic<std::uint64_t>                          m_high_water {0u};
+  // reader side
+  alignas(cache_line_size) std::atomic<std::uint64_t> m_pops {0u};
+  std::atomic<std::uint64_t>                          m_total_wait_ns {0u};
+  std::atomic<std::uint64_t>                          m_max_wait_ns {0u};
+
+  static auto store_max(std::atomic<std::uint64_t>& cur, std::uint64_t val) noexcept
+        -> void
+  {
+    auto old = cur.load(std::memory_order_relaxed);
+    while (old < val && !cur.compare_exchange_weak(old, val, std::memory_order_relaxed)) {
+    }
+  }
+
+public:
+  static constexpr bool enabled = true;
+
+  auto record_push(std::size_t cnt, std::size_t depth) noexcept
+        -> void
+  {
+    m_pushes.fetch_add(cnt, std::memory_order_relaxed);
+    store_max(m_high_water, depth);
+  }
+
+  auto record_pop(std::size_t cnt) noexcept
+        -> void
+  {
+    m_pops.fetch_add(cnt, std::memory_order_relaxed);
+  }
+
+  auto record_reject() noexcept
+        -> void
+  {
+    m_rejected_pushes.fetch_add(1u, std::memory_order_relaxed);
+  }
+
+  auto record_wait(std::chrono::nanoseconds dur) noexcept
+        -> void
+  {
+    const auto ns = static_cast<std::uint64_t>(dur.count());
+    m_total_wait_ns.fetch_add(ns, std::memory_order_relaxed);
+    store_max(m_max_wait_ns, ns);
+  }
+
+  [[nodiscard]] auto snapshot() const noexcept
+        -> queue_stats
+  {
+    return queue_stats { m_pushes.load(std::memory_order_relaxed),
+                         m_pops.load(std::memory_order_relaxed),
+                         m_rejected_pushes.load(std::memory_order_relaxed),
+                         m_high_water.load(std::memory_order_relaxed),
+                         m_total_wait_ns.load(std::memory_order_relaxed),
+                         m_max_wait_ns.load(std::memory_order_relaxed) };
+  }
+};
+
+/**
+ * @brief Status of a timed wait operation.
+ */
+enum class wait_status {
+  ready,   ///< A value is available
+  timeout, ///< The timeout expired before a value was available
+  stopped, ///< The queue has been requested to stop
+  closed   ///< The queue has been closed and all values have been popped
+};
+
+/**
+ * @brief Return type for the timed @c wait_queue pop methods.
+ *
+ * The @c value is present if and only if @c status is @c wait_status::ready.
+ *
+ * @code
+ *   auto [status, val] = wq.wait_and_pop_for(std::chrono::milliseconds(100));
+ *   if (status == chops::wait_status::stopped) { // time to exit thread
+ *   }
+ * @endcode
+ */
+template <typename T>
+struct timed_pop_result {
+  wait_status      status;
+  std::optional<T> value;
+};
+
+namespace detail {
+
+// allocator type of a container, or a placeholder type if the container 
+// does not use an allocator (e.g. a ring_span)
+template <typename Ctr>
+struct allocator_of {
+  struct none { };
+  using type = none;
+};
+
+template <typename Ctr>
+  requires requires { typename Ctr::allocator_type; }
+struct allocator_of<Ctr> {
+  using type = typename Ctr::allocator_type;
+};
+
+// node in an intrusive singly linked list of suspended coroutines; the node is
+// part of the awaiter object, which lives in the coroutine frame while suspended
+struct awaiter_node {
+  std::coroutine_handle<> m_handle { };
+  awaiter_node*           m_next {nullptr};
+  void*                   m_exec {nullptr};
+  void                  (*m_post)(void*, std::coroutine_handle<>) {nullptr};
+
+  // resume inline, or post to the executor supplied to the async method
+  auto resume() -> void {
+    if (m_post) {
+      m_post(m_exec, m_handle);
+    }
+    else {
+      m_handle.resume();
+    }
+  }
+};
+
+// FIFO list of awaiter nodes, no memory allocation
+struct awaiter_list {
+  awaiter_node* m_head {nullptr};
+  awaiter_node* m_tail {nullptr};
+
+  auto empty() const noexcept -> bool { return m_head == nullptr; }
+
+  auto push_back(awaiter_node* node) noexcept -> void {
+    node->m_next = nullptr;
+    if (m_tail) {
+      m_tail->m_next = node;
+    }
+    else {
+      m_head = node;
+    }
+    m_tail = node;
+  }
+
+  auto pop_front() noexcept -> awaiter_node* {
+    auto* node = m_head;
+    m_head = node->m_next;
+    if (!m_head) {
+      m_tail = nullptr;
+    }
+    return node;
+  }
+
+  // the next pointer is read before resuming, since a resumed coroutine may
+  // destroy the awaiter (and node)
+  auto resume_all() -> void {
+    auto* node = m_head;
+    m_head = m_tail = nullptr;
+    while (node) {
+      auto* next = node->m_next;
+      node->resume();
+      node = next;
+    }
+  }
+};
+
+} // end detail namespace
+
 /**
  * @brief MPMC thread-safe wait queue with shutdown semantics.
  *
@@ -198,6 +637,17 @@ concept supports_size = requires (Ctr ctr) {
  *
  * @tparam Container Type of container that is used as the underlying data queue.
  *
+ * @tparam WaitPolicy Policy for how reader threads wait for data, one of @c block_wait,
+ * @c spin_then_block_wait, or @c busy_poll_wait (or a user supplied type meeting the 
+ * @c wait_policy requirements).
+ *
+ * @tparam StatsPolicy Policy for instrumentation counters, either @c null_stats (no
+ * instrumentation) or @c atomic_stats (or a user supplied type meeting the 
+ * @c stats_policy requirements).
+ *
+ * @tparam LayoutPolicy Policy for the data member layout, either @c compact_layout (the
+ * smallest object) or @c padded_layout (intra-object cache line separation).
+ *
  * @pre The value type must be either copy constructible or move constructible. It does not
  * have to be both, and in particular a default constructor is not required.
  *
@@ -205,22 +655,62 @@ concept supports_size = requires (Ctr ctr) {
  * The constraints are specified on each particular operation.
  *
  */
-template <typename T, typename Container = std::deque<T> >
+template <typename T, typename Container = std::deque<T>, wait_policy WaitPolicy = block_wait,
+          stats_policy StatsPolicy = null_stats, layout_policy LayoutPolicy = compact_layout>
   requires std::is_copy_constructible_v<T> || std::is_move_constructible_v<T>
 class wait_queue {
 private:
-  mutable std::mutex              m_mut;
+  // alignment of each group of data members, a cache line only for padded_layout
+  template <typename M>
+  static constexpr std::size_t group_align = LayoutPolicy::padded ? cache_line_size : alignof(M);
+
+  // read-mostly state, checked without the lock by push and pop methods
   std::optional<std::stop_source> m_stop_src;
   std::stop_token                 m_stop_tok;
-  std::condition_variable_any     m_data_cond;
+  // lock protected state
+  alignas(group_align<std::mutex>) mutable std::mutex m_mut;
   Container                       m_data_queue;
+  // element count, stored with the lock held after every change and read without it
+  std::atomic<typename Container::size_type> m_approx_size { current_size() };
+  // number of threads blocked on each condition variable
+  std::size_t                     m_data_waiters {0u};
+  std::size_t                     m_space_waiters {0u};
+  std::size_t                     m_reserve_waiters {0u}; // waiting for multiple slots
+  std::size_t                     m_pred_waiters {0u}; // waiting for a matching element
+  // set by close, with the lock held
+  std::atomic<bool>               m_closed {false};
+  // suspended coroutines from async_pop and async_push
+  detail::awaiter_list            m_pop_awaiters;
+  detail::awaiter_list            m_push_awaiters;
+  // attached by a queue_select (wait_any), signaled when data is pushed or on a stop
+  event_count*                    m_notifier {nullptr};
+  // reader side blocking state, and (bounded containers only) writer side blocking
+  // state, each on separate cache lines for padded_layout
+  alignas(group_align<std::condition_variable_any>) std::condition_variable_any m_data_cond;
+  alignas(supports_full<Container> ? group_align<std::condition_variable_any> :
+                                     alignof(std::condition_variable_any))
+    std::condition_variable_any   m_space_cond;
+  [[no_unique_address]] StatsPolicy m_stats;
+
+  // resumes all suspended coroutines when a stop is requested
+  struct stop_resumer {
+    wait_queue* m_wq;
+    auto operator()() noexcept -> void { m_wq->resume_stopped(); }
+  };
+  // must be the last data member, since the callback may be invoked immediately
+  std::stop_callback<stop_resumer> m_stop_cb { m_stop_tok, stop_resumer{this} };
+
+  static constexpr bool has_approx_size = supports_size<Container>;
 
   using lock_guard = std::scoped_lock<std::mutex>;
+  using unique_lock = std::unique_lock<std::mutex>;
 
 public:
 
   using size_type = typename Container::size_type;
   using value_type = T;
+  using container_type = Container;
+  using allocator_type = typename detail::allocator_of<Container>::type;
 
 public:
 
@@ -361,14 +851,61 @@ public:
    * @post @c size returns 0 or @c sz depending on container used.
    */
   wait_queue(std::stop_token stop_tok, size_type sz)
-    requires std::is_constructible_v<Container, std::stop_token, size_type>
-    // noexcept(std::is_nothrow_constructible_v<Container, std::stop_token, size_type>)
-      : m_stop_tok((*m_stop_src).get_token()), m_data_queue(sz) 
+    requires std::is_constructible_v<Container, size_type>
+    // noexcept(std::is_nothrow_constructible_v<Container, size_type>)
+      : m_stop_tok(stop_tok), m_data_queue(sz)
   {
     assert((sz != size_type(0)) || empty());
     assert((size() == size_type(0)) || (size() == sz));
   }
 
+  /**
+   * @brief Construct a @c wait_queue with an allocator for the container.
+   *
+   * This allows a memory pool to be used for the container memory, for example a
+   * @c std::pmr::memory_resource when the container is a @c std::pmr::deque (see
+   * @c pmr_wait_queue.hpp, where a pointer to a memory resource can be directly 
+   * passed in to this constructor).
+   *
+   * An internal @c std::stop_source is used to provide a @c std::stop_token for
+   * coordinating shutdown.
+   *
+   * @param alloc Allocator used by the container.
+   *
+   * @post @c empty returns @c true.
+   * @post @c size returns 0.
+   * @post @c stop_requested returns @c false.
+   */
+  wait_queue(const allocator_type& alloc)
+    requires std::is_constructible_v<Container, const allocator_type&>
+      : m_stop_src(std::stop_source{}), m_stop_tok((*m_stop_src).get_token()),
+        m_data_queue(alloc)
+  {
+    assert(empty());
+    assert(size() == size_type(0));
+    assert(!stop_requested());
+  }
+
+  /**
+   * @brief Construct a @c wait_queue with an allocator for the container along with
+   * a @c std::stop_token.
+   *
+   * @param stop_tok A @c std::stop_token which can be used to shutdown @c wait_queue
+   * processing.
+   *
+   * @param alloc Allocator used by the container.
+   *
+   * @post @c empty returns @c true.
+   * @post @c size returns 0.
+   */
+  wait_queue(std::stop_token stop_tok, const allocator_type& alloc)
+    requires std::is_constructible_v<Container, const allocator_type&>
+      : m_stop_tok(stop_tok), m_data_queue(alloc)
+  {
+    assert(empty());
+    assert(size() == size_type(0));
+  }
+
   // disallow copy or move construction of the entire object
   wait_queue(const wait_queue&) = delete;
   wait_queue(wait_queue&&) = delete;
@@ -402,6 +939,52 @@ public:
     return false;
   }
 
+  /**
+   * @brief Close the @c wait_queue, so that no more values can be pushed while the 
+   * values already in the queue can still be popped.
+   *
+   * Unlike @c request_stop, which makes the blocking pop methods return immediately
+   * (dropping any values still in the queue), after a @c close the pop methods continue
+   * to return values until the queue is empty, and only then return an empty result
+   * (end of stream). Pushes (and reservations) are rejected as soon as @c close is 
+   * called. All waiting reader and writer threads are notified.
+   *
+   * This gives a lossless pipeline shutdown: close the queue, and reader threads exit
+   * once they have drained all of the remaining values. A @c request_stop can still be
+   * used afterwards to abandon the remaining values.
+   *
+   * @return @c true if this call closed the @c wait_queue, @c false if it was already
+   * closed.
+   *
+   * @post @c closed returns @c true.
+   */
+  auto close() /* noexcept */
+        -> bool
+  {
+    detail::awaiter_list ready;
+    {
+      lock_guard lk{m_mut};
+      if (m_closed.exchange(true, std::memory_order_relaxed)) {
+        return false;
+      }
+      if (m_notifier != nullptr) {
+        m_notifier->notify_all();
+      }
+      // suspended pops only wait on an empty queue, and no more values will be pushed
+      while (!m_pop_awaiters.empty()) {
+        ready.push_back(m_pop_awaiters.pop_front());
+      }
+      while (!m_push_awaiters.empty()) {
+        m_stats.record_reject();
+        ready.push_back(m_push_awaiters.pop_front());
+      }
+    }
+    m_data_cond.notify_all();
+    m_space_cond.notify_all();
+    ready.resume_all();
+    return true;
+  }
+
   /**
    * @brief Push a value, by copying, to the @c wait_queue.
    *
@@ -411,7 +994,9 @@ public:
    * @param val Val to copy into the queue.
    *
    * @return @c true if successful, @c false if the @c wait_queue has been
-   * requested to stop.
+   * requested to stop. For a full container with outstanding reservations (see 
+   * @c reserve), @c false is also returned if every slot is reserved or waiting for an
+   * earlier commit, since only visible elements are overwritten.
    *
    * @post If @c true is returned and @c empty is @c false, one of any threads waiting for a
    *   value will be unblocked.
@@ -422,11 +1007,15 @@ public:
 
   {
     if (m_stop_tok.stop_requested()) {
+      m_stats.record_reject();
+      return false;
+    }
+    unique_lock lk{m_mut};
+    if (reject_closed() || reject_overwrite(size_type(1))) {
       return false;
     }
-    lock_guard lk{m_mut};
     m_data_queue.push_back(val);
-    m_data_cond.notify_one();
+    notify_data(lk, size_type(1));
     return true;
 
   }
@@ -446,110 +1035,1338 @@ public:
 
   {
     if (m_stop_tok.stop_requested()) {
+      m_stats.record_reject();
+      return false;
+    }
+    unique_lock lk{m_mut};
+    if (reject_closed() || reject_overwrite(size_type(1))) {
       return false;
     }
-    lock_guard lk{m_mut};
     m_data_queue.push_back(std::move(val));
-    m_data_cond.notify_one();
+    notify_data(lk, size_type(1));
     return true;
 
   }
 
   /**
-   * @brief Directly construct an object in the underlying container (using the container's
-   * @c emplace_back method) by forwarding the supplied arguments (can be more than one).
+   * @brief Push a value, by copying, to the @c wait_queue if there is space available 
+   * in the container, otherwise immediately return.
    *
-   * @param args Arguments to be used in constructing an element at the end of the queue.
+   * This method is only available for containers that support a @c full method. Unlike
+   * @c push, a full container will not have the oldest element overwritten.
    *
-   * @note The @c std containers return a reference to the newly constructed element from 
-   * @c emplace method calls. @c emplace_push for a @c wait_queue does not follow this 
-   * convention and instead has the same return as the @c push methods.
+   * @param val Val to copy into the queue.
    *
-   * @return @c true if successful, @c false if the @c wait_queue is has been requested
-   * to stop.
+   * @return @c true if successful, @c false if the container is full or the 
+   * @c wait_queue has been requested to stop.
    *
-   * @post If @c true is returned and @c empty is @c false, one of any threads waiting for a
-   *   value will be unblocked.
+   * @post If @c true is returned, one of any threads waiting for a value will be 
+   *   unblocked.
    */
-  template <typename ... Args>
-  auto emplace_push(Args &&... args) /* noexcept(std::is_nothrow_constructible_v<T, Args...>)*/
+  auto try_push(const T& val) /* noexcept(std::is_nothrow_copy_constructible_v<T>) */
         -> bool 
-    requires supports_emplace_back<Container, Args...>
- 
+    requires supports_push_back<Container, T> && supports_full<Container>
+
   {
     if (m_stop_tok.stop_requested()) {
+      m_stats.record_reject();
       return false;
     }
-    lock_guard lk{m_mut};
-    m_data_queue.emplace_back(std::forward<Args>(args)...);
-    m_data_cond.notify_one();
+    unique_lock lk{m_mut};
+    if (reject_closed()) {
+      return false;
+    }
+    if (m_data_queue.full()) {
+      return false;
+    }
+    m_data_queue.push_back(val);
+    notify_data(lk, size_type(1));
     return true;
+
   }
 
   /**
-   * @brief Pop and return a value from the @c wait_queue, blocking and waiting for a writer 
-   * thread to push a value if one is not immediately available.
-   *
-   * If this method is called after a @c wait_queue has been requested to stop, an empty 
-   * @c std::optional is returned. If a @c wait_queue needs to be flushed after it is stopped, 
-   * @c try_pop should be called instead.
-   *
-   * @return A value from the @c wait_queue (if non-empty). If the @c std::optional is empty, 
-   * the @c wait_queue has been requested to be stopped.
+   * @brief Push a value, either by moving or copying, to the @c wait_queue if there 
+   * is space available in the container, otherwise immediately return.
    *
-   * @post If a non empty value is returned, until a push function is called, @c size is one
-   *   less than before this function was called.
+   * This method has the same semantics as the other @c try_push, except that the value
+   * will be moved (if possible) instead of copied. If @c false is returned the value
+   * has not been moved from.
    */
-  [[nodiscard]] auto wait_and_pop() /* noexcept(std::is_nothrow_constructible_v<T>) */
-        -> std::optional<T> 
-      requires supports_empty<Container> && supports_pop_front<Container>
+  auto try_push(T&& val) /* noexcept(std::is_nothrow_move_constructible_v<T>) */
+        -> bool 
+    requires supports_push_back<Container, T> && supports_full<Container>
 
   {
-    std::unique_lock<std::mutex> lk{m_mut};
-    if (!m_data_cond.wait ( lk, m_stop_tok, [this] { return !m_data_queue.empty(); } )) {
-      return std::optional<T> {}; // queue was request to stop, no data available
+    if (m_stop_tok.stop_requested()) {
+      m_stats.record_reject();
+      return false;
     }
-    assert(!m_data_queue.empty());
-#ifndef NDEBUG
-    const auto old_size = m_data_queue.size();
-#endif
-    std::optional<T> val {std::move_if_noexcept(m_data_queue.front())}; // move construct if possible
-    m_data_queue.pop_front();
-    assert(m_data_queue.size() + 1u == old_size);
-    return val;
+    unique_lock lk{m_mut};
+    if (reject_closed()) {
+      return false;
+    }
+    if (m_data_queue.full()) {
+      return false;
+    }
+    m_data_queue.push_back(std::move(val));
+    notify_data(lk, size_type(1));
+    return true;
 
   }
 
   /**
-   * @brief Pop and return a value from the @c wait_queue if an element is immediately 
+   * @brief Push a value, by copying, to the @c wait_queue, blocking and waiting for a 
+   * reader thread to pop a value if the container is full.
+   *
+   * This method is only available for containers that support a @c full method. Unlike
+   * @c push, a full container will not have the oldest element overwritten.
+   *
+   * @param val Val to copy into the queue.
+   *
+   * @return @c true if successful, @c false if the @c wait_queue has been requested 
+   * to stop (including while waiting for space).
+   *
+   * @post If @c true is returned, one of any threads waiting for a value will be 
+   *   unblocked.
+   */
+  auto wait_and_push(const T& val) /* noexcept(std::is_nothrow_copy_constructible_v<T>) */
+        -> bool 
+    requires supports_push_back<Container, T> && supports_full<Container>
+
+  {
+    unique_lock lk{m_mut};
+    if (!wait_for_space(lk)) {
+      m_stats.record_reject();
+      return false; // queue was request to stop
+    }
+    m_data_queue.push_back(val);
+    notify_data(lk, size_type(1));
+    return true;
+
+  }
+
+  /**
+   * @brief Push a value, either by moving or copying, to the @c wait_queue, blocking 
+   * and waiting for a reader thread to pop a value if the container is full.
+   *
+   * This method has the same semantics as the other @c wait_and_push, except that the 
+   * value will be moved (if possible) instead of copied.
+   */
+  auto wait_and_push(T&& val) /* noexcept(std::is_nothrow_move_constructible_v<T>) */
+        -> bool 
+    requires supports_push_back<Container, T> && supports_full<Container>
+
+  {
+    unique_lock lk{m_mut};
+    if (!wait_for_space(lk)) {
+      m_stats.record_reject();
+      return false; // queue was request to stop
+    }
+    m_data_queue.push_back(std::move(val));
+    notify_data(lk, size_type(1));
+    return true;
+
+  }
+
+  /**
+   * @brief Directly construct an object in the underlying container (using the container's
+   * @c emplace_back method) by forwarding the supplied arguments (can be more than one).
+   *
+   * @param args Arguments to be used in constructing an element at the end of the queue.
+   *
+   * @note The @c std containers return a reference to the newly constructed element from 
+   * @c emplace method calls. @c emplace_push for a @c wait_queue does not follow this 
+   * convention and instead has the same return as the @c push methods.
+   *
+   * @return @c true if successful, @c false if the @c wait_queue is has been requested
+   * to stop (or, as with @c push, nothing can be overwritten).
+   *
+   * @post If @c true is returned and @c empty is @c false, one of any threads waiting for a
+   *   value will be unblocked.
+   */
+  template <typename ... Args>
+  auto emplace_push(Args &&... args) /* noexcept(std::is_nothrow_constructible_v<T, Args...>)*/
+        -> bool 
+    requires supports_emplace_back<Container, Args...>
+ 
+  {
+    if (m_stop_tok.stop_requested()) {
+      m_stats.record_reject();
+      return false;
+    }
+    unique_lock lk{m_mut};
+    if (reject_closed() || reject_overwrite(size_type(1))) {
+      return false;
+    }
+    m_data_queue.emplace_back(std::forward<Args>(args)...);
+    notify_data(lk, size_type(1));
+    return true;
+  }
+
+  /**
+   * @brief Push a range of values, specified by an iterator pair, to the @c wait_queue.
+   *
+   * All of the values are appended to the queue while the internal lock is held once,
+   * and waiting reader threads are notified once for the whole batch, rather than once
+   * per element. Values are copied (or moved, if the iterators are move iterators).
+   *
+   * @param first Iterator to the first value to be pushed.
+   *
+   * @param last Sentinel or iterator one past the last value to be pushed.
+   *
+   * @return @c true if successful, @c false if the @c wait_queue has been
+   * requested to stop, or (as with @c push) there is not room for all of the values 
+   * without overwriting reserved slots. If @c false is returned, no values have been 
+   * pushed, except for single pass input iterators (without a sized sentinel) when there
+   * is not room, where the values up to the first one without room have been pushed.
+   *
+   * @post If @c true is returned and the range is not empty, waiting reader threads 
+   *   will be unblocked (up to the number of values pushed).
+   */
+  template <std::input_iterator Iter, std::sentinel_for<Iter> S>
+  auto push_range(Iter first, S last) /* noexcept(std::is_nothrow_copy_constructible_v<T>) */
+        -> bool
+    requires supports_push_back<Container, std::iter_reference_t<Iter>>
+
+  {
+    if (m_stop_tok.stop_requested()) {
+      m_stats.record_reject();
+      return false;
+    }
+    unique_lock lk{m_mut};
+    if (reject_closed()) {
+      return false;
+    }
+    auto room = overwrite_room();
+    if constexpr (std::forward_iterator<Iter> || std::sized_sentinel_for<S, Iter>) {
+      if (room != std::numeric_limits<size_type>::max() &&
+          reject_overwrite(static_cast<size_type>(std::ranges::distance(first, last)))) {
+        return false;
+      }
+    }
+    size_type cnt {0};
+    for (; first != last; ++first, --room) {
+      if (room == size_type(0)) { // only reached for single pass, unsized input iterators
+        m_stats.record_reject();
+        notify_data(lk, cnt);
+        return false;
+      }
+      m_data_queue.push_back(*first);
+      ++cnt;
+    }
+    notify_data(lk, cnt);
+    return true;
+
+  }
+
+  /**
+   * @brief Push all of the values in a range to the @c wait_queue.
+   *
+   * This method has the same semantics as the iterator pair @c push_range, except that
+   * if the range is passed as an rvalue the values will be moved (if possible) instead
+   * of copied.
+   *
+   * @param rng Range of values to be pushed.
+   *
+   * @return @c true if successful, @c false if the @c wait_queue has been
+   * requested to stop.
+   */
+  template <std::ranges::input_range R>
+  auto push_range(R&& rng) /* noexcept(std::is_nothrow_copy_constructible_v<T>) */
+        -> bool
+    requires supports_push_back<Container, std::ranges::range_reference_t<R>>
+
+  {
+    if constexpr (std::is_lvalue_reference_v<R>) {
+      return push_range(std::ranges::begin(rng), std::ranges::end(rng));
+    }
+    else {
+      return push_range(std::make_move_iterator(std::ranges::begin(rng)),
+                        std::make_move_iterator(std::ranges::end(rng)));
+    }
+  }
+
+  /**
+   * @brief Per producer (thread) buffer of pushed values, flushed to the @c wait_queue
+   * in batches.
+   *
+   * Each @c push on a @c producer_handle appends to a local buffer, without locking.
+   * The buffer is flushed with @c push_range (one lock acquisition and one notification
+   * for the whole batch) when it reaches the batch size, when a push or a @c flush_if_due
+   * call is performed after the maximum delay since the oldest buffered value, when
+   * @c flush is called, and when the @c producer_handle is destroyed. This reduces the
+   * lock acquisitions by up to the batch size, at the cost of added latency.
+   *
+   * A @c producer_handle is used by one thread at a time; it is movable but not copyable.
+   * There is no timer thread, the maximum delay is only checked by @c push,
+   * @c emplace_push and @c flush_if_due. The latency is bounded by the maximum delay only
+   * if the owning thread calls @c flush_if_due (or @c flush) when it has nothing to push,
+   * for example each time around its event loop, otherwise a value buffered before the
+   * producer goes idle stays in the buffer until the next push.
+   *
+   * Example usage:
+   *
+   * @code
+   *   chops::wait_queue<int> wq;
+   *   // in each producer thread
+   *   chops::wait_queue<int>::producer_handle prod { wq, 64u, std::chrono::microseconds(100) };
+   *   prod.push(42); // buffered
+   *   prod.flush_if_due(); // in the producer loop, pushes 42 once 100 us have passed
+   *   // remaining values are flushed when prod goes out of scope
+   * @endcode
+   */
+  class producer_handle {
+  public:
+    using duration = std::chrono::steady_clock::duration;
+
+    /**
+     * @brief Construct a @c producer_handle for a @c wait_queue.
+     *
+     * @param wq @c wait_queue which the buffered values are flushed to.
+     *
+     * @param batch_size Number of values buffered before a flush.
+     *
+     * @param max_delay Maximum time a value is buffered, checked by the push methods and
+     * by @c flush_if_due (which must be called by an idle producer for the bound to hold).
+     * The default is no time bound.
+     *
+     * @pre @c batch_size is greater than 0.
+     */
+    producer_handle(wait_queue& wq, size_type batch_size, duration max_delay = duration::max()) :
+        m_wq(&wq), m_batch_size(batch_size), m_max_delay(max_delay) {
+      assert(batch_size > size_type(0));
+      m_buf.reserve(batch_size);
+    }
+
+    producer_handle(producer_handle&& rhs) noexcept :
+        m_wq(rhs.m_wq), m_buf(std::move(rhs.m_buf)), m_batch_size(rhs.m_batch_size),
+        m_max_delay(rhs.m_max_delay), m_oldest(rhs.m_oldest) {
+      rhs.m_wq = nullptr;
+    }
+
+    producer_handle(const producer_handle&) = delete;
+    producer_handle& operator=(const producer_handle&) = delete;
+    producer_handle& operator=(producer_handle&&) = delete;
+
+    /**
+     * @brief Flush any buffered values.
+     */
+    ~producer_handle() {
+      if (m_wq != nullptr) {
+        flush();
+      }
+    }
+
+    /**
+     * @brief Buffer a value, flushing if the batch is full or the maximum delay has
+     * been reached.
+     *
+     * @return @c false if the @c wait_queue has been requested to stop or closed (buffered
+     * values are discarded), or a flush was rejected (see @c flush), otherwise @c true.
+     */
+    auto push(const T& val)
+          -> bool
+        requires std::is_copy_constructible_v<T>
+    {
+      return emplace_push(val);
+    }
+
+    auto push(T&& val)
+          -> bool
+        requires std::is_move_constructible_v<T>
+    {
+      return emplace_push(std::move(val));
+    }
+
+    /**
+     * @brief Construct a value in the buffer, flushing if the batch is full or the
+     * maximum delay has been reached.
+     *
+     * @return @c false if the @c wait_queue has been requested to stop or closed (buffered
+     * values are discarded), or a flush was rejected (see @c flush), otherwise @c true.
+     */
+    template <typename ... Args>
+    auto emplace_push(Args&&... args)
+          -> bool
+        requires std::is_constructible_v<T, Args...>
+    {
+      assert(m_wq != nullptr);
+      if (m_wq->stop_requested() || m_wq->closed()) {
+        m_buf.clear();
+        return false;
+      }
+      if (timed() && m_buf.empty()) {
+        m_oldest = std::chrono::steady_clock::now();
+      }
+      m_buf.emplace_back(std::forward<Args>(args)...);
+      if (m_buf.size() >= m_batch_size || due()) {
+        return flush();
+      }
+      return true;
+    }
+
+    /**
+     * @brief Push all buffered values to the @c wait_queue.
+     *
+     * The values are pushed with one @c push_range call, and are rejected if:
+     *
+     * - The @c wait_queue has been requested to stop or closed. The buffered values are
+     * discarded, since no more pushes will be accepted.
+     *
+     * - The container is full and overwriting would destroy slots waiting for an earlier
+     * commit (a @c fixed_ring with outstanding reservations, see @c push_range). No
+     * values are pushed, and the buffered values are kept so that a later @c flush can
+     * retry (the destructor discards them if they are still rejected).
+     *
+     * @return @c false if the values were rejected, otherwise @c true.
+     */
+    auto flush()
+          -> bool
+    {
+      assert(m_wq != nullptr);
+      if (m_buf.empty()) {
+        return !m_wq->stop_requested() && !m_wq->closed();
+      }
+      if (m_wq->push_range(std::make_move_iterator(m_buf.begin()),
+                           std::make_move_iterator(m_buf.end()))) {
+        m_buf.clear();
+        return true;
+      }
+      if (m_wq->stop_requested() || m_wq->closed()) {
+        m_buf.clear();
+      }
+      return false;
+    }
+
+    /**
+     * @brief Flush the buffered values if the maximum delay since the oldest buffered
+     * value has been reached.
+     *
+     * A producer must call this when it has nothing to push (e.g. each time through its
+     * event loop or on its own timer), since there is no background flush.
+     *
+     * @return @c false if a flush was performed and rejected (see @c flush), otherwise
+     * @c true.
+     */
+    auto flush_if_due()
+          -> bool
+    {
+      assert(m_wq != nullptr);
+      return (!m_buf.empty() && due()) ? flush() : true;
+    }
+
+    /**
+     * @brief Number of buffered values, not yet pushed to the @c wait_queue.
+     */
+    [[nodiscard]] auto buffered() const noexcept -> size_type { return m_buf.size(); }
+
+  private:
+    auto timed() const noexcept -> bool { return m_max_delay != duration::max(); }
+
+    auto due() const noexcept
+          -> bool
+    {
+      return timed() && (std::chrono::steady_clock::now() - m_oldest) >= m_max_delay;
+    }
+
+    wait_queue*                           m_wq;
+    std::vector<T>                        m_buf;
+    size_type                             m_batch_size;
+    duration                              m_max_delay;
+    std::chrono::steady_clock::time_point m_oldest { };
+  };
+
+  /**
+   * @brief Slots reserved in the internal container, returned from @c reserve and
+   * @c try_reserve and passed to @c commit.
+   *
+   * An element is constructed in each slot (in order) with @c emplace, without holding
+   * the internal lock.
+   */
+  class reserved_slots {
+  public:
+    /**
+     * @brief Construct an element in place in the next unconstructed slot.
+     *
+     * @return Reference to the constructed element, which can be further filled in.
+     *
+     * @pre Fewer than @c size elements have been constructed.
+     */
+    template <typename ... Args>
+    auto emplace(Args&&... args)
+          -> T&
+        requires std::is_constructible_v<T, Args...>
+    {
+      assert(m_constructed < m_res.count);
+      T* p = std::construct_at(m_ctr->reserved_slot(m_res, m_constructed), 
+                               std::forward<Args>(args)...);
+      ++m_constructed;
+      return *p;
+    }
+
+    /**
+     * @brief Number of reserved slots.
+     */
+    [[nodiscard]] auto size() const noexcept -> size_type { return m_res.count; }
+
+  private:
+    friend class wait_queue;
+
+    reserved_slots(Container& ctr, typename Container::reservation res) noexcept :
+        m_ctr(&ctr), m_res(res) { }
+
+    Container*                      m_ctr;
+    typename Container::reservation m_res;
+    size_type                       m_constructed {0u};
+  };
+
+  /**
+   * @brief Reserve slots in the internal container, blocking and waiting for space if
+   * not enough slots are available.
+   *
+   * This is the first phase of a two phase push, available for containers such as
+   * @c fixed_ring. Elements are constructed directly in the container storage through
+   * the returned @c reserved_slots, outside of the internal lock, and then published
+   * (and readers notified) with @c commit. The lock is held only to update the
+   * container indices. Reserved slots are not visible to readers (or to @c size and
+   * @c empty) until committed, and slots are visible in reservation order.
+   *
+   * @param n Number of slots to reserve.
+   *
+   * @return A @c reserved_slots object, or an empty @c std::optional if the
+   * @c wait_queue has been requested to stop.
+   *
+   * @pre @c n is greater than 0 and less than or equal to the container capacity.
+   *
+   * @note Every reservation must be committed. The @c drain methods and destruction of
+   * the @c wait_queue must not be performed while there are outstanding reservations.
+   */
+  [[nodiscard]] auto reserve(size_type n = size_type(1))
+        -> std::optional<reserved_slots>
+      requires supports_reserve<Container>
+
+  {
+    assert(n > size_type(0));
+    unique_lock lk{m_mut};
+    if (!wait_for_slots(lk, n)) {
+      m_stats.record_reject();
+      return std::optional<reserved_slots> {};
+    }
+    return std::optional<reserved_slots> { reserved_slots { m_data_queue, m_data_queue.reserve(n) } };
+
+  }
+
+  /**
+   * @brief Reserve slots in the internal container if enough slots are immediately
+   * available, without blocking.
+   *
+   * @param n Number of slots to reserve.
+   *
+   * @return A @c reserved_slots object, or an empty @c std::optional if not enough 
+   * slots are available or the @c wait_queue has been requested to stop or closed.
+   *
+   * @note See @c reserve for details. As with @c try_push, not enough slots is not
+   * counted in the @c queue_stats @c rejected_pushes.
+   */
+  [[nodiscard]] auto try_reserve(size_type n = size_type(1))
+        -> std::optional<reserved_slots>
+      requires supports_reserve<Container>
+
+  {
+    assert(n > size_type(0));
+    if (m_stop_tok.stop_requested()) {
+      m_stats.record_reject();
+      return std::optional<reserved_slots> {};
+    }
+    lock_guard lk{m_mut};
+    if (reject_closed()) {
+      return std::optional<reserved_slots> {};
+    }
+    if (m_data_queue.available() < n) { // back-pressure, not counted as a reject
+      return std::optional<reserved_slots> {};
+    }
+    return std::optional<reserved_slots> { reserved_slots { m_data_queue, m_data_queue.reserve(n) } };
+
+  }
+
+  /**
+   * @brief Commit reserved slots, publishing the constructed elements and notifying
+   * reader threads.
+   *
+   * If an earlier reservation (from another writer thread) has not yet been committed,
+   * the elements become visible when it is committed.
+   *
+   * @param slots Slots returned from @c reserve or @c try_reserve.
+   *
+   * @return @c false if the @c wait_queue has been requested to stop (the elements are
+   * still committed, and can be flushed with @c try_pop), otherwise @c true.
+   *
+   * @pre An element has been constructed in every slot, and @c slots has not already
+   * been committed.
+   */
+  auto commit(const reserved_slots& slots)
+        -> bool
+      requires supports_reserve<Container>
+
+  {
+    assert(slots.m_constructed == slots.m_res.count);
+    unique_lock lk{m_mut};
+    const auto cnt = static_cast<size_type>(m_data_queue.commit(slots.m_res));
+    notify_data(lk, cnt);
+    return !m_stop_tok.stop_requested();
+
+  }
+
+  /**
+   * @brief Pop and return a value from the @c wait_queue, blocking and waiting for a writer 
+   * thread to push a value if one is not immediately available.
+   *
+   * If this method is called after a @c wait_queue has been requested to stop, an empty 
+   * @c std::optional is returned. If a @c wait_queue needs to be flushed after it is stopped, 
+   * @c try_pop should be called instead.
+   *
+   * @return A value from the @c wait_queue (if non-empty). If the @c std::optional is empty, 
+   * the @c wait_queue has been requested to be stopped, or has been closed and is empty.
+   *
+   * @post If a non empty value is returned, until a push function is called, @c size is one
+   *   less than before this function was called.
+   */
+  [[nodiscard]] auto wait_and_pop() /* noexcept(std::is_nothrow_constructible_v<T>) */
+        -> std::optional<T> 
+      requires supports_empty<Container> && supports_pop_front<Container>
+
+  {
+    unique_lock lk {spin_for_data()};
+    if (!wait_for_data(lk)) {
+      return std::optional<T> {}; // queue was request to stop, no data available
+    }
+    std::optional<T> val {pop_front_value()};
+    notify_space(lk, size_type(1));
+    return val;
+
+  }
+
+  /**
+   * @brief Pop and return a value from the @c wait_queue, blocking and waiting for a writer
+   * thread to push a value until the specified time is reached.
+   *
+   * @param abs_time Time point (for any clock) at which to stop waiting.
+   *
+   * @return A @c timed_pop_result containing a @c wait_status and a @c std::optional
+   * value. The status is @c wait_status::ready (and the value is present) if a value
+   * was popped, @c wait_status::timeout if the time point was reached without a value
+   * being available, and @c wait_status::stopped if the @c wait_queue has been requested
+   * to be stopped.
+   *
+   * @post If a non empty value is returned, until a push function is called, @c size is one
+   *   less than before this function was called.
+   */
+  template <typename Clock, typename Duration>
+  [[nodiscard]] auto wait_and_pop_until(const std::chrono::time_point<Clock, Duration>& abs_time)
+        -> timed_pop_result<T>
+      requires supports_empty<Container> && supports_pop_front<Container>
+
+  {
+    unique_lock lk {spin_for_data(abs_time)};
+    if (!wait_for_data_until(lk, abs_time)) {
+      return timed_pop_result<T> { 
+        (m_stop_tok.stop_requested() ? wait_status::stopped : 
+           (is_closed() ? wait_status::closed : wait_status::timeout)), 
+        std::optional<T> {} };
+    }
+    timed_pop_result<T> res { wait_status::ready, pop_front_value() };
+    notify_space(lk, size_type(1));
+    return res;
+
+  }
+
+  /**
+   * @brief Pop and return a value from the @c wait_queue, blocking and waiting for a writer
+   * thread to push a value for up to the specified duration.
+   *
+   * This method has the same semantics as @c wait_and_pop_until, with the time point
+   * computed from @c std::chrono::steady_clock.
+   *
+   * @param rel_time Maximum duration to wait.
+   *
+   * @return A @c timed_pop_result, as documented in @c wait_and_pop_until.
+   */
+  template <typename Rep, typename Period>
+  [[nodiscard]] auto wait_and_pop_for(const std::chrono::duration<Rep, Period>& rel_time)
+        -> timed_pop_result<T>
+      requires supports_empty<Container> && supports_pop_front<Container>
+
+  {
+    return wait_and_pop_until(std::chrono::steady_clock::now() + rel_time);
+  }
+
+  /**
+   * @brief Pop and return a value from the @c wait_queue if an element is immediately 
    * available, otherwise return an empty @c std::optional.
    *
-   * @return A value from the @c wait_queue or an empty @c std::optional if no values are 
-   * available in the @c wait_queue or if the @c wait_queue has been requested to be 
-   * stopped .
+   * @return A value from the @c wait_queue or an empty @c std::optional if no values are 
+   * available in the @c wait_queue or if the @c wait_queue has been requested to be 
+   * stopped .
+   *
+   * @post If a non empty value is returned, until a push function is called, @c size is one
+   *   less than before this function was called.
+   */
+  [[nodiscard]] auto try_pop() /* noexcept(std::is_nothrow_constructible_v<T>) */
+        -> std::optional<T> 
+      requires supports_empty<Container> && supports_pop_front<Container>
+  {
+    if (m_stop_tok.stop_requested()) {
+      return std::optional<T> {};
+    }
+    unique_lock lk{m_mut};
+    if (m_data_queue.empty()) {
+      return std::optional<T> {};
+    }
+    std::optional<T> val {pop_front_value()};
+    notify_space(lk, size_type(1));
+    return val;
+
+  }
+
+  /**
+   * @brief Pop a value from the @c wait_queue into a caller supplied object, blocking 
+   * and waiting for a writer thread to push a value if one is not immediately available.
+   *
+   * This method has the same semantics as the @c wait_and_pop returning a
+   * @c std::optional, but the value is move assigned (or copy assigned) to @c out, so 
+   * no @c std::optional is constructed per element. This is useful in a reader loop 
+   * that reuses one object.
+   *
+   * @param out Object assigned the popped value, unchanged if @c false is returned.
+   *
+   * @return @c true if a value was popped, @c false if the @c wait_queue has been 
+   * requested to be stopped, or has been closed and is empty.
+   */
+  [[nodiscard]] auto wait_and_pop(T& out) /* noexcept(std::is_nothrow_move_assignable_v<T>) */
+        -> bool
+      requires supports_empty<Container> && supports_pop_front<Container> &&
+               std::is_move_assignable_v<T>
+
+  {
+    unique_lock lk {spin_for_data()};
+    if (!wait_for_data(lk)) {
+      return false; // queue was request to stop, no data available
+    }
+    pop_front_into(out);
+    notify_space(lk, size_type(1));
+    return true;
+
+  }
+
+  /**
+   * @brief Pop a value from the @c wait_queue into a caller supplied object, if one is
+   * immediately available.
+   *
+   * @param out Object assigned the popped value, unchanged if @c false is returned.
+   *
+   * @return @c true if a value was popped, @c false if the @c wait_queue is empty or 
+   * has been requested to be stopped.
+   */
+  [[nodiscard]] auto try_pop(T& out) /* noexcept(std::is_nothrow_move_assignable_v<T>) */
+        -> bool
+      requires supports_empty<Container> && supports_pop_front<Container> &&
+               std::is_move_assignable_v<T>
+  {
+    if (m_stop_tok.stop_requested()) {
+      return false;
+    }
+    unique_lock lk{m_mut};
+    if (m_data_queue.empty()) {
+      return false;
+    }
+    pop_front_into(out);
+    notify_space(lk, size_type(1));
+    return true;
+
+  }
+
+  /**
+   * @brief Pop and return the first (oldest) value matching a predicate, if one is
+   * immediately available.
+   *
+   * The search and the erase are performed while the internal lock is held once, and
+   * the order of the remaining elements is not changed. This is useful, for example, to
+   * remove the reply matching a request id from a queue of replies.
+   *
+   * This method is available for containers supporting @c erase of an element,
+   * such as @c std::deque.
+   *
+   * @param pred Predicate invoked with a @c const @c T& on elements in FIFO order, 
+   * while the internal lock is held. The function object should have the signature:
+   * @code
+   * bool (const T&);
+   * @endcode
+   *
+   * @return The first value matching the predicate, or an empty @c std::optional if no
+   * value matches or the @c wait_queue has been requested to stop.
+   *
+   * @note The elements are searched linearly. It is undefined behavior if the predicate
+   * calls into the same @c wait_queue.
+   */
+  template <typename Pred>
+  [[nodiscard]] auto try_pop_if(Pred&& pred) /* noexcept */
+        -> std::optional<T>
+      requires supports_erase<Container> && std::is_invocable_r_v<bool, Pred&, const T&>
+  {
+    if (m_stop_tok.stop_requested()) {
+      return std::optional<T> {};
+    }
+    unique_lock lk{m_mut};
+    std::optional<T> val {pop_matching(pred)};
+    if (!val) {
+      return val;
+    }
+    notify_space(lk, size_type(1));
+    return val;
+
+  }
+
+  /**
+   * @brief Pop and return the first (oldest) value matching a predicate, blocking and
+   * waiting until a matching value is pushed by a writer thread.
+   *
+   * All reader threads are notified on a push while any thread is waiting in this
+   * method, and the elements are searched again on every wake up.
+   *
+   * @param pred Predicate, see @c try_pop_if.
+   *
+   * @return The first value matching the predicate, or an empty @c std::optional if the
+   * @c wait_queue has been requested to stop before a matching value is available.
+   */
+  template <typename Pred>
+  [[nodiscard]] auto wait_and_pop_if(Pred&& pred) /* noexcept */
+        -> std::optional<T>
+      requires supports_erase<Container> && std::is_invocable_r_v<bool, Pred&, const T&>
+  {
+    unique_lock lk{m_mut};
+    std::optional<T> val {pop_matching(pred)};
+    if (!val) {
+      const auto start = wait_start();
+      ++m_data_waiters;
+      ++m_pred_waiters;
+      m_data_cond.wait ( lk, m_stop_tok, [this, &pred, &val] { 
+          val = pop_matching(pred);
+          return val.has_value() || is_closed(); // no more pushes after a close
+        } );
+      --m_pred_waiters;
+      --m_data_waiters;
+      wait_end(start);
+      if (!val) {
+        return val; // queue was request to stop or closed, no matching data available
+      }
+    }
+    notify_space(lk, size_type(1));
+    return val;
+
+  }
+
+  /**
+   * @brief Pop multiple values from the @c wait_queue, blocking and waiting for a writer 
+   * thread to push a value if one is not immediately available.
+   *
+   * Once at least one value is available, up to @c max_n values are moved (or copied) 
+   * to the output iterator while the internal lock is held once.
+   *
+   * @param out Output iterator where the popped values will be written.
+   *
+   * @param max_n Maximum number of values to pop.
+   *
+   * @return Number of values popped. If 0 is returned, the @c wait_queue has been 
+   * requested to be stopped.
+   *
+   * @pre @c max_n is greater than 0.
+   *
+   * @post Until a push function is called, @c size is the returned count less than 
+   *   before this function was called.
+   */
+  template <std::output_iterator<T> OutputIt>
+  [[nodiscard]] auto wait_and_pop_many(OutputIt out, size_type max_n) /* noexcept */
+        -> size_type
+      requires supports_empty<Container> && supports_pop_front<Container>
+
+  {
+    assert(max_n > size_type(0));
+    unique_lock lk {spin_for_data()};
+    if (!wait_for_data(lk)) {
+      return size_type(0); // queue was request to stop, no data available
+    }
+    const auto cnt = pop_many(out, max_n);
+    notify_space(lk, cnt);
+    return cnt;
+
+  }
+
+  /**
+   * @brief Pop up to @c max_n values from the @c wait_queue if any are immediately 
+   * available, without blocking.
+   *
+   * @param out Output iterator where the popped values will be written.
+   *
+   * @param max_n Maximum number of values to pop.
+   *
+   * @return Number of values popped, which is 0 if the @c wait_queue is empty or has 
+   * been requested to be stopped.
+   *
+   * @post Until a push function is called, @c size is the returned count less than 
+   *   before this function was called.
+   */
+  template <std::output_iterator<T> OutputIt>
+  [[nodiscard]] auto try_pop_many(OutputIt out, size_type max_n) /* noexcept */
+        -> size_type
+      requires supports_empty<Container> && supports_pop_front<Container>
+
+  {
+    if (m_stop_tok.stop_requested()) {
+      return size_type(0);
+    }
+    unique_lock lk{m_mut};
+    const auto cnt = pop_many(out, max_n);
+    notify_space(lk, cnt);
+    return cnt;
+
+  }
+
+  /**
+   * @brief Invoke a function object on the front element in place, then pop it, if an
+   * element is immediately available.
+   *
+   * Unlike @c try_pop, the element is not moved (or copied) out of the container. This
+   * is useful for large or expensive to move elements, or for a container that is a view
+   * on external memory (such as a @c ring_span over a DMA buffer).
+   *
+   * @param func Function object invoked with a @c T& to the front element, while the
+   * internal lock is held.
+   *
+   * @return @c true if an element was consumed, @c false if the @c wait_queue is empty
+   * or has been requested to stop.
+   *
+   * @note The function object is invoked while the internal lock is held, so it should
+   * be short, and it is undefined behavior if it calls into the same @c wait_queue. If
+   * the function object throws, the element is not popped.
+   *
+   * @post If @c true is returned, until a push function is called, @c size is one
+   *   less than before this function was called.
+   */
+  template <typename F>
+  auto try_consume(F&& func)
+        -> bool
+      requires supports_empty<Container> && supports_pop_front<Container> &&
+               std::is_invocable_v<F, T&>
+
+  {
+    if (m_stop_tok.stop_requested()) {
+      return false;
+    }
+    unique_lock lk{m_mut};
+    if (m_data_queue.empty()) {
+      return false;
+    }
+    consume_front(func);
+    notify_space(lk, size_type(1));
+    return true;
+
+  }
+
+  /**
+   * @brief Invoke a function object on the front element in place, then pop it, blocking
+   * and waiting for a writer thread to push a value if one is not immediately available.
+   *
+   * @param func Function object invoked with a @c T& to the front element, while the
+   * internal lock is held.
+   *
+   * @return @c true if an element was consumed, @c false if the @c wait_queue has been
+   * requested to stop.
+   *
+   * @note See @c try_consume for function object requirements.
+   *
+   * @post If @c true is returned, until a push function is called, @c size is one
+   *   less than before this function was called.
+   */
+  template <typename F>
+  auto wait_and_consume(F&& func)
+        -> bool
+      requires supports_empty<Container> && supports_pop_front<Container> &&
+               std::is_invocable_v<F, T&>
+
+  {
+    unique_lock lk {spin_for_data()};
+    if (!wait_for_data(lk)) {
+      return false; // queue was request to stop, no data available
+    }
+    consume_front(func);
+    notify_space(lk, size_type(1));
+    return true;
+
+  }
+
+  /**
+   * @brief Invoke a function object on a contiguous span of front elements in place,
+   * then pop them, if any elements are immediately available.
+   *
+   * This method is available for containers providing @c front_span and
+   * @c pop_front(n), such as @c fixed_ring. The span contains up to @c max_n elements,
+   * and may contain fewer than are available in the @c wait_queue (for example when the
+   * elements wrap around the end of a ring buffer).
+   *
+   * @param func Function object invoked with a @c std::span<T> of the front elements,
+   * while the internal lock is held.
+   *
+   * @param max_n Maximum number of elements to consume.
+   *
+   * @return Number of elements consumed, which is 0 if the @c wait_queue is empty or
+   * has been requested to stop.
+   *
+   * @note See @c try_consume for function object requirements.
+   *
+   * @pre @c max_n is greater than 0.
+   */
+  template <typename F>
+  auto try_consume_span(F&& func, size_type max_n)
+        -> size_type
+      requires supports_front_span<Container> && std::is_invocable_v<F, std::span<T>>
+
+  {
+    assert(max_n > size_type(0));
+    if (m_stop_tok.stop_requested()) {
+      return size_type(0);
+    }
+    unique_lock lk{m_mut};
+    if (m_data_queue.empty()) {
+      return size_type(0);
+    }
+    const auto cnt = consume_span(func, max_n);
+    notify_space(lk, cnt);
+    return cnt;
+
+  }
+
+  /**
+   * @brief Invoke a function object on a contiguous span of front elements in place,
+   * then pop them, blocking and waiting for a writer thread to push a value if one
+   * is not immediately available.
+   *
+   * @param func Function object invoked with a @c std::span<T> of the front elements,
+   * while the internal lock is held.
+   *
+   * @param max_n Maximum number of elements to consume.
+   *
+   * @return Number of elements consumed. If 0 is returned, the @c wait_queue has been
+   * requested to be stopped.
+   *
+   * @note See @c try_consume_span for container requirements.
+   *
+   * @pre @c max_n is greater than 0.
+   */
+  template <typename F>
+  auto wait_and_consume_span(F&& func, size_type max_n)
+        -> size_type
+      requires supports_front_span<Container> && std::is_invocable_v<F, std::span<T>>
+
+  {
+    assert(max_n > size_type(0));
+    unique_lock lk {spin_for_data()};
+    if (!wait_for_data(lk)) {
+      return size_type(0); // queue was request to stop, no data available
+    }
+    const auto cnt = consume_span(func, max_n);
+    notify_space(lk, cnt);
+    return cnt;
+
+  }
+
+  /**
+   * @brief Remove all of the elements in the @c wait_queue and return them in a
+   * container, without blocking.
+   *
+   * The internal container is swapped with an empty container while the lock is held.
+   * If the container has an allocator, the empty container is constructed with a copy
+   * of the internal container's allocator (swapping containers with allocators that do
+   * not compare equal is undefined behavior for most containers).
+   *
+   * @return Container with all of the elements that were in the @c wait_queue, empty if 
+   * the @c wait_queue was empty or has been requested to stop.
+   *
+   * @post @c empty returns @c true (until a push function is called).
+   */
+  [[nodiscard]] auto drain() /* noexcept */
+        -> Container
+      requires std::is_default_constructible_v<Container> && std::swappable<Container> &&
+               supports_size<Container>
+
+  {
+    Container ctr { make_empty_container() };
+    [[maybe_unused]] auto cnt = drain(ctr);
+    return ctr;
+  }
+
+  /**
+   * @brief Remove all of the elements in the @c wait_queue by swapping the internal
+   * container with a caller supplied container, without blocking.
+   *
+   * This allows the caller to supply a container with memory already reserved, which 
+   * then becomes the internal container.
+   *
+   * @param ctr Container to swap with the internal container.
+   *
+   * @return Number of elements placed in @c ctr, which is 0 if the @c wait_queue was 
+   * empty or has been requested to stop.
+   *
+   * @pre @c ctr is empty, and if the container has an allocator it compares equal to
+   * the internal container's allocator.
+   *
+   * @post @c empty returns @c true (until a push function is called).
+   */
+  auto drain(Container& ctr) /* noexcept */
+        -> size_type
+      requires std::swappable<Container> && supports_size<Container>
+
+  {
+    if (m_stop_tok.stop_requested()) {
+      return size_type(0);
+    }
+    unique_lock lk{m_mut};
+    return swap_out(lk, ctr);
+  }
+
+  /**
+   * @brief Remove all of the elements in the @c wait_queue by moving them to an output 
+   * iterator, without blocking.
+   *
+   * This overload can be used with any container, including non-swappable containers
+   * such as a @c ring_span.
+   *
+   * @param out Output iterator where the elements will be written.
+   *
+   * @return Number of elements written, which is 0 if the @c wait_queue was empty or 
+   * has been requested to stop.
+   *
+   * @post @c empty returns @c true (until a push function is called).
+   */
+  template <std::output_iterator<T> OutputIt>
+  auto drain(OutputIt out) /* noexcept */
+        -> size_type
+      requires supports_empty<Container> && supports_pop_front<Container>
+
+  {
+    return try_pop_many(out, std::numeric_limits<size_type>::max());
+  }
+
+  /**
+   * @brief Remove all of the elements in the @c wait_queue and return them in a
+   * container, blocking and waiting for a writer thread to push a value if the
+   * @c wait_queue is empty.
+   *
+   * @return Container with all of the elements that were in the @c wait_queue. If the
+   * container is empty, the @c wait_queue has been requested to stop (or closed).
+   */
+  [[nodiscard]] auto wait_and_drain() /* noexcept */
+        -> Container
+      requires std::is_default_constructible_v<Container> && std::swappable<Container> &&
+               supports_size<Container>
+
+  {
+    Container ctr { make_empty_container() };
+    [[maybe_unused]] auto cnt = wait_and_drain(ctr);
+    return ctr;
+  }
+
+  /**
+   * @brief Remove all of the elements in the @c wait_queue by swapping the internal
+   * container with a caller supplied container, blocking and waiting for a writer
+   * thread to push a value if the @c wait_queue is empty.
+   *
+   * @param ctr Container to swap with the internal container.
+   *
+   * @return Number of elements placed in @c ctr. If 0 is returned, the @c wait_queue has 
+   * been requested to stop.
+   *
+   * @pre @c ctr is empty, and if the container has an allocator it compares equal to
+   * the internal container's allocator.
+   */
+  auto wait_and_drain(Container& ctr) /* noexcept */
+        -> size_type
+      requires std::swappable<Container> && supports_size<Container>
+
+  {
+    unique_lock lk {spin_for_data()};
+    if (!wait_for_data(lk)) {
+      return size_type(0); // queue was request to stop, no data available
+    }
+    return swap_out(lk, ctr);
+  }
+
+  /**
+   * @brief Remove all of the elements in the @c wait_queue by moving them to an output
+   * iterator, blocking and waiting for a writer thread to push a value if the 
+   * @c wait_queue is empty.
+   *
+   * @param out Output iterator where the elements will be written.
+   *
+   * @return Number of elements written. If 0 is returned, the @c wait_queue has been 
+   * requested to stop.
+   */
+  template <std::output_iterator<T> OutputIt>
+  auto wait_and_drain(OutputIt out) /* noexcept */
+        -> size_type
+      requires supports_empty<Container> && supports_pop_front<Container>
+
+  {
+    return wait_and_pop_many(out, std::numeric_limits<size_type>::max());
+  }
+
+  /**
+   * @brief Awaitable type returned from @c async_pop.
+   *
+   * The result of the @c co_await expression is a @c std::optional<T>, with the same
+   * semantics as the return value of @c wait_and_pop.
+   */
+  class pop_awaiter : private detail::awaiter_node {
+  private:
+    friend class wait_queue;
+    wait_queue&      m_wq;
+    std::optional<T> m_val { };
+
+    explicit pop_awaiter(wait_queue& wq) noexcept : m_wq(wq) { }
+
+  public:
+    auto await_ready() const noexcept -> bool { return false; }
+
+    auto await_suspend(std::coroutine_handle<> h) -> bool {
+      m_handle = h;
+      return m_wq.suspend_pop(*this);
+    }
+
+    auto await_resume() -> std::optional<T> { return std::move(m_val); }
+  };
+
+  /**
+   * @brief Awaitable type returned from @c async_push.
+   *
+   * The result of the @c co_await expression is a @c bool, with the same semantics
+   * as the return value of @c wait_and_push.
+   */
+  class push_awaiter : private detail::awaiter_node {
+  private:
+    friend class wait_queue;
+    wait_queue&      m_wq;
+    std::optional<T> m_val;
+    bool             m_ok {false};
+
+    push_awaiter(wait_queue& wq, T&& val) : m_wq(wq), m_val(std::move(val)) { }
+
+  public:
+    auto await_ready() const noexcept -> bool { return false; }
+
+    auto await_suspend(std::coroutine_handle<> h) -> bool {
+      m_handle = h;
+      return m_wq.suspend_push(*this);
+    }
+
+    auto await_resume() const noexcept -> bool { return m_ok; }
+  };
+
+  /**
+   * @brief Pop a value from the @c wait_queue in a coroutine, suspending the coroutine
+   * (instead of blocking the thread) if a value is not immediately available.
+   *
+   * A suspended coroutine is kept in an intrusive list inside the @c wait_queue (there 
+   * is no memory allocation). When a value is pushed, it is transferred directly to a
+   * suspended coroutine (in preference to a thread blocked in @c wait_and_pop), which 
+   * is resumed in the pushing thread after the internal lock is released.
+   *
+   * When a stop is requested, all suspended coroutines are resumed (in the thread 
+   * requesting the stop) with an empty @c std::optional.
+   *
+   * @code
+   *   auto val = co_await wq.async_pop();
+   *   if (!val) { // stop requested
+   *   }
+   * @endcode
+   *
+   * @return An awaitable object, where the @c co_await result is a @c std::optional<T>.
+   *
+   * @note The @c wait_queue must outlive any suspended coroutines.
+   */
+  [[nodiscard]] auto async_pop() noexcept
+        -> pop_awaiter
+      requires supports_empty<Container> && supports_pop_front<Container>
+
+  {
+    return pop_awaiter { *this };
+  }
+
+  /**
+   * @brief Pop a value from the @c wait_queue in a coroutine, with a suspended 
+   * coroutine resumed through an executor.
+   *
+   * This method has the same semantics as the other @c async_pop, except that a 
+   * suspended coroutine is resumed by invoking the executor with the coroutine handle 
+   * (e.g. posting the handle to a thread pool or event loop), instead of being resumed 
+   * inline in the pushing (or stopping) thread.
    *
-   * @post If a non empty value is returned, until a push function is called, @c size is one
-   *   less than before this function was called.
+   * @param exec Function object invoked as @c exec(std::coroutine_handle<>). It must 
+   * remain valid while the coroutine is suspended.
+   *
+   * @return An awaitable object, where the @c co_await result is a @c std::optional<T>.
    */
-  [[nodiscard]] auto try_pop() /* noexcept(std::is_nothrow_constructible_v<T>) */
-        -> std::optional<T> 
+  template <std::invocable<std::coroutine_handle<>> E>
+  [[nodiscard]] auto async_pop(E& exec) noexcept
+        -> pop_awaiter
       requires supports_empty<Container> && supports_pop_front<Container>
+
   {
-    if (m_stop_tok.stop_requested()) {
-      return std::optional<T> {};
-    }
-    lock_guard lk{m_mut};
-    if (m_data_queue.empty()) {
-      return std::optional<T> {};
-    }
-#ifndef NDEBUG
-    const auto old_size = m_data_queue.size();
-#endif
-    std::optional<T> val {std::move_if_noexcept(m_data_queue.front())}; // move construct if possible
-    m_data_queue.pop_front();
-    assert(m_data_queue.size() + 1u == old_size);
-    return val;
+    pop_awaiter aw { *this };
+    set_executor(aw, exec);
+    return aw;
+  }
+
+  /**
+   * @brief Push a value to the @c wait_queue in a coroutine, suspending the coroutine
+   * (instead of blocking the thread) if the container is full.
+   *
+   * This method is only available for containers that support a @c full method. When
+   * a value is popped, the value of a suspended coroutine is pushed and the coroutine 
+   * resumed in the popping thread. When a stop is requested, all suspended coroutines 
+   * are resumed with a @c false result.
+   *
+   * @param val Value to be moved (or copied) into the queue, owned by the awaitable 
+   * object while suspended.
+   *
+   * @return An awaitable object, where the @c co_await result is a @c bool.
+   */
+  [[nodiscard]] auto async_push(T val)
+        -> push_awaiter
+    requires supports_push_back<Container, T> && supports_full<Container>
+
+  {
+    return push_awaiter { *this, std::move(val) };
+  }
+
+  /**
+   * @brief Push a value to the @c wait_queue in a coroutine, with a suspended 
+   * coroutine resumed through an executor.
+   *
+   * @param exec Function object invoked as @c exec(std::coroutine_handle<>).
+   *
+   * @param val Value to be moved (or copied) into the queue.
+   *
+   * @return An awaitable object, where the @c co_await result is a @c bool.
+   */
+  template <std::invocable<std::coroutine_handle<>> E>
+  [[nodiscard]] auto async_push(E& exec, T val)
+        -> push_awaiter
+    requires supports_push_back<Container, T> && supports_full<Container>
 
+  {
+    push_awaiter aw { *this, std::move(val) };
+    set_executor(aw, exec);
+    return aw;
   }
 
   // non-modifying methods
@@ -592,6 +2409,27 @@ public:
 
   }
 
+  /**
+   * @brief Attach (or detach) an @c event_count which is notified whenever data is
+   * pushed and when a stop is requested.
+   *
+   * This is used by @c queue_select (and @c wait_any) to wait on multiple queues with
+   * one blocking call. At most one notifier can be attached at a time. The notifier is
+   * signaled while the internal lock is held, so once this method returns after
+   * detaching, the notifier will not be accessed again.
+   *
+   * @param ev Pointer to the @c event_count, or @c nullptr to detach.
+   *
+   * @pre If @c ev is not @c nullptr, no notifier is currently attached.
+   */
+  auto set_notifier(event_count* ev) /* noexcept */
+        -> void
+  {
+    lock_guard lk{m_mut};
+    assert(ev == nullptr || m_notifier == nullptr);
+    m_notifier = ev;
+  }
+
   /**
    * Query whether a @ request_stop method has been called on 
    * the @c wait_queue.
@@ -605,6 +2443,17 @@ public:
     return m_stop_tok.stop_requested();
   }
 
+  /**
+   * Query whether a @c close method has been called on the @c wait_queue.
+   *
+   * @return @c true if @c close has been called. Values may still be available to pop.
+   */
+  [[nodiscard]] auto closed() const noexcept
+        -> bool
+  {
+    return is_closed();
+  }
+
   /**
    * Query whether the @c wait_queue is empty or not.
    *
@@ -635,6 +2484,547 @@ public:
 
   }
 
+  /**
+   * @brief Query whether the @c wait_queue is empty or not, without acquiring the lock.
+   *
+   * The element count is updated inside the lock protected sections that change the
+   * container, so this can be frequently called (e.g. by a load balancer probing many 
+   * queues) without contending with writer or reader threads.
+   *
+   * @return @c true if the @c wait_queue was empty at some recent point in time; the
+   * result may be stale by the time it is used. Use @c empty for an exact answer.
+   */
+  [[nodiscard]] auto approx_empty() const noexcept
+        -> bool
+      requires supports_size<Container>
+  {
+    return approx_size() == size_type(0);
+  }
+
+  /**
+   * @brief Get the number of elements in the @c wait_queue, without acquiring the lock.
+   *
+   * @return Number of elements at some recent point in time, see @c approx_empty. Use
+   * @c size for an exact answer.
+   */
+  [[nodiscard]] auto approx_size() const noexcept
+        -> size_type
+      requires supports_size<Container>
+  {
+    return m_approx_size.load(std::memory_order_relaxed);
+  }
+
+  /**
+   * Get a snapshot of the instrumentation counters.
+   *
+   * The internal lock is not acquired, so this method can be frequently called (e.g. 
+   * from a metrics exporting thread) without contending with writer or reader threads.
+   *
+   * @return A @c queue_stats object, with all counters 0 if the stats policy is 
+   * @c null_stats.
+   */
+  [[nodiscard]] auto stats() const noexcept
+        -> queue_stats
+  {
+    return m_stats.snapshot();
+  }
+
+private:
+
+  // the lock is held on entry and released before notifying, so a woken thread
+  // does not immediately block on m_mut; the condition variable is only notified 
+  // if a thread is waiting
+  static auto notify_waiters(unique_lock& lk, std::condition_variable_any& cond,
+                             std::size_t waiters, size_type cnt) noexcept
+        -> void
+  {
+    lk.unlock();
+    if (waiters == 0u || cnt == size_type(0)) {
+      return;
+    }
+    if (cnt == size_type(1) || waiters == 1u) {
+      cond.notify_one();
+    }
+    else {
+      cond.notify_all();
+    }
+  }
+
+  auto is_closed() const noexcept
+        -> bool
+  {
+    return m_closed.load(std::memory_order_relaxed);
+  }
+
+  // lock must be held by caller; pushes are rejected after a close with the lock held,
+  // so that no value can be pushed after a reader has seen the end of the stream
+  auto reject_closed() noexcept
+        -> bool
+  {
+    if (is_closed()) {
+      m_stats.record_reject();
+      return true;
+    }
+    return false;
+  }
+
+  // lock must be held by caller; number of values that can be pushed (overwriting the
+  // oldest visible elements of a full container) without touching a reserved slot, which
+  // another thread may be constructing into without the lock
+  auto overwrite_room() const noexcept
+        -> size_type
+  {
+    if constexpr (supports_reserve<Container>) {
+      if (m_data_queue.pending() != size_type(0)) {
+        return m_data_queue.available() + m_data_queue.size();
+      }
+    }
+    return std::numeric_limits<size_type>::max();
+  }
+
+  // lock must be held by caller
+  auto reject_overwrite(size_type n) noexcept
+        -> bool
+  {
+    if (overwrite_room() < n) {
+      m_stats.record_reject();
+      return true;
+    }
+    return false;
+  }
+
+  auto current_size() const noexcept
+        -> size_type
+  {
+    if constexpr (supports_size<Container>) {
+      return static_cast<size_type>(m_data_queue.size());
+    }
+    else {
+      return size_type(0);
+    }
+  }
+
+  // lock must be held by caller
+  auto store_approx_size() noexcept
+        -> void
+  {
+    m_approx_size.store(current_size(), std::memory_order_relaxed);
+  }
+
+  // lock must be held by caller
+  auto record_push(size_type cnt) noexcept
+        -> void
+  {
+    if constexpr (StatsPolicy::enabled && supports_size<Container>) {
+      m_stats.record_push(cnt, m_data_queue.size());
+    }
+    else {
+      m_stats.record_push(cnt, 0u);
+    }
+  }
+
+  // lock must be held by caller; values are transferred to suspended async_pop 
+  // coroutines, which are resumed by the caller after the lock is released
+  auto take_pop_awaiters(detail::awaiter_list& ready)
+        -> size_type
+  {
+    size_type cnt {0};
+    if constexpr (supports_empty<Container> && supports_pop_front<Container>) {
+      while (!m_pop_awaiters.empty() && !m_data_queue.empty()) {
+        auto* aw = static_cast<pop_awaiter*>(m_pop_awaiters.pop_front());
+        aw->m_val.emplace(std::move_if_noexcept(m_data_queue.front()));
+        m_data_queue.pop_front();
+        ready.push_back(aw);
+        ++cnt;
+      }
+    }
+    m_stats.record_pop(cnt);
+    return cnt;
+  }
+
+  // lock must be held by caller; values from suspended async_push coroutines are 
+  // pushed while there is space, resumed by the caller after the lock is released
+  auto take_push_awaiters(detail::awaiter_list& ready)
+        -> size_type
+  {
+    size_type cnt {0};
+    if constexpr (supports_full<Container> && supports_push_back<Container, T>) {
+      while (!m_push_awaiters.empty() && !m_data_queue.full()) {
+        auto* aw = static_cast<push_awaiter*>(m_push_awaiters.pop_front());
+        m_data_queue.push_back(std::move(*(aw->m_val)));
+        aw->m_ok = true;
+        ready.push_back(aw);
+        ++cnt;
+      }
+    }
+    record_push(cnt);
+    return cnt;
+  }
+
+  // lock must be held by caller, so that the notifier cannot be detached (and
+  // destroyed) while it is being signaled
+  auto signal_notifier(size_type cnt) noexcept
+        -> void
+  {
+    if (m_notifier != nullptr && cnt != size_type(0)) {
+      m_notifier->notify_all();
+    }
+  }
+
+  // called with the lock held after every successful push of cnt elements, the 
+  // lock is released on return
+  auto notify_data(unique_lock& lk, size_type cnt)
+        -> void
+  {
+    record_push(cnt);
+    detail::awaiter_list ready;
+    if (!m_pop_awaiters.empty()) {
+      cnt -= take_pop_awaiters(ready);
+    }
+    store_approx_size();
+    signal_notifier(cnt);
+    // a reader waiting for a matching element may not be able to use a single notification
+    if (m_pred_waiters != 0u && cnt != size_type(0)) {
+      cnt = std::numeric_limits<size_type>::max();
+    }
+    notify_waiters(lk, m_data_cond, m_data_waiters, cnt);
+    ready.resume_all();
+  }
+
+  // called with the lock held after every successful pop of cnt elements, the 
+  // lock is released on return; only bounded containers have writers waiting for space
+  auto notify_space(unique_lock& lk, size_type cnt)
+        -> void
+  {
+    m_stats.record_pop(cnt);
+    if constexpr (supports_full<Container>) {
+      detail::awaiter_list ready;
+      size_type pushed {0};
+      if (!m_push_awaiters.empty()) {
+        pushed = take_push_awaiters(ready);
+        cnt -= pushed;
+      }
+      store_approx_size();
+      signal_notifier(pushed);
+      const auto data_waiters = m_data_waiters;
+      // a writer waiting for multiple slots may not be able to use a single notification
+      if (m_reserve_waiters != 0u && cnt != size_type(0)) {
+        cnt = std::numeric_limits<size_type>::max();
+      }
+      notify_waiters(lk, m_space_cond, m_space_waiters, cnt);
+      if (data_waiters != 0u && pushed != size_type(0)) {
+        m_data_cond.notify_all();
+      }
+      ready.resume_all();
+    }
+    else {
+      store_approx_size();
+      lk.unlock();
+    }
+  }
+
+  // returns false if the coroutine is not to be suspended (a value was popped, or
+  // a stop was requested)
+  auto suspend_pop(pop_awaiter& aw)
+        -> bool
+  {
+    unique_lock lk{m_mut};
+    if (!m_data_queue.empty()) {
+      aw.m_val.emplace(std::move_if_noexcept(m_data_queue.front()));
+      m_data_queue.pop_front();
+      notify_space(lk, size_type(1));
+      return false;
+    }
+    if (m_stop_tok.stop_requested() || is_closed()) {
+      return false;
+    }
+    m_pop_awaiters.push_back(&aw);
+    return true; // aw must not be accessed after the lock is released
+  }
+
+  auto suspend_push(push_awaiter& aw)
+        -> bool
+  {
+    unique_lock lk{m_mut};
+    if (m_stop_tok.stop_requested() || is_closed()) {
+      m_stats.record_reject();
+      return false;
+    }
+    if (!m_data_queue.full()) {
+      m_data_queue.push_back(std::move(*(aw.m_val)));
+      aw.m_ok = true;
+      notify_data(lk, size_type(1));
+      return false;
+    }
+    m_push_awaiters.push_back(&aw);
+    return true; // aw must not be accessed after the lock is released
+  }
+
+  template <typename A, typename E>
+  static auto set_executor(A& aw, E& exec) noexcept
+        -> void
+  {
+    aw.m_exec = &exec;
+    aw.m_post = [] (void* ex, std::coroutine_handle<> h) { (*static_cast<E*>(ex))(h); };
+  }
+
+  // invoked from the stop callback, in the thread requesting the stop
+  auto resume_stopped() noexcept
+        -> void
+  {
+    detail::awaiter_list ready;
+    {
+      unique_lock lk{m_mut};
+      if (m_notifier != nullptr) {
+        m_notifier->notify_all();
+      }
+      // values are still transferred if available, matching wait_and_pop semantics
+      take_pop_awaiters(ready);
+      store_approx_size();
+      while (!m_pop_awaiters.empty()) {
+        ready.push_back(m_pop_awaiters.pop_front());
+      }
+      while (!m_push_awaiters.empty()) {
+        m_stats.record_reject();
+        ready.push_back(m_push_awaiters.pop_front());
+      }
+    }
+    ready.resume_all();
+  }
+
+  // spin phase of the wait policy, returns with the lock held, either with data 
+  // available, stop requested, or spinning complete
+  template <typename F>
+  auto spin_for_data_while(F&& keep_spinning)
+        -> unique_lock
+  {
+    unique_lock lk{m_mut, std::defer_lock};
+    if constexpr (WaitPolicy::spin_count > 0u || !WaitPolicy::blocking) {
+      for (std::size_t i {0u}; (!WaitPolicy::blocking || i < WaitPolicy::spin_count) && keep_spinning(); ++i) {
+        // the lock is only tried when the lock-free count shows data (or a stop)
+        if ((!has_approx_size || m_approx_size.load(std::memory_order_relaxed) != 0u ||
+             m_stop_tok.stop_requested() || is_closed()) && lk.try_lock()) {
+          if (!m_data_queue.empty() || m_stop_tok.stop_requested() || is_closed()) {
+            return lk;
+          }
+          lk.unlock();
+        }
+        WaitPolicy::relax();
+      }
+    }
+    lk.lock();
+    return lk;
+  }
+
+  auto spin_for_data()
+        -> unique_lock
+  {
+    return spin_for_data_while( [] { return true; } );
+  }
+
+  template <typename Clock, typename Duration>
+  auto spin_for_data(const std::chrono::time_point<Clock, Duration>& abs_time)
+        -> unique_lock
+  {
+    return spin_for_data_while( [&abs_time] { return Clock::now() < abs_time; } );
+  }
+
+  // the clock is only read when stats are enabled
+  static auto wait_start() noexcept
+        -> std::chrono::steady_clock::time_point
+  {
+    if constexpr (StatsPolicy::enabled) {
+      return std::chrono::steady_clock::now();
+    }
+    else {
+      return std::chrono::steady_clock::time_point { };
+    }
+  }
+
+  auto wait_end(std::chrono::steady_clock::time_point start) noexcept
+        -> void
+  {
+    if constexpr (StatsPolicy::enabled) {
+      m_stats.record_wait(std::chrono::duration_cast<std::chrono::nanoseconds>(
+                            std::chrono::steady_clock::now() - start));
+    }
+  }
+
+  // lock must be held through lk
+  auto wait_for_data(unique_lock& lk)
+        -> bool
+  {
+    if (!m_data_queue.empty()) {
+      return true;
+    }
+    const auto start = wait_start();
+    ++m_data_waiters;
+    const bool ok = m_data_cond.wait ( lk, m_stop_tok, [this] { return !m_data_queue.empty() || 
+                                                                   is_closed(); } );
+    --m_data_waiters;
+    wait_end(start);
+    return ok && !m_data_queue.empty();
+  }
+
+  // lock must be held through lk
+  template <typename Clock, typename Duration>
+  auto wait_for_data_until(unique_lock& lk, const std::chrono::time_point<Clock, Duration>& abs_time)
+        -> bool
+  {
+    if (!m_data_queue.empty()) {
+      return true;
+    }
+    const auto start = wait_start();
+    ++m_data_waiters;
+    const bool ok = m_data_cond.wait_until ( lk, m_stop_tok, abs_time, 
+                                             [this] { return !m_data_queue.empty() || 
+                                                             is_closed(); } );
+    --m_data_waiters;
+    wait_end(start);
+    return ok && !m_data_queue.empty();
+  }
+
+  // lock must be held through lk
+  auto wait_for_space(unique_lock& lk)
+        -> bool
+    requires supports_full<Container>
+  {
+    if (m_stop_tok.stop_requested() || is_closed()) {
+      return false;
+    }
+    if (!m_data_queue.full()) {
+      return true;
+    }
+    ++m_space_waiters;
+    const bool ok = m_space_cond.wait ( lk, m_stop_tok, [this] { return !m_data_queue.full() ||
+                                                                    is_closed(); } );
+    --m_space_waiters;
+    return ok && !m_stop_tok.stop_requested() && !is_closed();
+  }
+
+  // lock must be held by caller
+  auto wait_for_slots(unique_lock& lk, size_type n)
+        -> bool
+    requires supports_reserve<Container>
+  {
+    if (m_stop_tok.stop_requested() || is_closed()) {
+      return false;
+    }
+    if (m_data_queue.available() >= n) {
+      return true;
+    }
+    ++m_space_waiters;
+    m_reserve_waiters += (n > size_type(1)) ? 1u : 0u;
+    const bool ok = m_space_cond.wait ( lk, m_stop_tok, 
+                        [this, n] { return m_data_queue.available() >= n || is_closed(); } );
+    m_reserve_waiters -= (n > size_type(1)) ? 1u : 0u;
+    --m_space_waiters;
+    return ok && !m_stop_tok.stop_requested() && !is_closed();
+  }
+
+  // lock must be held by caller
+  auto pop_front_value()
+        -> std::optional<T>
+  {
+    assert(!m_data_queue.empty());
+#ifndef NDEBUG
+    const auto old_size = m_data_queue.size();
+#endif
+    std::optional<T> val {std::move_if_noexcept(m_data_queue.front())}; // move construct if possible
+    m_data_queue.pop_front();
+    assert(m_data_queue.size() + 1u == old_size);
+    return val;
+  }
+
+  // lock must be held by caller
+  auto pop_front_into(T& out)
+        -> void
+  {
+    assert(!m_data_queue.empty());
+    out = std::move(m_data_queue.front()); // element is popped, so always move assign
+    m_data_queue.pop_front();
+  }
+
+  // lock must be held by caller
+  template <typename Pred>
+  auto pop_matching(Pred& pred)
+        -> std::optional<T>
+  {
+    for (auto it = m_data_queue.begin(); it != m_data_queue.end(); ++it) {
+      if (pred(std::as_const(*it))) {
+        std::optional<T> val {std::move_if_noexcept(*it)}; // move construct if possible
+        m_data_queue.erase(it);
+        return val;
+      }
+    }
+    return std::optional<T> {};
+  }
+
+  // lock must be held by caller
+  template <typename F>
+  auto consume_front(F& func)
+        -> void
+  {
+    assert(!m_data_queue.empty());
+    func(m_data_queue.front());
+    m_data_queue.pop_front();
+  }
+
+  // lock must be held by caller
+  template <typename F>
+  auto consume_span(F& func, size_type max_n)
+        -> size_type
+  {
+    assert(!m_data_queue.empty());
+    std::span<T> elems { m_data_queue.front_span() };
+    if (elems.size() > max_n) {
+      elems = elems.first(max_n);
+    }
+    func(elems);
+    const auto cnt = static_cast<size_type>(elems.size());
+    m_data_queue.pop_front(cnt);
+    return cnt;
+  }
+
+  auto make_empty_container() const
+        -> Container
+  {
+    if constexpr (requires { m_data_queue.get_allocator(); } &&
+                  std::is_constructible_v<Container, const allocator_type&>) {
+      return Container(m_data_queue.get_allocator());
+    }
+    else {
+      return Container { };
+    }
+  }
+
+  // lock is held on entry and released on return
+  auto swap_out(unique_lock& lk, Container& ctr)
+        -> size_type
+  {
+    assert(ctr.size() == 0u);
+    using std::swap;
+    swap(m_data_queue, ctr);
+    const auto cnt = static_cast<size_type>(ctr.size());
+    notify_space(lk, cnt);
+    return cnt;
+  }
+
+  // lock must be held by caller
+  template <typename OutputIt>
+  auto pop_many(OutputIt& out, size_type max_n)
+        -> size_type
+  {
+    size_type cnt {0};
+    while (cnt < max_n && !m_data_queue.empty()) {
+      *out = std::move_if_noexcept(m_data_queue.front()); // move if possible
+      ++out;
+      m_data_queue.pop_front();
+      ++cnt;
+    }
+    return cnt;
+  }
+
 };
 
 } // end namespace
@@ -0,0 +1,346 @@
+/** @file
+ *
+ * @brief Work stealing queue set, for use as the task queue of a thread pool.
+ *
+ * A @c work_stealing_queue contains one task deque per worker thread, plus a global
+ * injection @c wait_queue for tasks submitted from outside of the worker threads.
+ *
+ * A worker thread pushes tasks (typically tasks spawned by a running task) to its own
+ * deque, and pops from its own deque in LIFO order, which keeps recently created (and
+ * cache warm) tasks on the same worker. When a worker's own deque is empty, it pops from
+ * the injection queue, and then steals from the other workers' deques in FIFO order
+ * (taking the oldest tasks, which are typically the largest units of work). Each deque
+ * has its own lock, so workers only contend with each other when stealing.
+ *
+ * An idle worker (all deques and the injection queue are empty) blocks on a shared
+ * @c event_count, which is notified after each push or submit (the notification is a
+ * fence and a load when no workers are blocked).
+ *
+ * Shutdown semantics are the same as @c wait_queue: a @c std::stop_token can be passed in
+ * to the constructor, or @c request_stop called. Once a stop is requested, blocked
+ * worker threads are woken and @c wait_and_pop returns an empty @c std::optional.
+ *
+ * Example usage, thread pool worker loop:
+ *
+ * @code
+ *   using task = std::function<void (std::size_t)>; // passed the worker index
+ *   chops::work_stealing_queue<task> wsq { num_workers };
+ *
+ *   // inside worker thread idx
+ *   while (auto tsk = wsq.wait_and_pop(idx)) {
+ *     (*tsk)(idx); // the task may call wsq.push(idx, ...) to spawn more tasks
+ *   }
+ *
+ *   // any other thread
+ *   wsq.submit( [] (std::size_t) { ... } );
+ *   ...
+ *   wsq.request_stop();
+ * @endcode
+ *
+ * @author Cliff Green
+ *
+ * @copyright (c) 2024 by Cliff Green
+ *
+ * Distributed under the Boost Software License, Version 1.0.
+ * (See accompanying file LICENSE.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+ *
+ */
+
+#ifndef WORK_STEALING_QUEUE_HPP_INCLUDED
+#define WORK_STEALING_QUEUE_HPP_INCLUDED
+
+#include <cassert> // assert
+#include <cstddef> // std::size_t
+#include <deque>
+#include <memory> // std::unique_ptr, std::make_unique
+#include <mutex> // std::scoped_lock, std::mutex
+#include <stop_token> // std::stop_source, std::stop_token, std::stop_callback
+#include <optional>
+#include <utility> // std::move, std::move_if_noexcept
+#include <type_traits> // for requires clauses
+
+#include "queue/wait_queue.hpp"
+#include "queue/sync_utility.hpp"
+
+namespace chops {
+
+/**
+ * @brief Set of per-worker task deques with work stealing, plus a global injection
+ * queue, with shutdown semantics.
+ *
+ * @tparam T Type of task (or other value) passed through the queue, for example
+ * @c std::function<void()>.
+ *
+ * @pre The value type must be either copy constructible or move constructible.
+ *
+ */
+template <typename T>
+  requires std::is_copy_constructible_v<T> || std::is_move_constructible_v<T>
+class work_stealing_queue {
+public:
+
+  using size_type = std::size_t;
+  using value_type = T;
+
+private:
+
+  // each worker owns its cache lines, avoiding false sharing between worker locks
+  struct alignas(cache_line_size) worker_deque {
+    mutable std::mutex m_mut;
+    std::deque<T>      m_tasks;
+  };
+
+  using lock_guard = std::scoped_lock<std::mutex>;
+
+  detail::stoppable_event                    m_sync;
+  size_type                                  m_num_workers;
+  std::unique_ptr<worker_deque[]>            m_workers;
+  wait_queue<T>                              m_inject;
+
+public:
+
+  /**
+   * @brief Construct a @c work_stealing_queue for a number of worker threads.
+   *
+   * An internal @c stop_source is used to provide a @c std::stop_token for
+   * coordinating shutdown.
+   *
+   * @param num_workers Number of worker threads, each with its own deque.
+   *
+   * @pre @c num_workers is greater than 0.
+   *
+   * @post @c empty returns @c true.
+   * @post @c stop_requested returns @c false.
+   */
+  explicit work_stealing_queue(size_type num_workers)
+      : m_sync(),
+        m_num_workers(num_workers), m_workers(std::make_unique<worker_deque[]>(num_workers)),
+        m_inject(m_sync.token())
+  {
+    assert(num_workers > 0u);
+    assert(empty());
+    assert(!stop_requested());
+  }
+
+  /**
+   * @brief Construct a @c work_stealing_queue for a number of worker threads, with an
+   * externally provided @c std::stop_token.
+   *
+   * @param stop_tok A @c std::stop_token which can be used to shutdown queue processing.
+   *
+   * @param num_workers Number of worker threads, each with its own deque.
+   *
+   * @pre @c num_workers is greater than 0.
+   *
+   * @post @c empty returns @c true.
+   */
+  work_stealing_queue(std::stop_token stop_tok, size_type num_workers)
+      : m_sync(stop_tok),
+        m_num_workers(num_workers), m_workers(std::make_unique<worker_deque[]>(num_workers)),
+        m_inject(m_sync.token())
+  {
+    assert(num_workers > 0u);
+    assert(empty());
+  }
+
+  // disallow copy or move construction of the entire object
+  work_stealing_queue(const work_stealing_queue&) = delete;
+  work_stealing_queue(work_stealing_queue&&) = delete;
+
+  // disallow copy or move assigment of the entire object
+  work_stealing_queue& operator=(const work_stealing_queue&) = delete;
+  work_stealing_queue& operator=(work_stealing_queue&&) = delete;
+
+  // modifying methods
+
+  /**
+   * @brief Request the @c work_stealing_queue to stop processing, unless a
+   * @c std::stop_token was passed in to a constructor.
+   *
+   * @return @c true if an internal @c stop_source was used and the request returns
+   * @c true, @c false if an external @c std::stop_token was passed in.
+   */
+  auto request_stop() noexcept
+        -> bool
+  {
+    return m_sync.request_stop();
+  }
+
+  /**
+   * @brief Submit a task from outside of the worker threads, to the injection queue.
+   *
+   * @param val Task to be moved (or copied) into the queue.
+   *
+   * @return @c true if successful, @c false if the queue has been requested to stop.
+   */
+  auto submit(T val) /* noexcept(std::is_nothrow_move_constructible_v<T>) */
+        -> bool
+  {
+    if (!m_inject.push(std::move(val))) {
+      return false;
+    }
+    m_sync.notify_one();
+    return true;
+  }
+
+  /**
+   * @brief Push a task to a worker's own deque, called from the worker thread.
+   *
+   * @param idx Index of the calling worker.
+   *
+   * @param val Task to be moved (or copied) into the queue.
+   *
+   * @return @c true if successful, @c false if the queue has been requested to stop.
+   *
+   * @pre @c idx is less than @c worker_count.
+   */
+  auto push(size_type idx, T val) /* noexcept(std::is_nothrow_move_constructible_v<T>) */
+        -> bool
+  {
+    assert(idx < m_num_workers);
+    if (m_sync.stop_requested()) {
+      return false;
+    }
+    {
+      lock_guard lk{m_workers[idx].m_mut};
+      m_workers[idx].m_tasks.push_back(std::move(val));
+    }
+    m_sync.notify_one();
+    return true;
+  }
+
+  /**
+   * @brief Pop a task for a worker, blocking and waiting if there are no tasks
+   * in any deque or in the injection queue.
+   *
+   * @param idx Index of the calling worker.
+   *
+   * @return A task. If the @c std::optional is empty, the queue has been requested to
+   * be stopped.
+   *
+   * @pre @c idx is less than @c worker_count.
+   */
+  [[nodiscard]] auto wait_and_pop(size_type idx) /* noexcept(std::is_nothrow_constructible_v<T>) */
+        -> std::optional<T>
+  {
+    return m_sync.wait_and_pop([this, idx] { return try_pop(idx); });
+  }
+
+  /**
+   * @brief Pop a task for a worker if one is immediately available.
+   *
+   * The worker's own deque is checked first (newest task), then the injection queue,
+   * then the other workers' deques are stolen from (oldest task).
+   *
+   * @param idx Index of the calling worker.
+   *
+   * @return A task or an empty @c std::optional if there are no tasks or the queue
+   * has been requested to stop.
+   *
+   * @pre @c idx is less than @c worker_count.
+   */
+  [[nodiscard]] auto try_pop(size_type idx) /* noexcept(std::is_nothrow_constructible_v<T>) */
+        -> std::optional<T>
+  {
+    assert(idx < m_num_workers);
+    if (m_sync.stop_requested()) {
+      return std::optional<T> {};
+    }
+    if (auto val = pop_own(m_workers[idx]); val) {
+      return val;
+    }
+    if (auto val = m_inject.try_pop(); val) {
+      return val;
+    }
+    // own deque already checked, steal from the others starting with the next worker
+    return detail::try_pop_each(idx, m_num_workers, [this, idx] (size_type i) {
+        return (i == idx) ? std::optional<T> {} : steal(m_workers[i]);
+      } );
+  }
+
+  // non-modifying methods
+
+  /**
+   * Query whether a @ request_stop method has been called on the queue.
+   *
+   * @return @c true if the @c stop_requested has been called.
+   */
+  [[nodiscard]] auto stop_requested() const noexcept
+        -> bool
+  {
+    return m_sync.stop_requested();
+  }
+
+  /**
+   * Query whether every deque and the injection queue are empty.
+   *
+   * @return @c true if there are no tasks (each deque is checked in turn, so the
+   * result may be out of date if other threads are pushing or popping).
+   */
+  [[nodiscard]] auto empty() const /* noexcept */
+        -> bool
+  {
+    return size() == size_type(0);
+  }
+
+  /**
+   * Get the number of tasks in all deques plus the injection queue.
+   *
+   * @return Total number of tasks (each deque is checked in turn).
+   */
+  [[nodiscard]] auto size() const /* noexcept */
+        -> size_type
+  {
+    size_type sz { m_inject.size() };
+    for (size_type i {0u}; i < m_num_workers; ++i) {
+      lock_guard lk{m_workers[i].m_mut};
+      sz += m_workers[i].m_tasks.size();
+    }
+    return sz;
+  }
+
+  /**
+   * Get the number of workers.
+   *
+   * @return Number of workers, as specified in the constructor.
+   */
+  [[nodiscard]] auto worker_count() const noexcept
+        -> size_type
+  {
+    return m_num_workers;
+  }
+
+private:
+
+  // owner pops newest
+  static auto pop_own(worker_deque& wd)
+        -> std::optional<T>
+  {
+    lock_guard lk{wd.m_mut};
+    if (wd.m_tasks.empty()) {
+      return std::optional<T> {};
+    }
+    std::optional<T> val {std::move_if_noexcept(wd.m_tasks.back())};
+    wd.m_tasks.pop_back();
+    return val;
+  }
+
+  // thieves pop oldest
+  static auto steal(worker_deque& wd)
+        -> std::optional<T>
+  {
+    lock_guard lk{wd.m_mut};
+    if (wd.m_tasks.empty()) {
+      return std::optional<T> {};
+    }
+    std::optional<T> val {std::move_if_noexcept(wd.m_tasks.front())};
+    wd.m_tasks.pop_front();
+    return val;
+  }
+
+};
+
+} // end namespace
+
+#endif
+
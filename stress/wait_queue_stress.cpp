@@ -0,0 +1,700 @@
+/** @file
+ *
+ * @brief Stress and contention harness for @c wait_queue, with a throughput regression
+ * gate against a stored baseline.
+ *
+ * Two phases are run for each queue type: a @c wait_queue with each container type
+ * (@c std::deque, @c std::pmr::deque with a synchronized pool, @c fixed_ring with a
+ * compile time and a run time capacity, @c priority_heap, @c nonstd::ring_span and
+ * @c jm::circular_buffer), @c lock_free_wait_queue, @c spsc_wait_queue and
+ * @c sharded_wait_queue:
+ *
+ * - Randomized mix. Many threads each run a seeded random mix of @c push, @c emplace_push,
+ * @c try_pop, @c wait_and_pop, batch pushes (@c push_range, or @c reserve / @c try_reserve
+ * and @c commit for a @c fixed_ring), @c try_pop_many, @c wait_and_pop_many, @c drain, and
+ * (rarely) @c close and @c request_stop on one queue, with a controller thread requesting
+ * a stop at a random point if no worker has. Operations a queue type does not have fall
+ * back to the single element push or @c try_pop. After a @c close the readers drain the
+ * queue, and the round ends once it is empty; a push accepted after a @c close fails the
+ * round. After each round the number of successful pushes must equal the number of pops
+ * plus the elements left in the queue, and (for the FIFO queues) every reader must have
+ * seen each writer's values in order. A bounded queue never overwrites, since its pushes
+ * use @c wait_and_push or a non-blocking push, and a @c push_range (which overwrites on a
+ * full fixed size container) is only used for unbounded containers. Odd numbered threads
+ * only block in pops and even numbered threads only in pushes, so the threads cannot all
+ * be blocked at once. An @c spsc_wait_queue is run with one writer and one reader thread.
+ *
+ * - Throughput. Half the threads push a fixed number of elements and half pop them, the
+ * same as @c bench/wait_queue_throughput. The median of several repetitions is compared
+ * against the baseline file, failing if it is lower by more than the threshold.
+ *
+ * Contention metrics are reported for each phase: the mean and maximum time spent in
+ * (sampled) non-blocking @c push (@c try_push for a fixed size container) and @c try_pop
+ * calls, which is dominated by waiting for the lock under contention, the reader blocked
+ * time from the @c atomic_stats policy (n/a for the queue types without a stats policy),
+ * and the number of voluntary context switches (each a blocking futex wait on Linux).
+ *
+ * The baseline file has one line per container, a name followed by elements per second,
+ * with @c # comments. When a baseline file is given, a container missing from it fails
+ * the run (so the gate cannot silently be disarmed), unless @c --update-baseline or
+ * @c --no-gate is given. Throughput is host specific, so the baseline is generated on the
+ * reference host with @c --update-baseline and committed. The default stress ctest passes
+ * @c --no-gate (correctness only), the gate is the opt-in @c WAIT_QUEUE_STRESS_GATE test,
+ * which passes @c --rounds @c 0 to only measure throughput.
+ *
+ * Usage:
+ *
+ * @code
+ *   stress/wait_queue_stress [--threads N] [--rounds N] [--round-ms N] [--elements N]
+ *                            [--reps N] [--seed N] [--baseline FILE] [--threshold F]
+ *                            [--update-baseline] [--no-gate]
+ * @endcode
+ *
+ * The defaults are 16 threads, 8 rounds of 250 ms, 400000 elements over 3 repetitions, a
+ * random seed (printed, for reproducing a failure), and a threshold of 0.25 (a run more
+ * than 25% below the baseline fails). The exit status is non-zero on any failure.
+ *
+ * @author Cliff Green
+ *
+ * @copyright (c) 2024 by Cliff Green
+ *
+ * Distributed under the Boost Software License, Version 1.0.
+ * (See accompanying file LICENSE.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+ *
+ */
+
+#include <iostream>
+#include <iomanip> // std::setw
+#include <fstream>
+#include <sstream>
+#include <cstdlib> // EXIT_SUCCESS, EXIT_FAILURE, std::strtoull, std::strtod
+#include <cstddef> // std::size_t
+#include <cstdint> // std::uint64_t
+#include <cstring> // std::strcmp
+#include <vector>
+#include <string>
+#include <map>
+#include <memory> // std::unique_ptr, std::make_unique
+#include <memory_resource>
+#include <algorithm> // std::sort, std::max
+#include <random>
+#include <functional> // std::function
+#include <iterator> // std::back_inserter
+#include <array>
+#include <optional>
+#include <chrono>
+
+#include <thread>
+#include <atomic>
+
+#if defined(__unix__) || defined(__APPLE__)
+#include <sys/resource.h> // getrusage
+#endif
+
+#include "nonstd/ring_span.hpp"
+#include "circular_buffer.hpp"
+
+#include "queue/wait_queue.hpp"
+#include "queue/pmr_wait_queue.hpp"
+#include "queue/static_wait_queue.hpp"
+#include "queue/fixed_ring.hpp"
+#include "queue/priority_container.hpp"
+#include "queue/lock_free_wait_queue.hpp"
+#include "queue/spsc_wait_queue.hpp"
+#include "queue/sharded_wait_queue.hpp"
+#include "queue/sync_utility.hpp"
+
+using stress_clock = std::chrono::steady_clock;
+
+// writer thread index in the high bits, per-writer sequence number in the low bits
+using elem_type = std::uint64_t;
+constexpr unsigned seq_bits = 40u;
+constexpr elem_type seq_mask = (elem_type{1u} << seq_bits) - 1u;
+constexpr elem_type no_seq = ~elem_type{0u};
+constexpr std::size_t ring_cap = 256u;
+
+struct config {
+  int           m_threads {16};
+  int           m_rounds {8};
+  int           m_round_ms {250};
+  std::size_t   m_elements {400000u};
+  int           m_reps {3};
+  std::uint64_t m_seed {std::random_device{}()};
+  std::string   m_baseline;
+  double        m_threshold {0.25};
+  bool          m_update {false};
+  bool          m_gate {true};
+};
+
+// contention metrics, one per thread (on its own cache line) and then summed
+
+struct alignas(chops::cache_line_size) metrics {
+  std::uint64_t m_calls {0u};     // sampled non-blocking calls
+  std::uint64_t m_call_ns {0u};
+  std::uint64_t m_max_call_ns {0u};
+
+  auto add(const metrics& rhs) -> void {
+    m_calls += rhs.m_calls;
+    m_call_ns += rhs.m_call_ns;
+    m_max_call_ns = std::max(m_max_call_ns, rhs.m_max_call_ns);
+  }
+};
+
+constexpr std::uint64_t sample_mask = 63u; // time one in 64 non-blocking calls
+
+template <typename F>
+auto timed_call(metrics& met, std::uint64_t op_cnt, F func) {
+  if ((op_cnt & sample_mask) != 0u) {
+    return func();
+  }
+  auto start = stress_clock::now();
+  auto rtn = func();
+  auto ns = static_cast<std::uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(
+                                         stress_clock::now() - start).count());
+  ++met.m_calls;
+  met.m_call_ns += ns;
+  met.m_max_call_ns = std::max(met.m_max_call_ns, ns);
+  return rtn;
+}
+
+auto context_switches() -> long {
+#if defined(__unix__) || defined(__APPLE__)
+  rusage usage { };
+  ::getrusage(RUSAGE_SELF, &usage);
+  return usage.ru_nvcsw;
+#else
+  return 0;
+#endif
+}
+
+// queue capabilities, the mix uses every operation a queue type supports and falls
+// back to the single element operations otherwise
+
+// a bounded queue (fixed size container, lock-free or SPSC ring) has a blocking push
+template <typename Q>
+constexpr bool is_bounded = requires (Q& q, elem_type val) { q.wait_and_push(val); };
+
+template <typename Q>
+constexpr bool has_try_push = requires (Q& q, elem_type val) { q.try_push(val); };
+
+// a push_range on a full fixed size container overwrites, so only unbounded queues
+template <typename Q>
+constexpr bool has_push_range = !is_bounded<Q> &&
+  requires (Q& q, elem_type* p) { q.push_range(p, p); };
+
+template <typename Q>
+constexpr bool has_reserve = requires (Q& q) { q.try_reserve(1u); };
+
+template <typename Q>
+constexpr bool has_bulk_pop = requires (Q& q, std::vector<elem_type>& vec) {
+  q.try_pop_many(std::back_inserter(vec), 1u);
+  q.wait_and_pop_many(std::back_inserter(vec), 1u);
+  q.drain(std::back_inserter(vec));
+};
+
+template <typename Q>
+constexpr bool has_close = requires (Q& q) { q.close(); q.closed(); };
+
+template <typename Q>
+constexpr bool has_stats = requires (Q& q) { q.stats().total_wait_ns; };
+
+// an SPSC queue is stressed with one writer and one reader thread
+template <typename Q>
+constexpr bool single_producer = false;
+
+template <typename T, std::size_t N>
+constexpr bool single_producer<chops::spsc_wait_queue<T, N>> = true;
+
+template <typename Q>
+auto is_closed(const Q& wq) -> bool {
+  if constexpr (has_close<Q>) {
+    return wq.closed();
+  }
+  else {
+    return false;
+  }
+}
+
+// pushes to a bounded queue must not overwrite unpopped elements
+template <typename Q>
+auto push_op(Q& wq, elem_type val, bool may_block = true) -> bool {
+  if constexpr (is_bounded<Q>) {
+    if (may_block) {
+      return wq.wait_and_push(val);
+    }
+    if constexpr (has_try_push<Q>) {
+      return wq.try_push(val);
+    }
+    else {
+      return wq.push(val); // lock-free queues never overwrite
+    }
+  }
+  else {
+    return wq.push(val);
+  }
+}
+
+template <typename Q>
+auto emplace_op(Q& wq, elem_type val) -> bool {
+  if constexpr (is_bounded<Q> && has_try_push<Q>) {
+    return wq.try_push(val);
+  }
+  else {
+    return wq.emplace_push(val);
+  }
+}
+
+// randomized mix phase
+
+enum mix_op : int { op_push, op_emplace, op_try_pop, op_wait_pop, op_push_batch,
+                    op_pop_batch, op_drain, op_close, op_stop, op_count };
+
+constexpr std::size_t max_batch = 8u;
+
+struct mix_result {
+  bool    m_ok {true};
+  metrics m_met;
+  std::uint64_t m_ops {0u};
+};
+
+template <typename Q>
+auto run_mix_round(Q& wq, const config& cfg, std::uint64_t seed, bool fifo) -> mix_result {
+
+  const auto nthr = single_producer<Q> ? std::size_t{2u} : static_cast<std::size_t>(cfg.m_threads);
+  std::atomic<std::uint64_t> pushed {0u};
+  std::atomic<std::uint64_t> popped {0u};
+  std::atomic<std::uint64_t> ops {0u};
+  std::atomic<bool> values_ok {true};
+  std::atomic<bool> close_ok {true};
+  std::vector<metrics> mets (nthr);
+
+  {
+    std::vector<std::jthread> thrs;
+    for (std::size_t tid {0u}; tid < nthr; ++tid) {
+      thrs.emplace_back( [&, tid] {
+          std::mt19937_64 rng { seed + tid };
+          std::vector<double> weights { 25.0, 15.0, 25.0, 15.0, 8.0, 8.0, 2.0, 0.0002, 0.0002 };
+          // the SPSC writer thread only pushes and the reader thread only pops
+          if (single_producer<Q>) {
+            for (auto op : (tid == 0u) ? std::vector<int> { op_try_pop, op_wait_pop, op_pop_batch, op_drain } :
+                                         std::vector<int> { op_push, op_emplace, op_push_batch }) {
+              weights[static_cast<std::size_t>(op)] = 0.0;
+            }
+          }
+          std::discrete_distribution<int> op_dist { weights.begin(), weights.end() };
+          std::uniform_int_distribution<std::size_t> batch_dist { 1u, max_batch };
+          // odd threads may block in pops and even threads in pushes, so there is
+          // always a thread making progress
+          const bool block_pop = (tid % 2u) == 1u;
+          std::vector<elem_type> last (nthr, no_seq);
+          std::vector<elem_type> buf;
+          elem_type seq {0u};
+          std::uint64_t cnt {0u};
+          std::uint64_t n_push {0u};
+          std::uint64_t n_pop {0u};
+          auto& met = mets[tid];
+          auto check = [&] (elem_type val) {
+            ++n_pop;
+            const auto wr = static_cast<std::size_t>(val >> seq_bits);
+            const auto sq = val & seq_mask;
+            if (wr >= nthr || (fifo && last[wr] != no_seq && sq <= last[wr])) {
+              values_ok = false;
+            }
+            last[wr] = sq;
+          };
+          // a push must fail once the queue is closed
+          auto pushed_n = [&] (bool was_closed, bool ok, std::size_t n) {
+            if (!ok) {
+              return;
+            }
+            if (was_closed) {
+              close_ok = false;
+            }
+            seq += n;
+            n_push += n;
+          };
+          auto push_one = [&] (elem_type val) {
+            const bool was_closed = is_closed(wq);
+            pushed_n(was_closed, (is_bounded<Q> && !block_pop) ? push_op(wq, val) :
+                       timed_call(met, cnt, [&] { return push_op(wq, val, false); }), 1u);
+          };
+          auto try_pop_one = [&] {
+            if (auto rtn = timed_call(met, cnt, [&] { return wq.try_pop(); }); rtn) {
+              check(*rtn);
+            }
+          };
+          auto check_buf = [&] {
+            for (auto val : buf) {
+              check(val);
+            }
+            buf.clear();
+          };
+          while (!wq.stop_requested()) {
+            const auto val = (static_cast<elem_type>(tid) << seq_bits) | seq;
+            ++cnt;
+            switch (op_dist(rng)) {
+              case op_push:
+                push_one(val);
+                break;
+              case op_emplace: {
+                const bool was_closed = is_closed(wq);
+                pushed_n(was_closed, emplace_op(wq, val), 1u);
+                break;
+              }
+              case op_try_pop:
+                try_pop_one();
+                break;
+              case op_wait_pop:
+                if (auto rtn = block_pop ? wq.wait_and_pop() : wq.try_pop(); rtn) {
+                  check(*rtn);
+                }
+                break;
+              case op_push_batch: {
+                const auto n = batch_dist(rng);
+                const bool was_closed = is_closed(wq);
+                if constexpr (has_push_range<Q>) {
+                  std::array<elem_type, max_batch> vals { };
+                  for (std::size_t i {0u}; i < n; ++i) {
+                    vals[i] = val + i;
+                  }
+                  pushed_n(was_closed, wq.push_range(vals.begin(), vals.begin() + n), n);
+                }
+                else if constexpr (has_reserve<Q>) {
+                  // values are pushed once reserved, a commit after a stop still commits
+                  auto slots = block_pop ? wq.try_reserve(n) : wq.reserve(n);
+                  if (slots) {
+                    for (std::size_t i {0u}; i < n; ++i) {
+                      slots->emplace(val + i);
+                    }
+                    wq.commit(*slots);
+                  }
+                  pushed_n(was_closed, slots.has_value(), n);
+                }
+                else {
+                  push_one(val);
+                }
+                break;
+              }
+              case op_pop_batch:
+                if constexpr (has_bulk_pop<Q>) {
+                  const auto n = batch_dist(rng);
+                  if (block_pop) {
+                    (void) wq.wait_and_pop_many(std::back_inserter(buf), n);
+                  }
+                  else {
+                    (void) timed_call(met, cnt, [&] { return wq.try_pop_many(std::back_inserter(buf), n); });
+                  }
+                  check_buf();
+                }
+                else {
+                  try_pop_one();
+                }
+                break;
+              case op_drain:
+                if constexpr (has_bulk_pop<Q>) {
+                  wq.drain(std::back_inserter(buf));
+                  check_buf();
+                }
+                else {
+                  try_pop_one();
+                }
+                break;
+              case op_close:
+                if constexpr (has_close<Q>) {
+                  wq.close(); // lossless shutdown, readers drain the queue
+                }
+                break;
+              default:
+                wq.request_stop(); // a worker initiated stop, mid flight for the others
+                break;
+            }
+            if (is_closed(wq) && wq.empty()) {
+              wq.request_stop(); // end of stream, the round is over
+            }
+          }
+          pushed += n_push;
+          popped += n_pop;
+          ops += cnt;
+        } );
+    }
+    std::mt19937_64 rng { seed ^ 0x5bd1e995u };
+    std::uniform_int_distribution<int> ms_dist { cfg.m_round_ms / 2, cfg.m_round_ms };
+    const auto deadline = stress_clock::now() + std::chrono::milliseconds(ms_dist(rng));
+    while (!wq.stop_requested() && stress_clock::now() < deadline) {
+      std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+    wq.request_stop();
+  } // all threads joined
+
+  mix_result res;
+  for (const auto& met : mets) {
+    res.m_met.add(met);
+  }
+  res.m_ops = ops.load();
+  const auto left = static_cast<std::uint64_t>(wq.size());
+  if (pushed.load() != popped.load() + left) {
+    std::cout << "  conservation failure: pushed " << pushed.load() << ", popped "
+              << popped.load() << ", left " << left << '\n';
+    res.m_ok = false;
+  }
+  if (!values_ok.load()) {
+    std::cout << "  per-writer FIFO order failure\n";
+    res.m_ok = false;
+  }
+  if (!close_ok.load()) {
+    std::cout << "  push accepted after close\n";
+    res.m_ok = false;
+  }
+  return res;
+}
+
+// throughput phase
+
+struct tput_result {
+  double        m_ops_per_sec {0.0};
+  metrics       m_met;
+  std::optional<std::uint64_t> m_blocked_ns; // only for queues with a stats policy
+  long          m_ctx_switches {0};
+};
+
+template <typename Q>
+auto run_tput_once(Q& wq, const config& cfg) -> tput_result {
+
+  const auto nwr = single_producer<Q> ? 1 : std::max(cfg.m_threads / 2, 1);
+  const auto nrd = single_producer<Q> ? 1 : std::max(cfg.m_threads - nwr, 1);
+  // at least one element per writer, otherwise no reader would ever request the stop
+  const std::size_t per_writer = std::max(cfg.m_elements / static_cast<std::size_t>(nwr),
+                                          std::size_t{1u});
+  const std::size_t expected = per_writer * static_cast<std::size_t>(nwr);
+  std::atomic<std::size_t> popped {0u};
+  std::vector<metrics> mets (static_cast<std::size_t>(nwr));
+
+  const auto ctx_start = context_switches();
+  const auto start = stress_clock::now();
+  {
+    std::vector<std::jthread> thrs;
+    for (int i {0}; i < nrd; ++i) {
+      thrs.emplace_back( [&wq, &popped, expected] {
+          while (auto val = wq.wait_and_pop()) {
+            if (popped.fetch_add(1u, std::memory_order_relaxed) + 1u == expected) {
+              wq.request_stop();
+            }
+          }
+        } );
+    }
+    for (int i {0}; i < nwr; ++i) {
+      thrs.emplace_back( [&wq, &met = mets[static_cast<std::size_t>(i)], i, per_writer] {
+          for (std::size_t j {0u}; j < per_writer; ++j) {
+            const auto val = (static_cast<elem_type>(i) << seq_bits) | j;
+            // a bounded queue push is timed as a non-blocking push, with an (untimed)
+            // wait_and_push only if the queue is full
+            if (!(timed_call(met, j, [&] { return push_op(wq, val, false); }) ||
+                  (is_bounded<Q> && !wq.stop_requested() && push_op(wq, val)))) {
+              return;
+            }
+          }
+        } );
+    }
+  } // all threads joined
+  const std::chrono::duration<double> elapsed = stress_clock::now() - start;
+
+  tput_result res;
+  res.m_ops_per_sec = static_cast<double>(expected) / elapsed.count();
+  for (const auto& met : mets) {
+    res.m_met.add(met);
+  }
+  if constexpr (has_stats<Q>) {
+    res.m_blocked_ns = wq.stats().total_wait_ns;
+  }
+  res.m_ctx_switches = context_switches() - ctx_start;
+  return res;
+}
+
+// baseline file
+
+using baseline_map = std::map<std::string, double>;
+
+auto read_baseline(const std::string& path) -> baseline_map {
+  baseline_map bl;
+  std::ifstream ifs { path };
+  std::string line;
+  while (std::getline(ifs, line)) {
+    if (line.empty() || line[0] == '#') {
+      continue;
+    }
+    std::istringstream iss { line };
+    std::string name;
+    double ops {0.0};
+    if (iss >> name >> ops) {
+      bl[name] = ops;
+    }
+  }
+  return bl;
+}
+
+auto write_baseline(const std::string& path, const baseline_map& bl) -> bool {
+  std::ofstream ofs { path };
+  ofs << "# wait_queue_stress throughput baseline, elements per second (median)\n"
+      << "# regenerate on the reference host with: wait_queue_stress --update-baseline"
+      << " --baseline <this file>\n";
+  for (const auto& [name, ops] : bl) {
+    ofs << name << ' ' << std::fixed << std::setprecision(0) << ops << '\n';
+  }
+  return static_cast<bool>(ofs);
+}
+
+auto mean_ns(const metrics& met) -> double {
+  return met.m_calls == 0u ? 0.0 : static_cast<double>(met.m_call_ns) / static_cast<double>(met.m_calls);
+}
+
+// run both phases for one container type, the factory creates a new queue each run
+
+template <typename Q>
+auto stress_queue(const std::string& name, std::function<std::unique_ptr<Q> ()> make_q,
+                  const config& cfg, bool fifo, baseline_map& bl) -> bool {
+
+  bool ok {true};
+  metrics mix_met;
+  std::uint64_t mix_ops {0u};
+  const auto ctx_start = context_switches();
+  for (int r {0}; r < cfg.m_rounds; ++r) {
+    auto wq = make_q();
+    auto res = run_mix_round(*wq, cfg, cfg.m_seed + static_cast<std::uint64_t>(r) * 1000u, fifo);
+    ok = ok && res.m_ok;
+    mix_met.add(res.m_met);
+    mix_ops += res.m_ops;
+  }
+  const auto mix_ctx = context_switches() - ctx_start;
+
+  std::vector<tput_result> runs;
+  for (int i {0}; i < cfg.m_reps; ++i) {
+    auto wq = make_q();
+    runs.push_back(run_tput_once(*wq, cfg));
+  }
+  std::sort(runs.begin(), runs.end(),
+            [] (const tput_result& a, const tput_result& b) { return a.m_ops_per_sec < b.m_ops_per_sec; } );
+  const auto& med = runs[runs.size() / 2u];
+
+  std::cout << std::left << std::setw(16) << name << std::right << std::fixed
+            << std::setprecision(0) << std::setw(12) << mix_ops
+            << std::setprecision(1) << std::setw(10) << mean_ns(mix_met)
+            << std::setw(10) << static_cast<double>(mix_met.m_max_call_ns) / 1000.0
+            << std::setw(10) << mix_ctx
+            << std::setprecision(0) << std::setw(14) << med.m_ops_per_sec
+            << std::setprecision(1) << std::setw(10) << mean_ns(med.m_met)
+            << std::setw(12);
+  if (med.m_blocked_ns) {
+    std::cout << static_cast<double>(*med.m_blocked_ns) / 1e6;
+  }
+  else {
+    std::cout << "n/a";
+  }
+  std::cout << std::setw(10) << med.m_ctx_switches;
+
+  if (cfg.m_update) {
+    bl[name] = med.m_ops_per_sec;
+    std::cout << "  baseline updated";
+  }
+  else if (auto it = bl.find(name); it == bl.end()) {
+    std::cout << "  no baseline";
+    if (cfg.m_gate && !cfg.m_baseline.empty()) {
+      std::cout << ", MISSING";
+      ok = false;
+    }
+  }
+  else {
+    const auto ratio = med.m_ops_per_sec / it->second;
+    std::cout << std::setprecision(2) << "  x" << ratio << " of baseline";
+    if (cfg.m_gate && ratio < 1.0 - cfg.m_threshold) {
+      std::cout << ", REGRESSION";
+      ok = false;
+    }
+  }
+  std::cout << (ok ? "" : ", FAILED") << std::endl;
+  return ok;
+}
+
+auto parse_args(int argc, char* argv[], config& cfg) -> bool {
+  for (int i {1}; i < argc; ++i) {
+    auto arg = [&] (const char* opt) { return std::strcmp(argv[i], opt) == 0 && i + 1 < argc; };
+    if (arg("--threads")) { cfg.m_threads = std::max(std::atoi(argv[++i]), 2); }
+    else if (arg("--rounds")) { cfg.m_rounds = std::atoi(argv[++i]); }
+    else if (arg("--round-ms")) { cfg.m_round_ms = std::max(std::atoi(argv[++i]), 2); }
+    else if (arg("--elements")) { cfg.m_elements = std::strtoull(argv[++i], nullptr, 10); }
+    else if (arg("--reps")) { cfg.m_reps = std::max(std::atoi(argv[++i]), 1); }
+    else if (arg("--seed")) { cfg.m_seed = std::strtoull(argv[++i], nullptr, 10); }
+    else if (arg("--baseline")) { cfg.m_baseline = argv[++i]; }
+    else if (arg("--threshold")) { cfg.m_threshold = std::strtod(argv[++i], nullptr); }
+    else if (std::strcmp(argv[i], "--update-baseline") == 0) { cfg.m_update = true; }
+    else if (std::strcmp(argv[i], "--no-gate") == 0) { cfg.m_gate = false; }
+    else {
+      std::cerr << "unknown or incomplete argument: " << argv[i] << '\n';
+      return false;
+    }
+  }
+  return !(cfg.m_update && cfg.m_baseline.empty());
+}
+
+int main(int argc, char* argv[]) {
+
+  config cfg;
+  if (!parse_args(argc, argv, cfg)) {
+    std::cerr << "see the file comments in wait_queue_stress.cpp for usage\n";
+    return EXIT_FAILURE;
+  }
+  auto bl = cfg.m_baseline.empty() ? baseline_map { } : read_baseline(cfg.m_baseline);
+
+  std::cout << "seed: " << cfg.m_seed << ", threads: " << cfg.m_threads
+            << ", gate: " << (cfg.m_gate ? "on" : "off") << '\n';
+  std::cout << std::left << std::setw(16) << "container" << std::right
+            << std::setw(12) << "mix ops" << std::setw(10) << "call ns"
+            << std::setw(10) << "max us" << std::setw(10) << "ctx sw"
+            << std::setw(14) << "tput ops/sec" << std::setw(10) << "call ns"
+            << std::setw(12) << "blocked ms" << std::setw(10) << "ctx sw" << '\n';
+
+  using stats = chops::atomic_stats;
+  using deque_q = chops::wait_queue<elem_type, std::deque<elem_type>, chops::block_wait, stats>;
+  using pmr_q = chops::pmr::wait_queue<elem_type, chops::block_wait, stats>;
+  using static_q = chops::static_wait_queue<elem_type, ring_cap, chops::block_wait, stats>;
+  using ring_q = chops::wait_queue<elem_type, chops::fixed_ring<elem_type>, chops::block_wait, stats>;
+  using prio_q = chops::priority_wait_queue<elem_type, std::less<elem_type>, chops::block_wait, stats>;
+  using ring_span_q = chops::wait_queue<elem_type, nonstd::ring_span<elem_type>, chops::block_wait, stats>;
+  using circ_q = chops::wait_queue<elem_type, jm::circular_buffer<elem_type, ring_cap>, chops::block_wait, stats>;
+  using lock_free_q = chops::lock_free_wait_queue<elem_type, ring_cap>;
+  using spsc_q = chops::spsc_wait_queue<elem_type, ring_cap>;
+  using sharded_q = chops::sharded_wait_queue<elem_type>;
+
+  static std::pmr::synchronized_pool_resource pool;
+  static elem_type ring_span_buf[ring_cap]; // only one queue at a time uses the buffer
+
+  bool ok {true};
+  ok = stress_queue<deque_q>("deque", [] { return std::make_unique<deque_q>(); },
+                             cfg, true, bl) && ok;
+  ok = stress_queue<pmr_q>("pmr_deque", [] { return std::make_unique<pmr_q>(&pool); },
+                           cfg, true, bl) && ok;
+  ok = stress_queue<static_q>("static_ring", [] { return std::make_unique<static_q>(); },
+                              cfg, true, bl) && ok;
+  ok = stress_queue<ring_q>("fixed_ring", [] { return std::make_unique<ring_q>(ring_cap); },
+                            cfg, true, bl) && ok;
+  ok = stress_queue<prio_q>("priority_heap", [] { return std::make_unique<prio_q>(); },
+                            cfg, false, bl) && ok;
+  ok = stress_queue<ring_span_q>("ring_span", [] { return std::make_unique<ring_span_q>(
+                                   nonstd::ring_span<elem_type> { ring_span_buf, ring_span_buf + ring_cap }); },
+                                 cfg, true, bl) && ok;
+  ok = stress_queue<circ_q>("circular_buffer", [] { return std::make_unique<circ_q>(); },
+                            cfg, true, bl) && ok;
+  ok = stress_queue<lock_free_q>("lock_free", [] { return std::make_unique<lock_free_q>(); },
+                                 cfg, true, bl) && ok;
+  ok = stress_queue<spsc_q>("spsc", [] { return std::make_unique<spsc_q>(); },
+                            cfg, true, bl) && ok;
+  ok = stress_queue<sharded_q>("sharded", [] { return std::make_unique<sharded_q>(); },
+                               cfg, true, bl) && ok;
+
+  if (cfg.m_update && !write_baseline(cfg.m_baseline, bl)) {
+    std::cerr << "unable to write baseline file " << cfg.m_baseline << '\n';
+    return EXIT_FAILURE;
+  }
+  std::cout << (ok ? "All stress runs passed" : "Stress failures") << '\n';
+  return ok ? EXIT_SUCCESS : EXIT_FAILURE;
+}
+
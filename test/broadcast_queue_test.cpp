@@ -0,0 +1,135 @@
+/** @file
+ *
+ * @brief Test scenarios for @c broadcast_queue.
+ *
+ * @author Cliff Green
+ *
+ * @copyright (c) 2024 by Cliff Green
+ *
+ * Distributed under the Boost Software License, Version 1.0.
+ * (See accompanying file LICENSE.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+ *
+ */
+
+#include <cstddef> // std::size_t
+#include <cstdint> // std::uint64_t
+#include <string>
+#include <vector>
+#include <memory> // std::shared_ptr
+#include <chrono>
+
+#include <thread>
+#include <future> // std::async
+#include <stop_token>
+
+#include "catch2/catch_test_macros.hpp"
+
+#include "queue/broadcast_queue.hpp"
+
+using namespace std::literals::string_literals;
+
+TEST_CASE ( "broadcast_queue, non-threaded, every subscriber sees every element",
+            "[broadcast_queue] [non_threaded]" ) {
+
+  chops::broadcast_queue<std::string, 4u> bq;
+  REQUIRE (bq.push("before"s)); // no subscribers, nothing blocks
+  using sub_type = chops::broadcast_queue<std::string, 4u>::subscriber;
+  sub_type sub1 { bq };
+  {
+    sub_type sub2 { bq };
+    REQUIRE (bq.subscriber_count() == 2u);
+    REQUIRE_FALSE (sub1.try_pop()); // only elements published after subscribing
+    REQUIRE (bq.push("a"s));
+    REQUIRE (bq.emplace_push(2u, 'b'));
+    REQUIRE (sub1.available() == 2u);
+    REQUIRE (*(sub1.try_pop()) == "a"s);
+    REQUIRE (*(sub2.wait_and_pop()) == "a"s);
+    REQUIRE (*(sub2.try_pop()) == "bb"s);
+    REQUIRE (bq.try_push("c"s));
+    REQUIRE (bq.try_push("d"s));
+    REQUIRE (bq.try_push("e"s));
+    REQUIRE_FALSE (bq.try_push("f"s)); // sub1 is a full ring behind
+    REQUIRE (sub2.available() == 3u);
+  }
+  REQUIRE (bq.subscriber_count() == 1u);
+  std::vector<std::string> vals;
+  while (auto val = sub1.try_pop()) {
+    vals.push_back(*val);
+  }
+  REQUIRE (vals == std::vector<std::string> { "bb"s, "c"s, "d"s, "e"s });
+  REQUIRE (sub1.lapped() == 0u);
+
+  bq.request_stop();
+  REQUIRE (bq.stop_requested());
+  REQUIRE_FALSE (bq.push("g"s));
+  REQUIRE_FALSE (sub1.wait_and_pop());
+}
+
+TEST_CASE ( "broadcast_queue, lap policy, slow subscriber skips ahead",
+            "[broadcast_queue] [lap]" ) {
+
+  chops::broadcast_queue<int, 8u, chops::overflow_policy::lap> bq;
+  chops::broadcast_queue<int, 8u, chops::overflow_policy::lap>::subscriber sub { bq };
+  for (int i {0}; i < 20; ++i) {
+    REQUIRE (bq.push(i)); // never blocks
+  }
+  REQUIRE (sub.available() == 20u);
+  REQUIRE (*(sub.try_pop()) == 12); // oldest remaining element
+  REQUIRE (sub.lapped() == 12u);
+  int expected {13};
+  while (auto val = sub.try_pop()) {
+    REQUIRE (*val == expected++);
+  }
+  REQUIRE (expected == 20);
+}
+
+TEST_CASE ( "broadcast_queue, threaded, fan-out of shared buffers with back-pressure",
+            "[broadcast_queue] [threaded]" ) {
+
+  constexpr int tot = 20000;
+  constexpr int num_subs = 4;
+  using buf_ptr = std::shared_ptr<const std::vector<int>>;
+  using bq_type = chops::broadcast_queue<buf_ptr, 64u>;
+  std::stop_source src;
+  bq_type bq { src.get_token() };
+
+  std::vector<std::future<bool>> sub_futs;
+  std::vector<std::unique_ptr<bq_type::subscriber>> subs;
+  for (int i {0}; i < num_subs; ++i) {
+    subs.push_back(std::make_unique<bq_type::subscriber>(bq)); // subscribed before any push
+  }
+  for (auto& sub : subs) {
+    sub_futs.push_back(std::async(std::launch::async, [&sub] {
+        int expected {0};
+        while (auto val = sub->wait_and_pop()) {
+          if ((**val)[0] != expected++) {
+            return false;
+          }
+          if (expected == tot) {
+            break;
+          }
+        }
+        return expected == tot;
+      } ) );
+  }
+  for (int i {0}; i < tot; ++i) {
+    REQUIRE (bq.push(std::make_shared<const std::vector<int>>(1u, i)));
+  }
+  for (auto& fut : sub_futs) {
+    REQUIRE (fut.get());
+  }
+  for (auto& sub : subs) {
+    REQUIRE (sub->lapped() == 0u);
+  }
+
+  // writer blocked on a slow subscriber is released by a stop
+  for (int i {0}; i < 64; ++i) {
+    REQUIRE (bq.try_push(nullptr));
+  }
+  auto push_fut = std::async(std::launch::async, [&bq] { return bq.push(nullptr); } );
+  REQUIRE (push_fut.wait_for(std::chrono::milliseconds(50)) == std::future_status::timeout);
+  src.request_stop();
+  REQUIRE_FALSE (push_fut.get());
+  REQUIRE_FALSE (bq.request_stop()); // external stop token
+}
+
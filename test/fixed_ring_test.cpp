@@ -0,0 +1,286 @@
+/** @file
+ *
+ * @brief Test scenarios for @c fixed_ring class template.
+ *
+ * @author Cliff Green
+ *
+ * @copyright (c) 2024 by Cliff Green
+ *
+ * Distributed under the Boost Software License, Version 1.0.
+ * (See accompanying file LICENSE.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+ *
+ */
+
+#include <cstddef> // std::size_t
+#include <string>
+#include <vector>
+#include <memory> // std::unique_ptr, std::construct_at
+#include <utility> // std::move
+
+#include "catch2/catch_test_macros.hpp"
+#include "catch2/catch_template_test_macros.hpp"
+
+#include "queue/fixed_ring.hpp"
+#include "queue/wait_queue.hpp" // container concepts
+
+using namespace std::literals::string_literals;
+
+static_assert(chops::supports_push_back<chops::fixed_ring<int, 8>, int>);
+static_assert(chops::supports_pop_front<chops::fixed_ring<int, 8>>);
+static_assert(chops::supports_emplace_back<chops::fixed_ring<int, 8>, int>);
+static_assert(chops::supports_full<chops::fixed_ring<int, 8>>);
+static_assert(chops::supports_full<chops::fixed_ring<int>>);
+static_assert(chops::supports_reserve<chops::fixed_ring<int, 8>>);
+static_assert(chops::supports_full<chops::lean_fixed_ring<int, 8>>);
+static_assert(chops::supports_full<chops::lean_fixed_ring<int>>);
+static_assert(!chops::supports_reserve<chops::lean_fixed_ring<int, 8>>);
+
+// a lean ring is the element storage plus two 32 bit counters, which is smaller than a
+// circular buffer with a (size_t) head position and size
+static_assert(sizeof(chops::lean_fixed_ring<int, 64>) == 64u * sizeof(int) + 8u);
+static_assert(sizeof(chops::lean_fixed_ring<int, 64>) < 64u * sizeof(int) + 2u * sizeof(std::size_t));
+static_assert(sizeof(chops::lean_fixed_ring<int, 64>) < sizeof(chops::fixed_ring<int, 64>));
+
+// element type without a default constructor, counting live objects
+struct counted {
+  static inline int live {0};
+  int m_val;
+  explicit counted(int val) : m_val(val) { ++live; }
+  counted(const counted& rhs) : m_val(rhs.m_val) { ++live; }
+  ~counted() { --live; }
+  counted& operator=(const counted&) = delete;
+};
+
+template <typename R>
+auto contents(const R& ring) -> std::vector<int> {
+  std::vector<int> vec;
+  for (const auto& e : ring) {
+    vec.push_back(e);
+  }
+  return vec;
+}
+
+TEMPLATE_TEST_CASE ( "fixed_ring basic operations, wrap around and overwrite",
+                     "[fixed_ring] [wrap_around]",
+                     (chops::fixed_ring<int, 4>), chops::fixed_ring<int>,
+                     (chops::lean_fixed_ring<int, 4>), chops::lean_fixed_ring<int> ) {
+
+  auto ring = [] {
+    if constexpr (std::is_default_constructible_v<TestType>) {
+      return TestType { };
+    }
+    else {
+      return TestType { 3u }; // rounded up to 4
+    }
+  } ();
+
+  REQUIRE (ring.empty());
+  REQUIRE (ring.capacity() == 4u);
+  ring.push_back(1);
+  ring.push_back(2);
+  REQUIRE (ring.emplace_back(3) == 3);
+  REQUIRE (ring.size() == 3u);
+  REQUIRE_FALSE (ring.full());
+  REQUIRE (ring.front() == 1);
+  REQUIRE (ring.back() == 3);
+  ring.pop_front();
+  ring.push_back(4);
+  ring.push_back(5); // wraps around the end of the storage
+  REQUIRE (ring.full());
+  REQUIRE (contents(ring) == std::vector<int> { 2, 3, 4, 5 });
+  ring.push_back(6); // overwrites oldest
+  REQUIRE (ring.size() == 4u);
+  REQUIRE (contents(ring) == std::vector<int> { 3, 4, 5, 6 });
+  for (auto& e : ring) {
+    e *= 10;
+  }
+  REQUIRE (ring.front() == 30);
+  ring.clear();
+  REQUIRE (ring.empty());
+  REQUIRE (ring.capacity() == 4u);
+
+  for (int i {0}; i < 1000; ++i) {
+    ring.push_back(i);
+    REQUIRE (ring.front() == i);
+    ring.pop_front();
+  }
+  REQUIRE (ring.empty());
+}
+
+TEST_CASE ( "fixed_ring with non default constructible element type, lifetimes",
+            "[fixed_ring] [lifetime]" ) {
+
+  REQUIRE (counted::live == 0);
+  {
+    chops::fixed_ring<counted, 8> ring;
+    REQUIRE (counted::live == 0); // storage is uninitialized
+    for (int i {0}; i < 5; ++i) {
+      ring.emplace_back(i);
+    }
+    REQUIRE (counted::live == 5);
+    ring.pop_front();
+    REQUIRE (counted::live == 4);
+    for (int i {0}; i < 10; ++i) {
+      ring.emplace_back(i);
+    }
+    REQUIRE (counted::live == 8);
+
+    chops::fixed_ring<counted, 8> cpy { ring };
+    REQUIRE (counted::live == 16);
+    REQUIRE (cpy.front().m_val == ring.front().m_val);
+    cpy.clear();
+    REQUIRE (counted::live == 8);
+  }
+  REQUIRE (counted::live == 0);
+  {
+    chops::fixed_ring<counted> ring { 5u };
+    REQUIRE (ring.capacity() == 8u);
+    ring.emplace_back(42);
+    auto moved { std::move(ring) };
+    REQUIRE (moved.front().m_val == 42);
+    REQUIRE (ring.empty());
+    REQUIRE (counted::live == 1);
+  }
+  REQUIRE (counted::live == 0);
+}
+
+TEST_CASE ( "fixed_ring copy and move, move-only element type",
+            "[fixed_ring] [copy_move]" ) {
+
+  chops::fixed_ring<std::string, 4> a;
+  a.push_back("Howzit"s);
+  a.push_back("going"s);
+  chops::fixed_ring<std::string, 4> b;
+  b = a;
+  REQUIRE (b.size() == 2u);
+  REQUIRE (b.back() == "going"s);
+  chops::fixed_ring<std::string, 4> c { std::move(b) };
+  REQUIRE (c.front() == "Howzit"s);
+  REQUIRE (b.empty());
+
+  chops::fixed_ring<std::string> d { 16u };
+  d.push_back("bro"s);
+  chops::fixed_ring<std::string> e { 2u };
+  e = d;
+  REQUIRE (e.capacity() == 16u);
+  REQUIRE (e.front() == "bro"s);
+  e = std::move(d);
+  REQUIRE (d.capacity() == 0u);
+  REQUIRE (e.front() == "bro"s);
+
+  chops::fixed_ring<std::unique_ptr<int>, 2> up;
+  up.push_back(std::make_unique<int>(1));
+  up.emplace_back(std::make_unique<int>(2));
+  auto up2 { std::move(up) };
+  REQUIRE (*(up2.front()) == 1);
+  up2.pop_front();
+  REQUIRE (*(up2.front()) == 2);
+}
+
+TEST_CASE ( "lean_fixed_ring lifetimes, copy and move",
+            "[fixed_ring] [lean]" ) {
+
+  REQUIRE (counted::live == 0);
+  {
+    chops::lean_fixed_ring<counted, 4> ring;
+    for (int i {0}; i < 6; ++i) { // overwrites the two oldest
+      ring.emplace_back(i);
+    }
+    REQUIRE (counted::live == 4);
+    REQUIRE (ring.front().m_val == 2);
+    REQUIRE (ring.available() == 0u);
+    chops::lean_fixed_ring<counted, 4> cpy { ring };
+    REQUIRE (counted::live == 8);
+    ring.pop_front(2u);
+    REQUIRE (ring.available() == 2u);
+    auto moved { std::move(cpy) };
+    REQUIRE (moved.size() == 4u);
+    REQUIRE (moved.back().m_val == 5);
+    REQUIRE (cpy.empty());
+    REQUIRE (counted::live == 6);
+  }
+  REQUIRE (counted::live == 0);
+
+  chops::lean_fixed_ring<std::string> d { 3u };
+  d.push_back("bro"s);
+  chops::lean_fixed_ring<std::string> e { 8u };
+  e = d;
+  REQUIRE (e.capacity() == 4u);
+  REQUIRE (e.front() == "bro"s);
+  e = std::move(d);
+  REQUIRE (d.capacity() == 0u);
+  REQUIRE (e.front() == "bro"s);
+}
+
+TEST_CASE ( "fixed_ring front span and multiple element pop",
+            "[fixed_ring] [span]" ) {
+
+  chops::fixed_ring<int, 8> ring;
+  REQUIRE (ring.front_span().empty());
+  for (int i {0}; i < 6; ++i) {
+    ring.push_back(i);
+  }
+  auto sp = ring.front_span();
+  REQUIRE (sp.size() == 6u);
+  REQUIRE (sp[0] == 0);
+  ring.pop_front(5u);
+  REQUIRE (ring.front() == 5);
+  for (int i {6}; i < 12; ++i) { // wraps around
+    ring.push_back(i);
+  }
+  REQUIRE (ring.size() == 7u);
+  sp = ring.front_span();
+  REQUIRE (sp.size() == 3u); // 5, 6, 7 up to end of storage
+  REQUIRE (sp.back() == 7);
+  ring.pop_front(sp.size());
+  REQUIRE (ring.front_span().size() == 4u);
+  REQUIRE (ring.front_span().front() == 8);
+  ring.pop_front(4u);
+  REQUIRE (ring.empty());
+}
+
+TEST_CASE ( "fixed_ring reserve and commit, out of order commits",
+            "[fixed_ring] [reserve]" ) {
+
+  chops::fixed_ring<std::string, 8> ring;
+  ring.push_back("a"s);
+  REQUIRE (ring.available() == 7u);
+  auto r1 = ring.reserve(2u);
+  auto r2 = ring.reserve(1u);
+  REQUIRE (ring.size() == 1u); // reserved slots not visible
+  REQUIRE (ring.available() == 4u);
+  REQUIRE (ring.pending() == 3u);
+  ring.push_back("e"s); // placed after the reservations
+  REQUIRE (ring.size() == 1u);
+  REQUIRE (ring.pending() == 4u);
+
+  std::construct_at(ring.reserved_slot(r2, 0u), "d"s);
+  REQUIRE (ring.commit(r2) == 0u); // r1 outstanding
+  REQUIRE (ring.size() == 1u);
+  std::construct_at(ring.reserved_slot(r1, 0u), "b"s);
+  std::construct_at(ring.reserved_slot(r1, 1u), "c"s);
+  REQUIRE (ring.commit(r1) == 4u); // r1, r2, and the pushed element
+  REQUIRE (ring.size() == 5u);
+  REQUIRE (ring.pending() == 0u);
+
+  std::string joined;
+  for (const auto& e : ring) {
+    joined += e;
+  }
+  REQUIRE (joined == "abcde"s);
+
+  // wrap around with reservations
+  ring.pop_front(5u);
+  for (int i {0}; i < 3; ++i) {
+    auto r = ring.reserve(2u);
+    std::construct_at(ring.reserved_slot(r, 0u), std::to_string(2*i));
+    std::construct_at(ring.reserved_slot(r, 1u), std::to_string(2*i+1));
+    REQUIRE (ring.commit(r) == 2u);
+  }
+  REQUIRE (ring.size() == 6u);
+  REQUIRE (ring.front() == "0"s);
+  REQUIRE (ring.back() == "5"s);
+  ring.clear();
+  REQUIRE (ring.available() == 8u);
+}
+
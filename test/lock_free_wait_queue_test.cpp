@@ -0,0 +1,163 @@
+/** @file
+ *
+ * @brief Test scenarios for @c lock_free_wait_queue class template.
+ *
+ * @author Cliff Green
+ *
+ * @copyright (c) 2024 by Cliff Green
+ *
+ * Distributed under the Boost Software License, Version 1.0.
+ * (See accompanying file LICENSE.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+ *
+ */
+
+#include <utility> // std::pair
+#include <functional> // std::ref
+#include <vector>
+#include <string>
+#include <set>
+#include <optional>
+#include <chrono>
+#include <memory> // std::unique_ptr, std::make_unique
+#include <type_traits> // std::is_arithmetic
+
+#include <thread>
+#include <future> // std::async
+#include <mutex>
+#include <stop_token>
+
+#include "catch2/catch_test_macros.hpp"
+#include "catch2/catch_template_test_macros.hpp"
+
+#include "queue/lock_free_wait_queue.hpp"
+
+using namespace std::literals::string_literals;
+
+constexpr std::size_t Cap = 64;
+
+TEMPLATE_TEST_CASE ( "Non-threaded lock_free_wait_queue test",
+                     "[lock_free_wait_queue] [non_threaded]",
+                     int, double, std::string ) {
+
+  auto wq_ptr = std::make_unique<chops::lock_free_wait_queue<TestType, Cap>>();
+  auto& wq = *wq_ptr;
+  TestType val { };
+  if constexpr (std::is_arithmetic_v<TestType>) {
+    val = 42;
+  }
+  else {
+    val = "Howzit going, bro!";
+  }
+
+  REQUIRE (wq.empty());
+  REQUIRE (wq.capacity() == Cap);
+  for (std::size_t i {0u}; i < Cap; ++i) {
+    REQUIRE (wq.push(val));
+  }
+  REQUIRE (wq.size() == Cap);
+  REQUIRE_FALSE (wq.push(val)); // full
+  REQUIRE (*(wq.try_pop()) == val);
+  REQUIRE (wq.emplace_push(val));
+  for (std::size_t i {0u}; i < Cap; ++i) {
+    REQUIRE (*(wq.wait_and_pop()) == val);
+  }
+  REQUIRE (wq.empty());
+  REQUIRE_FALSE (wq.try_pop());
+
+  // leave some elements in the queue for the destructor
+  REQUIRE (wq.push(val));
+  REQUIRE (wq.request_stop());
+  REQUIRE_FALSE (wq.push(val));
+  REQUIRE_FALSE (wq.try_pop());
+}
+
+TEST_CASE ( "Non-threaded lock_free_wait_queue test, move only type",
+            "[lock_free_wait_queue] [no_copy]" ) {
+
+  chops::lock_free_wait_queue<std::unique_ptr<int>, Cap> wq;
+  auto p = std::make_unique<int>(42);
+  REQUIRE (wq.wait_and_push(std::move(p)));
+  REQUIRE (wq.emplace_push(new int(43)));
+  REQUIRE (**(wq.try_pop()) == 42);
+  REQUIRE (**(wq.try_pop()) == 43);
+  REQUIRE (wq.empty());
+}
+
+using elem = std::pair<int, std::string>;
+using lf_wq = chops::lock_free_wait_queue<elem, Cap>;
+
+void read_func (lf_wq& wq, std::set<elem>& s, std::mutex& mut) {
+  while (true) {
+    auto opt_elem = wq.wait_and_pop();
+    if (!opt_elem) { // empty element means request stop has been called
+      return;
+    }
+    std::lock_guard<std::mutex> lk(mut);
+    s.insert(*opt_elem);
+  }
+}
+
+void write_func (lf_wq& wq, int start, int slice, const std::string& val) {
+  for (int i {0}; i < slice; ++i) {
+    if (!wq.wait_and_push(elem{(start+i), val})) {
+      return;
+    }
+  }
+}
+
+bool threaded_test(int num_readers, int num_writers, int slice, const std::string& val) {
+  lf_wq wq;
+  std::set<elem> s;
+  std::mutex mut;
+  {
+    std::vector<std::jthread> rd_thrs;
+    for (int i {0}; i < num_readers; ++i) {
+      rd_thrs.push_back( std::jthread (read_func, std::ref(wq), std::ref(s), std::ref(mut)) );
+    }
+    {
+      std::vector<std::jthread> wr_thrs;
+      for (int i {0}; i < num_writers; ++i) {
+        wr_thrs.push_back( std::jthread (write_func, std::ref(wq), (i*slice), slice, std::cref(val)));
+      }
+    } // writers joined
+    while (!wq.empty()) {
+      std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    }
+    // an element may have been popped but not yet inserted in the set
+    std::this_thread::sleep_for(std::chrono::milliseconds(50));
+    wq.request_stop();
+  } // readers joined
+  int idx {0};
+  for (const auto& e : s) {
+    REQUIRE (e.first == idx);
+    REQUIRE (e.second == val);
+    ++idx;
+  }
+  return s.size() == static_cast<std::size_t>(num_writers * slice);
+}
+
+TEST_CASE ( "Threaded lock_free_wait_queue test",
+            "[lock_free_wait_queue] [threaded]" ) {
+
+  SECTION ( "1 reader, 1 writer thread, 1000 slice" ) {
+    REQUIRE ( threaded_test(1, 1, 1000, "cool, lit, sup"s) );
+  }
+  SECTION ( "5 reader, 3 writer threads, 10000 slice" ) {
+    REQUIRE ( threaded_test(5, 3, 10000, "cool, lit, sup"s) );
+  }
+  SECTION ( "20 reader, 20 writer threads, 5000 slice" ) {
+    REQUIRE ( threaded_test(20, 20, 5000, "cool, lit, sup"s) );
+  }
+}
+
+TEST_CASE ( "Threaded lock_free_wait_queue test, blocked readers unblocked by request_stop",
+            "[lock_free_wait_queue] [threaded] [stop]" ) {
+
+  lf_wq wq;
+  auto fut1 = std::async (std::launch::async, [&wq] { return wq.wait_and_pop(); } );
+  auto fut2 = std::async (std::launch::async, [&wq] { return wq.wait_and_pop(); } );
+  std::this_thread::sleep_for(std::chrono::milliseconds(50));
+  REQUIRE (wq.request_stop());
+  REQUIRE_FALSE (fut1.get());
+  REQUIRE_FALSE (fut2.get());
+}
@@ -0,0 +1,142 @@
+/** @file
+ *
+ * @brief Test scenarios for @c numa_wait_queue and the @c chops::numa placement utilities.
+ *
+ * The scenarios work on a single node host, where every sub-queue count is 1 and all
+ * of the placement falls back to node 0.
+ *
+ * @author Cliff Green
+ *
+ * @copyright (c) 2024 by Cliff Green
+ *
+ * Distributed under the Boost Software License, Version 1.0.
+ * (See accompanying file LICENSE.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+ *
+ */
+
+#include <cstddef> // std::size_t
+#include <cstdint> // std::uintptr_t
+#include <string>
+#include <vector>
+#include <memory_resource>
+#include <chrono>
+
+#include <thread>
+#include <future> // std::async
+#include <stop_token>
+
+#include "catch2/catch_test_macros.hpp"
+
+#include "queue/numa_wait_queue.hpp"
+
+using namespace std::literals::string_literals;
+
+TEST_CASE ( "numa utilities, topology, memory resource and placement",
+            "[numa_wait_queue] [numa]" ) {
+
+  const auto nodes = chops::numa::node_count();
+  REQUIRE (nodes >= 1u);
+  REQUIRE (chops::numa::this_thread_node() < nodes);
+  REQUIRE_FALSE (chops::numa::pin_this_thread(nodes)); // no such node
+
+  chops::numa::node_memory_resource res { nodes - 1u };
+  REQUIRE (res.node() == nodes - 1u);
+  REQUIRE (res.is_equal(chops::numa::node_memory_resource { nodes - 1u }));
+  REQUIRE_FALSE (res.is_equal(*std::pmr::new_delete_resource()));
+  void* mem = res.allocate(10000u, 64u);
+  REQUIRE (reinterpret_cast<std::uintptr_t>(mem) % 64u == 0u);
+  auto* bytes = static_cast<char*>(mem);
+  bytes[0] = 'a';
+  bytes[9999] = 'z';
+  res.deallocate(mem, 10000u, 64u);
+
+  std::pmr::unsynchronized_pool_resource pool { &res };
+  auto wq = chops::numa::make_on_node<chops::pmr::wait_queue<std::string>>(0u, &pool);
+  REQUIRE (wq->push("placed"s));
+  REQUIRE (*(wq->try_pop()) == "placed"s);
+
+  auto fut = std::async(std::launch::async, [nodes] {
+      auto node = nodes - 1u;
+      // pinning may be refused in a restricted environment
+      return !chops::numa::pin_this_thread(node) || chops::numa::this_thread_node() == node;
+    } );
+  REQUIRE (fut.get());
+}
+
+TEST_CASE ( "numa_wait_queue, non-threaded, local first then steal",
+            "[numa_wait_queue] [non_threaded]" ) {
+
+  chops::numa_wait_queue<std::string> wq;
+  const auto nodes = wq.node_count();
+  REQUIRE (nodes == chops::numa::node_count());
+  REQUIRE (wq.empty());
+  REQUIRE (wq.push("a"s));
+  REQUIRE (wq.emplace_push(2u, 'b'));
+  REQUIRE (wq.node_size(chops::numa::this_thread_node()) == 2u);
+  REQUIRE (*(wq.try_pop_local()) == "a"s);
+  REQUIRE (*(wq.wait_and_pop()) == "bb"s);
+
+  for (std::size_t i {0u}; i < nodes; ++i) {
+    REQUIRE (wq.emplace_push_to(i, "n"s + std::to_string(i)));
+  }
+  REQUIRE (wq.size() == nodes);
+  REQUIRE (*(wq.try_pop()) == "n"s + std::to_string(chops::numa::this_thread_node()));
+  std::size_t cnt {1u};
+  while (wq.try_pop()) { // remote nodes are stolen from
+    ++cnt;
+  }
+  REQUIRE (cnt == nodes);
+  REQUIRE (wq.empty());
+
+  REQUIRE (wq.push("c"s));
+  REQUIRE (wq.request_stop());
+  REQUIRE (wq.stop_requested());
+  REQUIRE_FALSE (wq.push("d"s));
+  REQUIRE_FALSE (wq.try_pop());
+  REQUIRE_FALSE (wq.wait_and_pop());
+}
+
+TEST_CASE ( "numa_wait_queue, threaded, writers and readers pinned per node",
+            "[numa_wait_queue] [threaded]" ) {
+
+  constexpr int tot = 10000;
+  constexpr std::size_t threads_per_node = 2u;
+  std::stop_source src;
+  chops::numa_wait_queue<int> wq { src.get_token() };
+  const auto nodes = wq.node_count();
+
+  std::vector<std::future<int>> rd_futs;
+  for (std::size_t i {0u}; i < nodes * threads_per_node; ++i) {
+    rd_futs.push_back(std::async(std::launch::async, [&wq, i] {
+        (void) chops::numa::pin_this_thread(i % chops::numa::node_count());
+        int cnt {0};
+        while (wq.wait_and_pop()) {
+          ++cnt;
+        }
+        return cnt;
+      } ) );
+  }
+  std::vector<std::future<void>> wr_futs;
+  for (std::size_t i {0u}; i < nodes * threads_per_node; ++i) {
+    wr_futs.push_back(std::async(std::launch::async, [&wq, i] {
+        (void) chops::numa::pin_this_thread(i % chops::numa::node_count());
+        for (int j {0}; j < tot; ++j) {
+          wq.push(j);
+        }
+      } ) );
+  }
+  for (auto& fut : wr_futs) {
+    fut.get();
+  }
+  while (!wq.empty()) {
+    std::this_thread::sleep_for(std::chrono::milliseconds(5));
+  }
+  src.request_stop();
+  REQUIRE_FALSE (wq.request_stop()); // external stop token
+  int cnt {0};
+  for (auto& fut : rd_futs) {
+    cnt += fut.get();
+  }
+  REQUIRE (cnt == tot * static_cast<int>(nodes * threads_per_node));
+}
+
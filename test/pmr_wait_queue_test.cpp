@@ -0,0 +1,123 @@
+/** @file
+ *
+ * @brief Test scenarios for @c chops::pmr::wait_queue.
+ *
+ * @author Cliff Green
+ *
+ * @copyright (c) 2024 by Cliff Green
+ *
+ * Distributed under the Boost Software License, Version 1.0.
+ * (See accompanying file LICENSE.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+ *
+ */
+
+#include <cstddef> // std::size_t
+#include <string>
+#include <memory_resource>
+#include <stop_token>
+
+#include <thread>
+#include <future> // std::async
+
+#include "catch2/catch_test_macros.hpp"
+
+#include "queue/pmr_wait_queue.hpp"
+
+using namespace std::literals::string_literals;
+
+constexpr int N = 1000;
+
+// forwards to an upstream resource, counting allocations
+class counting_resource : public std::pmr::memory_resource {
+public:
+  std::size_t m_allocs {0u};
+  std::size_t m_deallocs {0u};
+
+private:
+  auto do_allocate(std::size_t bytes, std::size_t align) -> void* override {
+    ++m_allocs;
+    return std::pmr::new_delete_resource()->allocate(bytes, align);
+  }
+  auto do_deallocate(void* p, std::size_t bytes, std::size_t align) -> void override {
+    ++m_deallocs;
+    std::pmr::new_delete_resource()->deallocate(p, bytes, align);
+  }
+  auto do_is_equal(const std::pmr::memory_resource& other) const noexcept -> bool override {
+    return this == &other;
+  }
+};
+
+TEST_CASE ( "pmr wait_queue, memory allocated from supplied resource",
+            "[pmr_wait_queue] [non_threaded]" ) {
+
+  counting_resource res;
+  {
+    chops::pmr::wait_queue<int> wq { &res };
+    REQUIRE (wq.empty());
+    for (int i {0}; i < N; ++i) {
+      REQUIRE (wq.push(i));
+    }
+    REQUIRE (res.m_allocs > 0u);
+    REQUIRE (*(wq.try_pop()) == 0);
+
+    auto ctr = wq.drain(); // same memory resource as internal container
+    REQUIRE (ctr.size() == static_cast<std::size_t>(N-1));
+    REQUIRE (ctr.get_allocator().resource() == &res);
+    REQUIRE (wq.empty());
+    REQUIRE (wq.push(42));
+    REQUIRE (*(wq.wait_and_pop()) == 42);
+  }
+  REQUIRE (res.m_allocs == res.m_deallocs);
+}
+
+TEST_CASE ( "pmr wait_queue with pool resource, steady state is allocation free",
+            "[pmr_wait_queue] [non_threaded] [pool]" ) {
+
+  counting_resource upstream;
+  std::pmr::unsynchronized_pool_resource pool { &upstream };
+  chops::pmr::wait_queue<std::pmr::string> wq { &pool };
+
+  auto cycle = [&wq] {
+    for (int i {0}; i < N; ++i) {
+      wq.push(std::pmr::string { "pushing and popping, longer than a small string" });
+    }
+    for (int i {0}; i < N; ++i) {
+      REQUIRE (wq.try_pop());
+    }
+  };
+  for (int i {0}; i < 4; ++i) {
+    cycle(); // warm up, the pool acquires memory from upstream until steady state
+  }
+  const auto warm_allocs = upstream.m_allocs;
+  REQUIRE (warm_allocs > 0u);
+  for (int i {0}; i < 10; ++i) {
+    cycle();
+  }
+  REQUIRE (upstream.m_allocs == warm_allocs);
+}
+
+TEST_CASE ( "pmr wait_queue, threaded with external stop_token",
+            "[pmr_wait_queue] [threaded] [stop_token]" ) {
+
+  std::stop_source src;
+  std::pmr::synchronized_pool_resource pool;
+  chops::pmr::wait_queue<int> wq { src.get_token(), &pool };
+
+  auto pop_fut = std::async (std::launch::async, [&wq] {
+      int sum {0};
+      while (auto val = wq.wait_and_pop()) {
+        sum += *val;
+        if (sum == (N * (N-1)) / 2) {
+          break;
+        }
+      }
+      return sum;
+    } );
+  for (int i {0}; i < N; ++i) {
+    REQUIRE (wq.push(i));
+  }
+  REQUIRE (pop_fut.get() == (N * (N-1)) / 2);
+  src.request_stop();
+  REQUIRE_FALSE (wq.push(N));
+}
+
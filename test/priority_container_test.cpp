@@ -0,0 +1,207 @@
+/** @file
+ *
+ * @brief Test scenarios for @c priority_heap and @c priority_lanes containers, and the
+ * priority @c wait_queue aliases.
+ *
+ * @author Cliff Green
+ *
+ * @copyright (c) 2024 by Cliff Green
+ *
+ * Distributed under the Boost Software License, Version 1.0.
+ * (See accompanying file LICENSE.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+ *
+ */
+
+#include <cstddef> // std::size_t
+#include <string>
+#include <vector>
+#include <functional> // std::greater
+#include <random>
+#include <algorithm> // std::sort
+#include <memory> // std::unique_ptr
+
+#include <thread>
+#include <future> // std::async
+
+#include "catch2/catch_test_macros.hpp"
+#include "catch2/catch_template_test_macros.hpp"
+
+#include "queue/priority_container.hpp"
+
+using namespace std::literals::string_literals;
+
+enum class prio : std::size_t { control = 0u, normal = 1u, bulk = 2u };
+
+struct msg {
+  prio m_prio;
+  int  m_seq;
+};
+
+struct msg_lane {
+  auto operator()(const msg& m) const noexcept -> std::size_t {
+    return static_cast<std::size_t>(m.m_prio);
+  }
+};
+
+template <typename H>
+auto pop_all(H& heap) -> std::vector<typename H::value_type> {
+  std::vector<typename H::value_type> vec;
+  while (!heap.empty()) {
+    vec.push_back(heap.front());
+    heap.pop_front();
+  }
+  return vec;
+}
+
+TEMPLATE_TEST_CASE ( "priority_heap ordering, binary and d-ary",
+                     "[priority_heap]",
+                     (chops::priority_heap<int>), (chops::priority_heap<int, std::less<int>, 4u>),
+                     (chops::priority_heap<int, std::less<int>, 7u>) ) {
+
+  std::mt19937 gen {42u};
+  std::uniform_int_distribution<int> dist {0, 500};
+  std::vector<int> vals;
+  TestType heap;
+  REQUIRE (heap.empty());
+  for (int i {0}; i < 1000; ++i) {
+    vals.push_back(dist(gen));
+    if (i % 2) {
+      heap.push_back(vals.back());
+    }
+    else {
+      heap.emplace_back(vals.back());
+    }
+  }
+  REQUIRE (heap.size() == 1000u);
+  std::sort(vals.begin(), vals.end(), std::greater<int>{});
+  REQUIRE (heap.front() == vals.front());
+
+  // interleave pops and pushes
+  for (int i {0}; i < 100; ++i) {
+    heap.pop_front();
+  }
+  for (int i {0}; i < 100; ++i) {
+    heap.push_back(vals[i]);
+  }
+  REQUIRE (pop_all(heap) == vals);
+}
+
+TEST_CASE ( "priority_heap with comparator object and move-only type",
+            "[priority_heap] [comparator]" ) {
+
+  chops::priority_heap<int, std::greater<int>> min_heap { std::greater<int>{} };
+  for (int i : { 5, 3, 9, 1, 7 }) {
+    min_heap.push_back(i);
+  }
+  REQUIRE (pop_all(min_heap) == std::vector<int> { 1, 3, 5, 7, 9 });
+
+  auto cmp = [] (const std::unique_ptr<int>& lhs, const std::unique_ptr<int>& rhs) {
+    return *lhs < *rhs;
+  };
+  chops::priority_heap<std::unique_ptr<int>, decltype(cmp)> up_heap;
+  up_heap.push_back(std::make_unique<int>(2));
+  up_heap.emplace_back(std::make_unique<int>(8));
+  up_heap.push_back(std::make_unique<int>(4));
+  REQUIRE (*(up_heap.front()) == 8);
+  up_heap.pop_front();
+  REQUIRE (*(up_heap.front()) == 4);
+}
+
+TEST_CASE ( "priority_lanes, FIFO within lane and highest lane first",
+            "[priority_lanes]" ) {
+
+  chops::priority_lanes<msg, 3u, msg_lane> lanes;
+  REQUIRE (lanes.empty());
+  lanes.push_back(msg{prio::bulk, 0});
+  lanes.push_back(msg{prio::normal, 1});
+  lanes.emplace_back(prio::bulk, 2);
+  lanes.push_back(msg{prio::control, 3});
+  lanes.push_back(msg{prio::normal, 4});
+  REQUIRE (lanes.size() == 5u);
+  REQUIRE (lanes.lane_size(2u) == 2u);
+
+  std::vector<int> seqs;
+  for (const auto& m : lanes) { // priority order
+    seqs.push_back(m.m_seq);
+  }
+  REQUIRE (seqs == std::vector<int> { 3, 1, 4, 0, 2 });
+
+  seqs.clear();
+  while (!lanes.empty()) {
+    const int seq = lanes.front().m_seq;
+    seqs.push_back(seq);
+    lanes.pop_front();
+    if (seq == 1) {
+      lanes.push_back(msg{prio::control, 5}); // overtakes remaining lower priorities
+    }
+  }
+  REQUIRE (seqs == std::vector<int> { 3, 1, 5, 4, 0, 2 });
+  REQUIRE (lanes.begin() == lanes.end());
+}
+
+TEST_CASE ( "priority_wait_queue, non-threaded wait_queue operations",
+            "[priority_wait_queue] [non_threaded]" ) {
+
+  chops::priority_wait_queue<std::string> wq;
+  REQUIRE (wq.push("b"s));
+  REQUIRE (wq.emplace_push("d"s));
+  REQUIRE (wq.push("a"s));
+  REQUIRE (wq.push("c"s));
+  REQUIRE (wq.size() == 4u);
+  REQUIRE (*(wq.try_pop()) == "d"s);
+  REQUIRE (*(wq.wait_and_pop()) == "c"s);
+  auto ctr = wq.drain();
+  REQUIRE (wq.empty());
+  REQUIRE (pop_all(ctr) == std::vector<std::string> { "b"s, "a"s });
+  wq.request_stop();
+  REQUIRE_FALSE (wq.push("e"s));
+}
+
+TEST_CASE ( "lane_wait_queue, threaded, control messages overtake bulk data",
+            "[lane_wait_queue] [threaded]" ) {
+
+  constexpr int tot = 2000;
+  constexpr int ctl = 10;
+  chops::lane_wait_queue<msg, 3u, msg_lane> wq;
+
+  // backlog of bulk data, then control messages
+  for (int i {0}; i < tot; ++i) {
+    REQUIRE (wq.push(msg{prio::bulk, i}));
+  }
+  for (int i {0}; i < ctl; ++i) {
+    REQUIRE (wq.push(msg{prio::control, i}));
+  }
+  // reader checks priority order and FIFO order within each lane, while a writer
+  // interleaves more bulk and control messages
+  auto pop_fut = std::async (std::launch::async, [&wq] {
+      int next_seq[3] { 0, 0, 0 };
+      int bulk_before_control {-1};
+      int cnt {0};
+      while (auto m = wq.wait_and_pop()) {
+        auto lane = static_cast<std::size_t>(m->m_prio);
+        if (m->m_seq != next_seq[lane]) {
+          return false;
+        }
+        ++next_seq[lane];
+        if (m->m_prio == prio::control && bulk_before_control < 0) {
+          bulk_before_control = next_seq[2];
+        }
+        if (++cnt == 2 * (tot + ctl)) {
+          break;
+        }
+      }
+      return bulk_before_control == 0;
+    } );
+  auto push_fut = std::async (std::launch::async, [&wq] {
+      for (int i {0}; i < tot; ++i) {
+        wq.push(msg{prio::bulk, tot + i});
+        if (i % (tot / ctl) == 0) {
+          wq.push(msg{prio::control, ctl + (i / (tot / ctl))});
+        }
+      }
+    } );
+  push_fut.get();
+  REQUIRE (pop_fut.get());
+  REQUIRE (wq.empty());
+}
+
@@ -0,0 +1,105 @@
+/** @file
+ *
+ * @brief Test scenarios for @c queue_array class template and @c cache_aligned wrapper.
+ *
+ * @author Cliff Green
+ *
+ * @copyright (c) 2024 by Cliff Green
+ *
+ * Distributed under the Boost Software License, Version 1.0.
+ * (See accompanying file LICENSE.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+ *
+ */
+
+#include <cstddef> // std::size_t
+#include <cstdint> // std::uintptr_t
+#include <string>
+#include <deque>
+#include <type_traits> // std::is_same_v
+#include <stop_token>
+
+#include "catch2/catch_test_macros.hpp"
+#include "catch2/catch_template_test_macros.hpp"
+
+#include "queue/queue_array.hpp"
+#include "queue/wait_queue.hpp"
+#include "queue/lock_free_wait_queue.hpp"
+
+using namespace std::literals::string_literals;
+
+constexpr std::size_t Num = 5u;
+
+TEMPLATE_TEST_CASE ( "cache_aligned and queue_array layout",
+                     "[queue_array] [cache_aligned]",
+                     chops::wait_queue<int>, chops::wait_queue<std::string>,
+                     (chops::wait_queue<int, std::deque<int>, chops::block_wait,
+                                        chops::null_stats, chops::padded_layout>),
+                     (chops::lock_free_wait_queue<int, 16u>) ) {
+
+  using wrapped = chops::cache_aligned<TestType>;
+  static_assert (alignof(wrapped) >= chops::cache_line_size);
+  static_assert (sizeof(wrapped) % chops::cache_line_size == 0u);
+
+  chops::queue_array<TestType, Num> qs;
+  REQUIRE (qs.size() == Num);
+  for (std::size_t i {1u}; i < Num; ++i) {
+    const auto prev = reinterpret_cast<std::uintptr_t>(&qs[i-1u]);
+    const auto cur = reinterpret_cast<std::uintptr_t>(&qs[i]);
+    REQUIRE (prev % chops::cache_line_size == 0u);
+    REQUIRE (cur - prev >= sizeof(TestType));
+    REQUIRE (cur % chops::cache_line_size == 0u);
+  }
+}
+
+TEST_CASE ( "wait_queue compact and padded layouts",
+            "[wait_queue] [layout]" ) {
+
+  using compact_wq = chops::wait_queue<int>;
+  using padded_wq = chops::wait_queue<int, std::deque<int>, chops::block_wait,
+                                      chops::null_stats, chops::padded_layout>;
+  static_assert (std::is_same_v<compact_wq, chops::wait_queue<int, std::deque<int>, chops::block_wait,
+                                                              chops::null_stats, chops::compact_layout>>);
+  static_assert (alignof(compact_wq) < chops::cache_line_size);
+  static_assert (alignof(padded_wq) == chops::cache_line_size);
+  static_assert (sizeof(compact_wq) < sizeof(padded_wq));
+  static_assert (sizeof(padded_wq) >= 3u * chops::cache_line_size); // stop, lock, reader lines
+
+  padded_wq wq;
+  REQUIRE (reinterpret_cast<std::uintptr_t>(&wq) % chops::cache_line_size == 0u);
+  REQUIRE (wq.push(42));
+  REQUIRE (*(wq.try_pop()) == 42);
+}
+
+TEST_CASE ( "queue_array of wait_queue, push and pop and stop",
+            "[queue_array] [wait_queue]" ) {
+
+  chops::queue_array<chops::wait_queue<int>, Num> qs;
+  for (std::size_t i {0u}; i < Num; ++i) {
+    REQUIRE (qs[i].push(static_cast<int>(i)));
+  }
+  int sum {0};
+  for (auto& q : qs) {
+    sum += *(q.try_pop());
+    REQUIRE (q.empty());
+  }
+  REQUIRE (sum == 10);
+  REQUIRE (qs.request_stop());
+  for (const auto& q : qs) {
+    REQUIRE (q.stop_requested());
+  }
+}
+
+TEST_CASE ( "queue_array of wait_queue, external stop_token",
+            "[queue_array] [wait_queue] [stop_token]" ) {
+
+  std::stop_source src;
+  chops::queue_array<chops::wait_queue<int>, Num> qs { src.get_token() };
+  REQUIRE (qs[2].push(42));
+  REQUIRE_FALSE (qs.request_stop()); // no effect, external stop token
+  src.request_stop();
+  for (const auto& q : qs) {
+    REQUIRE (q.stop_requested());
+  }
+  REQUIRE_FALSE (qs[2].push(43));
+}
+
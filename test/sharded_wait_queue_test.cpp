@@ -0,0 +1,146 @@
+/** @file
+ *
+ * @brief Test scenarios for @c sharded_wait_queue class template.
+ *
+ * @author Cliff Green
+ *
+ * @copyright (c) 2024 by Cliff Green
+ *
+ * Distributed under the Boost Software License, Version 1.0.
+ * (See accompanying file LICENSE.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+ *
+ */
+
+#include <string>
+#include <optional>
+#include <chrono>
+#include <vector>
+#include <set>
+#include <memory> // std::unique_ptr, std::make_unique
+
+#include <thread>
+#include <future> // std::async
+#include <mutex>
+#include <stop_token>
+
+#include "catch2/catch_test_macros.hpp"
+#include "catch2/catch_template_test_macros.hpp"
+
+#include "queue/sharded_wait_queue.hpp"
+
+using namespace std::literals::string_literals;
+
+constexpr int N = 40;
+
+TEMPLATE_TEST_CASE ( "Non-threaded sharded_wait_queue test",
+                     "[sharded_wait_queue] [non_threaded]",
+                     int, std::string ) {
+
+  chops::sharded_wait_queue<TestType> wq;
+  TestType val { };
+  if constexpr (std::is_arithmetic_v<TestType>) {
+    val = 42;
+  }
+  else {
+    val = "Howzit going, bro!";
+  }
+
+  REQUIRE (wq.empty());
+  REQUIRE (wq.shard_count() == 8u);
+  for (int i {0}; i < N; ++i) {
+    REQUIRE (wq.push(val));
+  }
+  REQUIRE (wq.size() == N);
+  for (std::size_t i {0u}; i < wq.shard_count(); ++i) {
+    REQUIRE (wq.emplace_push_to(i, val)); // one in each shard
+  }
+  REQUIRE (wq.size() == N + wq.shard_count());
+  for (int i {0}; i < N; ++i) {
+    REQUIRE (*(wq.wait_and_pop()) == val);
+  }
+  for (std::size_t i {0u}; i < wq.shard_count(); ++i) {
+    REQUIRE (*(wq.try_pop()) == val); // stolen from other shards
+  }
+  REQUIRE (wq.empty());
+  REQUIRE_FALSE (wq.try_pop());
+
+  REQUIRE (wq.request_stop());
+  REQUIRE (wq.stop_requested());
+  REQUIRE_FALSE (wq.push(val));
+  REQUIRE_FALSE (wq.wait_and_pop());
+}
+
+TEST_CASE ( "Non-threaded sharded_wait_queue test, single thread FIFO order",
+            "[sharded_wait_queue] [non_threaded] [fifo]" ) {
+
+  chops::sharded_wait_queue<int, std::deque<int>, 4u> wq;
+  for (int i {0}; i < N; ++i) {
+    REQUIRE (wq.push(i));
+  }
+  for (int i {0}; i < N; ++i) {
+    REQUIRE (*(wq.try_pop()) == i);
+  }
+}
+
+TEST_CASE ( "Threaded sharded_wait_queue test, many writers and readers",
+            "[sharded_wait_queue] [threaded]" ) {
+
+  constexpr int num_writers { 20 };
+  constexpr int num_readers { 4 };
+  constexpr int slice { 1000 };
+
+  chops::sharded_wait_queue<int> wq;
+  std::set<int> s;
+  std::mutex mut;
+
+  {
+    std::vector<std::jthread> rd_thrs;
+    for (int i {0}; i < num_readers; ++i) {
+      rd_thrs.emplace_back( [&wq, &s, &mut] {
+          while (auto val = wq.wait_and_pop()) {
+            std::scoped_lock lk {mut};
+            s.insert(*val);
+          }
+        } );
+    }
+    {
+      std::vector<std::jthread> wr_thrs;
+      for (int i {0}; i < num_writers; ++i) {
+        wr_thrs.emplace_back( [&wq, i] {
+            for (int j {0}; j < slice; ++j) {
+              wq.push(i * slice + j);
+            }
+          } );
+      }
+    } // writers joined
+    while (true) {
+      {
+        std::scoped_lock lk {mut};
+        if (s.size() == static_cast<std::size_t>(num_writers * slice)) {
+          break;
+        }
+      }
+      std::this_thread::sleep_for(std::chrono::milliseconds(5));
+    }
+    REQUIRE (wq.empty());
+    REQUIRE (wq.request_stop()); // unblocks readers
+  } // readers joined
+  REQUIRE (s.size() == static_cast<std::size_t>(num_writers * slice));
+  REQUIRE (*(s.cbegin()) == 0);
+  REQUIRE (*(s.crbegin()) == (num_writers * slice - 1));
+}
+
+TEST_CASE ( "Threaded sharded_wait_queue test, external stop_token",
+            "[sharded_wait_queue] [threaded] [stop_token]" ) {
+
+  std::stop_source src;
+  chops::sharded_wait_queue<int> wq { src.get_token() };
+  REQUIRE_FALSE (wq.request_stop()); // no effect, external stop token
+
+  auto pop_fut = std::async (std::launch::async, [&wq] { return wq.wait_and_pop(); } );
+  std::this_thread::sleep_for(std::chrono::milliseconds(50));
+  src.request_stop();
+  REQUIRE_FALSE (pop_fut.get());
+  REQUIRE (wq.stop_requested());
+}
+
@@ -0,0 +1,155 @@
+/** @file
+ *
+ * @brief Test scenarios for @c shm_wait_queue, within a process and across processes.
+ *
+ * @author Cliff Green
+ *
+ * @copyright (c) 2024 by Cliff Green
+ *
+ * Distributed under the Boost Software License, Version 1.0.
+ * (See accompanying file LICENSE.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+ *
+ */
+
+#include <cstddef> // std::size_t
+#include <cstdint> // std::uint64_t
+#include <string>
+#include <vector>
+#include <chrono>
+
+#include <thread>
+#include <future> // std::async
+
+#include <sys/mman.h> // mmap
+#include <sys/wait.h> // waitpid
+#include <unistd.h> // fork, getpid
+
+#include "catch2/catch_test_macros.hpp"
+
+#include "queue/shm_wait_queue.hpp"
+
+struct md_msg {
+  int           m_seq;
+  double        m_px;
+  std::uint64_t m_sum;
+
+  md_msg(int seq, double px) : m_seq(seq), m_px(px), m_sum(static_cast<std::uint64_t>(seq) * 3u) { }
+};
+
+constexpr std::size_t cap = 64u;
+using md_queue = chops::shm_wait_queue<md_msg, cap>;
+
+auto unique_name(const char* tag) -> std::string {
+  return std::string { "/chops_shm_test_" } + tag + "_" + std::to_string(::getpid());
+}
+
+TEST_CASE ( "shm_wait_queue, named region create, open and non-threaded operations",
+            "[shm_wait_queue] [non_threaded]" ) {
+
+  const auto name = unique_name("named");
+  REQUIRE_FALSE (md_queue::open(name));
+  auto wq = md_queue::create(name);
+  REQUIRE (wq);
+  REQUIRE_FALSE (md_queue::create(name)); // already exists
+  REQUIRE_FALSE (chops::shm_wait_queue<md_msg, 2u * cap>::open(name)); // different layout
+
+  auto other = md_queue::open(name);
+  REQUIRE (other);
+  REQUIRE (wq->empty());
+  REQUIRE (wq->capacity() == cap);
+  for (int i {0}; i < static_cast<int>(cap); ++i) {
+    REQUIRE (wq->push(md_msg{i, i * 0.5}));
+  }
+  REQUIRE_FALSE (wq->push(md_msg{99, 0.0})); // full
+  REQUIRE (other->size() == cap);
+  for (int i {0}; i < static_cast<int>(cap); ++i) {
+    auto val = other->try_pop();
+    REQUIRE (val);
+    REQUIRE (val->m_seq == i);
+    REQUIRE (val->m_px == i * 0.5);
+    REQUIRE (val->m_sum == static_cast<std::uint64_t>(i) * 3u);
+  }
+  REQUIRE_FALSE (wq->try_pop());
+
+  REQUIRE (wq->push(md_msg{1, 1.0}));
+  REQUIRE (other->request_stop());
+  REQUIRE_FALSE (wq->request_stop());
+  REQUIRE (wq->stop_requested());
+  REQUIRE_FALSE (wq->push(md_msg{2, 2.0}));
+  REQUIRE_FALSE (wq->wait_and_pop());
+
+  wq.reset(); // creator unlinks the name, the other mapping is still usable
+  REQUIRE_FALSE (md_queue::open(name));
+  REQUIRE (other->stop_requested());
+}
+
+TEST_CASE ( "shm_wait_queue, threaded, blocking push and pop within a process",
+            "[shm_wait_queue] [threaded]" ) {
+
+  constexpr int tot = 10000;
+  const auto name = unique_name("threaded");
+  auto wq = md_queue::create(name);
+  REQUIRE (wq);
+
+  auto rd_fut = std::async (std::launch::async, [&wq] {
+      int expected {0};
+      while (auto val = wq->wait_and_pop()) {
+        if (val->m_seq != expected++) {
+          return false;
+        }
+        if (expected == tot) {
+          break;
+        }
+      }
+      return expected == tot;
+    } );
+  for (int i {0}; i < tot; ++i) {
+    REQUIRE (wq->wait_and_push(md_msg{i, 0.0}));
+  }
+  REQUIRE (rd_fut.get());
+
+  auto blocked_fut = std::async (std::launch::async, [&wq] { return wq->wait_and_pop(); } );
+  std::this_thread::sleep_for(std::chrono::milliseconds(20));
+  wq->request_stop();
+  REQUIRE_FALSE (blocked_fut.get());
+}
+
+TEST_CASE ( "shm_wait_queue, forked producer process over anonymous shared memory",
+            "[shm_wait_queue] [process]" ) {
+
+  constexpr int tot = 20000;
+  void* mem = ::mmap(nullptr, md_queue::region_size(), PROT_READ | PROT_WRITE,
+                     MAP_SHARED | MAP_ANONYMOUS, -1, 0);
+  REQUIRE (mem != MAP_FAILED);
+  REQUIRE_FALSE (md_queue::attach(mem)); // not yet initialized
+  auto wq = md_queue::init(mem);
+
+  auto pid = ::fork();
+  REQUIRE (pid >= 0);
+  if (pid == 0) { // child, producer
+    auto child_wq = md_queue::attach(mem);
+    bool ok = child_wq.has_value();
+    for (int i {0}; ok && i < tot; ++i) {
+      ok = child_wq->wait_and_push(md_msg{i, i * 2.0});
+    }
+    ::_exit(ok ? 0 : 1);
+  }
+  int expected {0};
+  bool in_order {true};
+  while (expected < tot) {
+    auto val = wq.wait_and_pop();
+    if (!val || val->m_seq != expected || val->m_px != expected * 2.0) {
+      in_order = false;
+      break;
+    }
+    ++expected;
+  }
+  int status {-1};
+  REQUIRE (::waitpid(pid, &status, 0) == pid);
+  REQUIRE (WIFEXITED(status));
+  REQUIRE (WEXITSTATUS(status) == 0);
+  REQUIRE (in_order);
+  REQUIRE (wq.empty());
+  ::munmap(mem, md_queue::region_size());
+}
+
@@ -0,0 +1,128 @@
+/** @file
+ *
+ * @brief Test scenarios for @c spsc_wait_queue class template.
+ *
+ * @author Cliff Green
+ *
+ * @copyright (c) 2024 by Cliff Green
+ *
+ * Distributed under the Boost Software License, Version 1.0.
+ * (See accompanying file LICENSE.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+ *
+ */
+
+#include <string>
+#include <optional>
+#include <chrono>
+#include <memory> // std::unique_ptr, std::make_unique
+#include <type_traits> // std::is_arithmetic
+
+#include <thread>
+#include <future> // std::async
+#include <stop_token>
+
+#include "catch2/catch_test_macros.hpp"
+#include "catch2/catch_template_test_macros.hpp"
+
+#include "queue/spsc_wait_queue.hpp"
+
+using namespace std::literals::string_literals;
+
+constexpr std::size_t Cap = 16;
+
+TEMPLATE_TEST_CASE ( "Non-threaded spsc_wait_queue test",
+                     "[spsc_wait_queue] [non_threaded]",
+                     int, double, std::string ) {
+
+  auto wq_ptr = std::make_unique<chops::spsc_wait_queue<TestType, Cap>>();
+  auto& wq = *wq_ptr;
+  TestType val { };
+  if constexpr (std::is_arithmetic_v<TestType>) {
+    val = 42;
+  }
+  else {
+    val = "Howzit going, bro!";
+  }
+
+  REQUIRE (wq.empty());
+  REQUIRE (wq.capacity() == Cap);
+  for (std::size_t i {0u}; i < Cap; ++i) {
+    REQUIRE (wq.push(val));
+  }
+  REQUIRE (wq.size() == Cap);
+  REQUIRE_FALSE (wq.push(val)); // full
+  REQUIRE (*(wq.try_pop()) == val);
+  REQUIRE (wq.emplace_push(val));
+  for (std::size_t i {0u}; i < Cap; ++i) {
+    REQUIRE (*(wq.wait_and_pop()) == val);
+  }
+  REQUIRE (wq.empty());
+  REQUIRE_FALSE (wq.try_pop());
+
+  // leave some elements in the queue for the destructor
+  REQUIRE (wq.push(val));
+  REQUIRE (wq.push(val));
+  REQUIRE (wq.request_stop());
+  REQUIRE (wq.stop_requested());
+  REQUIRE_FALSE (wq.push(val));
+  REQUIRE_FALSE (wq.try_pop());
+}
+
+TEST_CASE ( "Non-threaded spsc_wait_queue test, move only type",
+            "[spsc_wait_queue] [no_copy]" ) {
+
+  chops::spsc_wait_queue<std::unique_ptr<int>, Cap> wq;
+  REQUIRE (wq.push(std::make_unique<int>(42)));
+  REQUIRE (wq.emplace_push(new int(43)));
+  REQUIRE (**(wq.try_pop()) == 42);
+  REQUIRE (**(wq.try_pop()) == 43);
+  REQUIRE (wq.empty());
+}
+
+TEST_CASE ( "Threaded spsc_wait_queue test, wait_and_push and wait_and_pop",
+            "[spsc_wait_queue] [threaded]" ) {
+
+  chops::spsc_wait_queue<std::size_t, Cap> wq;
+  constexpr std::size_t tot { 200000u };
+
+  auto push_fut = std::async (std::launch::async, [&wq] {
+      for (std::size_t i {0u}; i < tot; ++i) {
+        if (!wq.wait_and_push(i)) {
+          return false;
+        }
+      }
+      return true;
+    } );
+  for (std::size_t i {0u}; i < tot; ++i) {
+    auto val = wq.wait_and_pop();
+    REQUIRE (val);
+    REQUIRE (*val == i);
+  }
+  REQUIRE (push_fut.get());
+  REQUIRE (wq.empty());
+
+  SECTION ( "Blocked reader is unblocked by request_stop" ) {
+    auto pop_fut = std::async (std::launch::async, [&wq] { return wq.wait_and_pop(); } );
+    std::this_thread::sleep_for(std::chrono::milliseconds(50));
+    REQUIRE (wq.request_stop());
+    REQUIRE_FALSE (pop_fut.get());
+  }
+}
+
+TEST_CASE ( "Threaded spsc_wait_queue test, external stop_token",
+            "[spsc_wait_queue] [threaded] [stop_token]" ) {
+
+  std::stop_source src;
+  chops::spsc_wait_queue<int, Cap> wq { src.get_token() };
+  REQUIRE_FALSE (wq.request_stop()); // no effect, external stop token
+
+  for (std::size_t i {0u}; i < Cap; ++i) {
+    REQUIRE (wq.push(44));
+  }
+  auto push_fut = std::async (std::launch::async, [&wq] { return wq.wait_and_push(55); } );
+  std::this_thread::sleep_for(std::chrono::milliseconds(50));
+  src.request_stop();
+  REQUIRE_FALSE (push_fut.get());
+  REQUIRE (wq.stop_requested());
+}
+
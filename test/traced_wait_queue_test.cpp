@@ -0,0 +1,152 @@
+/** @file
+ *
+ * @brief Test scenarios for @c traced_wait_queue and @c residency_histogram.
+ *
+ * @author Cliff Green
+ *
+ * @copyright (c) 2024 by Cliff Green
+ *
+ * Distributed under the Boost Software License, Version 1.0.
+ * (See accompanying file LICENSE.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+ *
+ */
+
+#include <cstddef> // std::size_t
+#include <cstdint> // std::uint64_t
+#include <string>
+#include <vector>
+#include <chrono>
+
+#include <thread>
+#include <future> // std::async
+
+#include "catch2/catch_test_macros.hpp"
+
+#include "queue/traced_wait_queue.hpp"
+
+using namespace std::literals::string_literals;
+
+static_assert (sizeof(chops::traced_element<int, chops::no_trace::stamp_type>) == sizeof(int));
+
+TEST_CASE ( "residency_histogram, bucketing and percentiles",
+            "[residency_histogram]" ) {
+
+  using hist = chops::residency_histogram;
+  for (std::uint64_t v : { 0ull, 1ull, 7ull, 8ull, 9ull, 15ull, 16ull, 1000ull, 123456789ull, ~0ull }) {
+    auto idx = hist::bucket_index(v);
+    REQUIRE (idx < hist::num_buckets);
+    REQUIRE (v <= hist::bucket_upper(idx));
+    REQUIRE (hist::bucket_upper(idx) - v <= v / hist::sub_buckets); // 12.5% relative error
+    if (idx > 0u) {
+      REQUIRE (v > hist::bucket_upper(idx - 1u));
+    }
+  }
+
+  hist h;
+  REQUIRE (h.count() == 0u);
+  REQUIRE (h.percentile(0.5) == 0u);
+  for (std::uint64_t v {1u}; v <= 1000u; ++v) {
+    h.record(v);
+  }
+  REQUIRE (h.count() == 1000u);
+  REQUIRE (h.max() == 1000u);
+  REQUIRE (h.mean() == 500.5);
+  REQUIRE (h.percentile(1.0) == 1000u);
+  auto p50 = h.percentile(0.5);
+  REQUIRE (p50 >= 500u);
+  REQUIRE (p50 <= 500u + 500u / hist::sub_buckets);
+  auto p99 = h.percentile(0.99);
+  REQUIRE (p99 >= 990u);
+  REQUIRE (p99 <= 1000u);
+  h.reset();
+  REQUIRE (h.count() == 0u);
+  REQUIRE (h.max() == 0u);
+}
+
+TEST_CASE ( "traced_wait_queue, residency time recorded on pop",
+            "[traced_wait_queue] [non_threaded]" ) {
+
+  chops::traced_wait_queue<std::string> wq;
+  REQUIRE (wq.push("a"s));
+  REQUIRE (wq.emplace_push(3u, 'b'));
+  std::this_thread::sleep_for(std::chrono::milliseconds(20));
+  REQUIRE (wq.size() == 2u);
+  REQUIRE (*(wq.try_pop()) == "a"s);
+  REQUIRE (*(wq.wait_and_pop()) == "bbb"s);
+  REQUIRE_FALSE (wq.try_pop());
+  REQUIRE (wq.empty());
+
+  const auto& hist = wq.histogram();
+  REQUIRE (hist.count() == 2u);
+  constexpr std::uint64_t ms20 = 20'000'000u;
+  REQUIRE (hist.percentile(0.5) >= ms20 - ms20 / chops::residency_histogram::sub_buckets);
+  REQUIRE (hist.max() >= ms20);
+
+  REQUIRE (wq.push("c"s));
+  wq.close();
+  REQUIRE_FALSE (wq.push("d"s));
+  REQUIRE (*(wq.wait_and_pop()) == "c"s);
+  REQUIRE (hist.count() == 3u);
+
+  wq.request_stop();
+  REQUIRE (wq.stop_requested());
+  REQUIRE_FALSE (wq.push("e"s));
+  REQUIRE_FALSE (wq.wait_and_pop());
+  REQUIRE (hist.count() == 3u);
+}
+
+TEST_CASE ( "traced_wait_queue, tracing compiled out and TSC tracing",
+            "[traced_wait_queue] [no_trace]" ) {
+
+  chops::traced_wait_queue<int, chops::no_trace> wq;
+  REQUIRE (wq.push(1));
+  REQUIRE (wq.emplace_push(2));
+  REQUIRE (*(wq.try_pop()) == 1);
+  REQUIRE (*(wq.wait_and_pop()) == 2);
+
+#if defined(__x86_64__) || defined(__i386__) || defined(_M_X64) || defined(_M_IX86)
+  chops::traced_wait_queue<int, chops::tsc_trace> tsc_wq;
+  REQUIRE (tsc_wq.push(1));
+  REQUIRE (*(tsc_wq.try_pop()) == 1);
+  REQUIRE (tsc_wq.histogram().count() == 1u);
+#endif
+}
+
+TEST_CASE ( "traced_wait_queue, threaded, concurrent recording and reading",
+            "[traced_wait_queue] [threaded]" ) {
+
+  constexpr int tot = 5000;
+  constexpr int num_readers = 3;
+  chops::traced_wait_queue<int> wq;
+
+  std::vector<std::future<int>> rd_futs;
+  for (int i {0}; i < num_readers; ++i) {
+    rd_futs.push_back(std::async(std::launch::async, [&wq] {
+        int cnt {0};
+        while (wq.wait_and_pop()) {
+          ++cnt;
+        }
+        return cnt;
+      } ) );
+  }
+  auto wr_fut = std::async(std::launch::async, [&wq] {
+      for (int i {0}; i < tot; ++i) {
+        wq.push(i);
+        if (i % 100 == 0) {
+          (void) wq.histogram().percentile(0.99); // concurrent read
+        }
+      }
+    } );
+  wr_fut.get();
+  while (!wq.empty()) {
+    std::this_thread::sleep_for(std::chrono::milliseconds(5));
+  }
+  wq.request_stop();
+  int cnt {0};
+  for (auto& fut : rd_futs) {
+    cnt += fut.get();
+  }
+  REQUIRE (cnt == tot);
+  REQUIRE (wq.histogram().count() == static_cast<std::uint64_t>(tot));
+}
+
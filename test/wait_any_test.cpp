@@ -0,0 +1,180 @@
+/** @file
+ *
+ * @brief Test scenarios for @c queue_select and @c wait_any.
+ *
+ * @author Cliff Green
+ *
+ * @copyright (c) 2024 by Cliff Green
+ *
+ * Distributed under the Boost Software License, Version 1.0.
+ * (See accompanying file LICENSE.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+ *
+ */
+
+#include <cstddef> // std::size_t
+#include <string>
+#include <variant>
+#include <optional>
+#include <vector>
+#include <chrono>
+
+#include <thread>
+#include <future> // std::async
+#include <stop_token>
+
+#include "catch2/catch_test_macros.hpp"
+
+#include "queue/wait_any.hpp"
+#include "queue/wait_queue.hpp"
+
+using namespace std::literals::string_literals;
+
+TEST_CASE ( "queue_select, non-threaded priority and round robin order",
+            "[wait_any] [non_threaded]" ) {
+
+  chops::wait_queue<std::string> ctl_q;
+  chops::wait_queue<int> data_q;
+  chops::wait_queue<int> timer_q;
+
+  {
+    chops::queue_select sel { ctl_q, data_q, timer_q };
+    REQUIRE (sel.size() == 3u);
+    REQUIRE_FALSE (sel.try_any());
+    REQUIRE (data_q.push(1));
+    REQUIRE (data_q.push(2));
+    REQUIRE (timer_q.push(3));
+    REQUIRE (ctl_q.push("stop"s));
+
+    auto val = sel.wait_any();
+    REQUIRE (val);
+    REQUIRE (val->index() == 0u);
+    REQUIRE (std::get<0>(*val) == "stop"s);
+    val = sel.try_any();
+    REQUIRE (val->index() == 1u);
+    REQUIRE (std::get<1>(*val) == 1);
+    val = sel.try_any();
+    REQUIRE (val->index() == 1u); // priority order, data queue before timer queue
+    REQUIRE (std::get<1>(*val) == 2);
+    val = sel.try_any();
+    REQUIRE (val->index() == 2u);
+    REQUIRE (std::get<2>(*val) == 3);
+    REQUIRE_FALSE (sel.try_any());
+  }
+  {
+    chops::queue_select sel { chops::select_order::round_robin, data_q, timer_q };
+    for (int i {0}; i < 3; ++i) {
+      REQUIRE (data_q.push(i));
+      REQUIRE (timer_q.push(10 + i));
+    }
+    std::vector<std::size_t> idxs;
+    while (auto val = sel.try_any()) {
+      idxs.push_back(val->index());
+    }
+    REQUIRE (idxs == std::vector<std::size_t> { 0u, 1u, 0u, 1u, 0u, 1u });
+  }
+  // free function, a queue can be attached again once the queue_select is destroyed
+  REQUIRE (timer_q.push(42));
+  auto val = chops::wait_any(ctl_q, data_q, timer_q);
+  REQUIRE (val);
+  REQUIRE (val->index() == 2u);
+  REQUIRE (std::get<2>(*val) == 42);
+
+  ctl_q.request_stop();
+  data_q.request_stop();
+  REQUIRE (timer_q.push(43));
+  REQUIRE (chops::wait_any(ctl_q, data_q, timer_q));
+  timer_q.request_stop();
+  REQUIRE_FALSE (chops::wait_any(ctl_q, data_q, timer_q)); // all stopped
+}
+
+TEST_CASE ( "queue_select, threaded, one reader blocked on multiple queues",
+            "[wait_any] [threaded]" ) {
+
+  constexpr int tot = 5000;
+  chops::wait_queue<int> q0;
+  chops::wait_queue<std::string> q1;
+  chops::wait_queue<double> q2;
+  chops::queue_select sel { chops::select_order::round_robin, q0, q1, q2 };
+
+  auto rd_fut = std::async (std::launch::async, [&sel] {
+      int cnts[3] { 0, 0, 0 };
+      while (auto val = sel.wait_any()) {
+        ++cnts[val->index()];
+      }
+      return cnts[0] + cnts[1] + cnts[2] == 3 * tot;
+    } );
+
+  {
+    std::vector<std::jthread> wr_thrs;
+    wr_thrs.emplace_back( [&q0] { for (int i {0}; i < tot; ++i) { q0.push(i); } } );
+    wr_thrs.emplace_back( [&q1] { for (int i {0}; i < tot; ++i) { q1.push(std::to_string(i)); } } );
+    wr_thrs.emplace_back( [&q2] { for (int i {0}; i < tot; ++i) { q2.push(i * 0.5); } } );
+  }
+  while (!q0.empty() || !q1.empty() || !q2.empty()) {
+    std::this_thread::sleep_for(std::chrono::milliseconds(5));
+  }
+  q0.request_stop();
+  q1.request_stop();
+  REQUIRE (rd_fut.wait_for(std::chrono::milliseconds(50)) == std::future_status::timeout);
+  q2.request_stop(); // all stopped, reader unblocks
+  REQUIRE (rd_fut.get());
+}
+
+TEST_CASE ( "wait_any, combined stop token",
+            "[wait_any] [threaded] [stop_token]" ) {
+
+  chops::wait_queue<int> q0;
+  chops::wait_queue<int> q1;
+  std::stop_source src;
+
+  auto rd_fut = std::async (std::launch::async, [&q0, &q1, &src] {
+      return chops::wait_any(src.get_token(), q0, q1);
+    } );
+  std::this_thread::sleep_for(std::chrono::milliseconds(50));
+  src.request_stop();
+  REQUIRE_FALSE (rd_fut.get());
+  REQUIRE_FALSE (q0.stop_requested());
+  REQUIRE (q1.push(1)); // queues still usable
+  REQUIRE (*(q1.try_pop()) == 1);
+}
+
+TEST_CASE ( "wait_any, end of stream once every queue is closed and drained",
+            "[wait_any] [threaded] [close]" ) {
+
+  chops::wait_queue<int> q0;
+  chops::wait_queue<std::string> q1;
+  chops::queue_select sel { q0, q1 };
+
+  REQUIRE (q0.push(1));
+  REQUIRE (q1.push("a"s));
+  REQUIRE (q0.close());
+  REQUIRE_FALSE (sel.all_done()); // closed, values remain
+  REQUIRE (sel.wait_any()->index() == 0u);
+  REQUIRE (sel.wait_any()->index() == 1u);
+  REQUIRE_FALSE (sel.all_done()); // q1 open
+
+  auto rd_fut = std::async (std::launch::async, [&sel] {
+      int cnt {0};
+      while (sel.wait_any()) {
+        ++cnt;
+      }
+      return cnt;
+    } );
+  std::this_thread::sleep_for(std::chrono::milliseconds(20));
+  REQUIRE (q1.push("b"s));
+  REQUIRE (q1.close());
+  REQUIRE (rd_fut.wait_for(std::chrono::milliseconds(500)) == std::future_status::ready);
+  REQUIRE (rd_fut.get() == 1);
+  REQUIRE (sel.all_done());
+  REQUIRE_FALSE (sel.all_stopped()); // drained by close, not stopped
+
+  // free function, with a mix of stopped and closed queues
+  chops::wait_queue<int> q2;
+  chops::wait_queue<int> q3;
+  q2.request_stop();
+  auto fut = std::async (std::launch::async, [&q2, &q3] { return chops::wait_any(q2, q3); } );
+  std::this_thread::sleep_for(std::chrono::milliseconds(20));
+  REQUIRE (q3.close());
+  REQUIRE (fut.wait_for(std::chrono::milliseconds(500)) == std::future_status::ready);
+  REQUIRE_FALSE (fut.get());
+}
@@ -20,6 +20,12 @@
 #include <optional>
 #include <chrono>
 #include <type_traits> // std::is_arithmetic
+#include <iterator> // std::back_inserter
+#include <deque>
+#include <cstdint> // std::uint64_t
+#include <coroutine>
+#include <exception> // std::terminate
+#include <span>
 
 #include <thread>
 #include <future> // std::async
@@ -30,6 +36,8 @@
 #include "catch2/catch_template_test_macros.hpp"
 
 #include "queue/wait_queue.hpp"
+#include "queue/fixed_ring.hpp"
+#include "queue/static_wait_queue.hpp"
 
 // circular buffer or ring span container types to use instead of the default std::deque
 #include "nonstd/ring_span.hpp"
@@ -93,7 +101,84 @@ void non_threaded_arithmetic_test(Q& wq, int count) {
 }
 
 template <typename Q>
-void non_threaded_test (Q& wq) {
+void non_threaded_bulk_test(Q& wq, const typename Q::value_type& val, int count) {
+
+  using val_type = typename Q::value_type;
+
+  REQUIRE (wq.empty());
+
+  std::vector<val_type> src (count, val);
+  REQUIRE (wq.push_range(src.begin(), src.end()));
+  REQUIRE (wq.size() == count);
+
+  std::vector<val_type> dest;
+  REQUIRE (wq.try_pop_many(std::back_inserter(dest), count/2) == count/2);
+  REQUIRE (wq.size() == (count - count/2));
+  // wait_and_pop_many should immediately return if the queue is non empty
+  REQUIRE (wq.wait_and_pop_many(std::back_inserter(dest), count) == (count - count/2));
+  REQUIRE (dest == src);
+  REQUIRE (wq.empty());
+  REQUIRE (wq.try_pop_many(std::back_inserter(dest), count) == 0);
+
+  REQUIRE (wq.push_range(std::move(src)));
+  REQUIRE (wq.size() == count);
+  dest.clear();
+  REQUIRE (wq.try_pop_many(std::back_inserter(dest), count+1) == count);
+  REQUIRE (dest.size() == count);
+  REQUIRE (wq.empty());
+}
+
+template <typename Q>
+void non_threaded_bounded_test(Q& wq, const typename Q::value_type& val, int capacity) {
+
+  REQUIRE (wq.empty());
+
+  for (int i {0}; i < capacity; ++i) {
+    REQUIRE(wq.try_push(val));
+  }
+  REQUIRE (wq.size() == capacity);
+  REQUIRE_FALSE (wq.try_push(val));
+  auto tmp { val };
+  REQUIRE_FALSE (wq.try_push(std::move(tmp)));
+  REQUIRE (wq.size() == capacity);
+  REQUIRE (*(wq.try_pop()) == val);
+  // wait_and_push should immediately return if there is space
+  REQUIRE (wq.wait_and_push(val));
+  REQUIRE (wq.size() == capacity);
+  for (int i {0}; i < capacity; ++i) {
+    REQUIRE(*(wq.try_pop()) == val);
+  }
+  REQUIRE (wq.empty());
+}
+
+template <typename Q>
+void non_threaded_drain_test(Q& wq, const typename Q::value_type& val, int count) {
+
+  using val_type = typename Q::value_type;
+
+  REQUIRE (wq.empty());
+  std::vector<val_type> dest;
+  REQUIRE (wq.drain(std::back_inserter(dest)) == 0);
+
+  for (int i {0}; i < count; ++i) {
+    REQUIRE(wq.push(val));
+  }
+  REQUIRE (wq.drain(std::back_inserter(dest)) == count);
+  REQUIRE (wq.empty());
+  REQUIRE (dest.size() == count);
+
+  for (int i {0}; i < count; ++i) {
+    REQUIRE(wq.push(val));
+  }
+  dest.clear();
+  // wait_and_drain should immediately return if the queue is non empty
+  REQUIRE (wq.wait_and_drain(std::back_inserter(dest)) == count);
+  REQUIRE (wq.empty());
+  REQUIRE (dest == std::vector<val_type>(count, val));
+}
+
+template <typename Q>
+void non_threaded_test (Q& wq, int capacity = N) {
   using val_type = typename Q::value_type;
   val_type val1;
   val_type val2;
@@ -107,6 +192,11 @@ void non_threaded_test (Q& wq) {
   }
 
   non_threaded_push_test(wq, val1, N);
+  non_threaded_bulk_test(wq, val2, N);
+  non_threaded_drain_test(wq, val1, N);
+  if constexpr (chops::supports_full<typename Q::container_type>) {
+    non_threaded_bounded_test(wq, val1, capacity);
+  }
   if constexpr (std::is_arithmetic_v<val_type>) {
     non_threaded_arithmetic_test(wq, N);
   }
@@ -189,6 +279,72 @@ bool threaded_test(Q& wq, int num_readers, int num_writers, int slice, const T&
   return (s.size() == tot);
 }
 
+template <typename T, typename Q>
+void read_many_func (std::stop_token stop_tok, Q& wq, test_set<T>& s, std::mutex& mut) {
+  std::vector<set_elem<T> > vec;
+  while (true) {
+    vec.clear();
+    if (wq.wait_and_pop_many(std::back_inserter(vec), 32) == 0) { // request stop has been called
+      return;
+    }
+    std::lock_guard<std::mutex> lk(mut);
+    s.insert(vec.cbegin(), vec.cend());
+  }
+}
+
+template <typename T, typename Q>
+void write_range_func (std::stop_token stop_tok, Q& wq, int start, int slice, const T& val) {
+  constexpr int batch = 64;
+  std::vector<set_elem<T> > vec;
+  for (int i {0}; i < slice; i += batch) {
+    vec.clear();
+    for (int j {i}; j < slice && j < (i+batch); ++j) {
+      vec.push_back(set_elem<T>{(start+j), val});
+    }
+    wq.push_range(std::move(vec));
+  }
+}
+
+template <typename T, typename Q>
+bool threaded_bulk_test(Q& wq, int num_readers, int num_writers, int slice, const T& val) {
+  int tot = num_writers * slice;
+
+  test_set<T> s;
+  std::mutex mut;
+
+  std::vector<std::jthread> rd_thrs;
+  for (int i {0}; i < num_readers; ++i) {
+    rd_thrs.push_back( std::jthread (read_many_func<T, Q>, std::ref(wq), std::ref(s), std::ref(mut)) );
+  }
+  std::vector<std::jthread> wr_thrs;
+  for (int i {0}; i < num_writers; ++i) {
+    wr_thrs.push_back( std::jthread (write_range_func<T, Q>, std::ref(wq), (i*slice), slice, val));
+  }
+  for (auto& thr : wr_thrs) {
+    thr.join();
+  }
+  bool done {false};
+  while (!done) {
+    std::this_thread::sleep_for(std::chrono::milliseconds(100));
+    std::lock_guard<std::mutex> lk(mut);
+    if (s.size() == tot) {
+      done = true;
+    }
+  }
+  wq.request_stop();
+  for (auto& thr : rd_thrs) {
+    thr.join();
+  }
+  REQUIRE (wq.empty());
+  int idx {0};
+  for (const auto& e : s) {
+    REQUIRE (e.first == idx);
+    REQUIRE (e.second == val);
+    ++idx;
+  }
+  return (s.size() == tot);
+}
+
 // non threaded test, multiple container types, multiple element types
 
 TEMPLATE_TEST_CASE ( "Non-threaded wait_queue test, deque", 
@@ -215,6 +371,82 @@ TEMPLATE_TEST_CASE ( "Non-threaded wait_queue test, circular_buffer",
   non_threaded_test(wq);
 }
 
+TEMPLATE_TEST_CASE ( "Non-threaded wait_queue test, fixed_ring", 
+                     "[wait_queue] [non_threaded] [fixed_ring]",
+                     int, double, short, std::string ) {
+  constexpr int cap = 64;
+  {
+    chops::wait_queue<TestType, chops::fixed_ring<TestType, cap>> wq;
+    non_threaded_test(wq, cap);
+  }
+  {
+    chops::wait_queue<TestType, chops::fixed_ring<TestType>> wq { N }; // rounded up to cap
+    non_threaded_test(wq, cap);
+  }
+  {
+    std::stop_source src;
+    chops::wait_queue<TestType, chops::fixed_ring<TestType>> wq { src.get_token(), N };
+    non_threaded_test(wq, cap);
+    src.request_stop();
+    REQUIRE (wq.stop_requested());
+  }
+}
+
+// the static_wait_queue container (and so the queue object) is smaller than a
+// circular_buffer of the same capacity
+static_assert(sizeof(chops::lean_fixed_ring<int, 64>) < sizeof(jm::circular_buffer<int, 64>));
+static_assert(sizeof(chops::static_wait_queue<int, 64>) <
+              sizeof(chops::wait_queue<int, jm::circular_buffer<int, 64>>));
+static_assert(sizeof(chops::static_wait_queue<int, 64>) <
+              sizeof(chops::wait_queue<int, chops::fixed_ring<int, 64>>));
+
+TEMPLATE_TEST_CASE ( "Non-threaded wait_queue test, static_wait_queue", 
+                     "[wait_queue] [non_threaded] [static_wait_queue]",
+                     int, double, short, std::string ) {
+  constexpr int cap = 64;
+  chops::static_wait_queue<TestType, cap> wq;
+  non_threaded_test(wq, cap);
+}
+
+TEMPLATE_TEST_CASE ( "Pop into a caller supplied object",
+                     "[wait_queue] [pop_ref]",
+                     (chops::wait_queue<std::string>), (chops::static_wait_queue<std::string, 16u>) ) {
+  TestType wq;
+  std::string out { "unchanged"s };
+  REQUIRE_FALSE (wq.try_pop(out));
+  REQUIRE (out == "unchanged"s);
+  REQUIRE (wq.push("a"s));
+  REQUIRE (wq.push("b"s));
+  REQUIRE (wq.try_pop(out));
+  REQUIRE (out == "a"s);
+  REQUIRE (wq.wait_and_pop(out));
+  REQUIRE (out == "b"s);
+  REQUIRE (wq.empty());
+
+  auto pop_fut = std::async (std::launch::async, [&wq] {
+      std::string val;
+      int cnt {0};
+      while (wq.wait_and_pop(val)) {
+        if (val != std::to_string(cnt++)) {
+          return -1;
+        }
+      }
+      return cnt;
+    } );
+  for (int i {0}; i < N; ++i) {
+    if constexpr (requires { wq.wait_and_push(std::to_string(i)); }) {
+      REQUIRE (wq.wait_and_push(std::to_string(i)));
+    }
+    else {
+      REQUIRE (wq.push(std::to_string(i)));
+    }
+  }
+  wq.close();
+  REQUIRE (pop_fut.get() == N);
+  REQUIRE_FALSE (wq.wait_and_pop(out));
+  REQUIRE (out == "b"s);
+}
+
 /*
 */
 
@@ -413,6 +645,83 @@ TEST_CASE ( "Fixed size ring_span, testing wrap around with int type",
   REQUIRE (wq.empty());
 }
 
+TEST_CASE ( "Bounded ring_span, testing back-pressure with int type",
+            "[wait_queue] [int] [ring_span] [bounded]" ) {
+
+  constexpr int sz = 10;
+  constexpr int tot = 5000;
+  int buf[sz];
+  chops::wait_queue<int, nonstd::ring_span<int> > wq 
+    { nonstd::ring_span<int> { buf+0, buf+sz } };
+
+  auto push_fut = std::async (std::launch::async, [&wq] {
+      for (int i {0}; i < tot; ++i) {
+        if (!wq.wait_and_push(i)) {
+          return false;
+        }
+      }
+      return true;
+    } );
+  // every pushed value must be seen in order, none overwritten
+  for (int i {0}; i < tot; ++i) {
+    auto val = wq.wait_and_pop();
+    REQUIRE (val);
+    REQUIRE (*val == i);
+  }
+  REQUIRE (push_fut.get());
+  REQUIRE (wq.empty());
+
+  SECTION ( "Blocked writer is unblocked by request_stop" ) {
+    for (int i {0}; i < sz; ++i) {
+      REQUIRE (wq.try_push(i));
+    }
+    auto blocked_fut = std::async (std::launch::async, [&wq] { return wq.wait_and_push(42); } );
+    std::this_thread::sleep_for(std::chrono::milliseconds(50));
+    wq.request_stop();
+    REQUIRE_FALSE (blocked_fut.get());
+    REQUIRE (wq.size() == sz);
+    REQUIRE_FALSE (wq.try_push(42));
+  }
+}
+
+TEST_CASE ( "Bounded fixed_ring, testing back-pressure with string type",
+            "[wait_queue] [fixed_ring] [bounded]" ) {
+
+  constexpr int sz = 16;
+  constexpr int tot = 5000;
+  chops::wait_queue<std::string, chops::fixed_ring<std::string, sz> > wq;
+
+  auto push_fut = std::async (std::launch::async, [&wq] {
+      for (int i {0}; i < tot; ++i) {
+        if (!wq.wait_and_push(std::to_string(i))) {
+          return false;
+        }
+      }
+      return true;
+    } );
+  for (int i {0}; i < tot; ++i) {
+    auto val = wq.wait_and_pop();
+    REQUIRE (val);
+    REQUIRE (*val == std::to_string(i));
+  }
+  REQUIRE (push_fut.get());
+  REQUIRE (wq.empty());
+}
+
+TEST_CASE ( "Bounded fixed_ring, wait_and_push after a stop request with space available",
+            "[wait_queue] [fixed_ring] [bounded] [stop]" ) {
+
+  chops::wait_queue<int, chops::fixed_ring<int, 8> > wq;
+  REQUIRE (wq.wait_and_push(1));
+  wq.request_stop();
+  int val {2};
+  REQUIRE_FALSE (wq.wait_and_push(val));
+  REQUIRE_FALSE (wq.wait_and_push(3));
+  REQUIRE_FALSE (wq.push(4));
+  REQUIRE_FALSE (wq.try_push(5));
+  REQUIRE (wq.size() == 1u);
+}
+
 TEST_CASE ( "Threaded wait queue, deque int",
             "[wait_queue] [threaded] [int] [deque]" ) {
 
@@ -440,3 +749,759 @@ TEST_CASE ( "Threaded wait queue, deque string",
   }
 }
 
+
+TEST_CASE ( "Threaded wait queue, bulk push and pop, deque int",
+            "[wait_queue] [threaded] [int] [deque] [bulk]" ) {
+
+  chops::wait_queue<set_elem<int> > wq;
+
+  SECTION ( "1 reader, 1 writer thread, 1000 slice" ) {
+    REQUIRE ( threaded_bulk_test(wq, 1, 1, 1000, 44) );
+  }
+  SECTION ( "8 reader, 16 writer threads, 5000 slice" ) {
+    REQUIRE ( threaded_bulk_test(wq, 8, 16, 5000, 5656) );
+  }
+}
+
+TEST_CASE ( "Timed wait_and_pop, testing timeout and stop status",
+            "[wait_queue] [int] [deque] [timed]" ) {
+
+  using namespace std::chrono_literals;
+
+  chops::wait_queue<int> wq;
+
+  auto start = std::chrono::steady_clock::now();
+  auto res1 = wq.wait_and_pop_for(20ms);
+  REQUIRE (res1.status == chops::wait_status::timeout);
+  REQUIRE_FALSE (res1.value);
+  REQUIRE ((std::chrono::steady_clock::now() - start) >= 20ms);
+
+  wq.push(42);
+  auto res2 = wq.wait_and_pop_until(std::chrono::steady_clock::now() + 10s);
+  REQUIRE (res2.status == chops::wait_status::ready);
+  REQUIRE (*res2.value == 42);
+
+  auto push_fut = std::async (std::launch::async, [&wq] {
+      std::this_thread::sleep_for(20ms);
+      return wq.push(43);
+    } );
+  auto [status, val] = wq.wait_and_pop_for(10s);
+  REQUIRE (status == chops::wait_status::ready);
+  REQUIRE (*val == 43);
+  REQUIRE (push_fut.get());
+
+  auto pop_fut = std::async (std::launch::async, [&wq] { return wq.wait_and_pop_for(10s); } );
+  std::this_thread::sleep_for(20ms);
+  wq.request_stop();
+  auto res3 = pop_fut.get();
+  REQUIRE (res3.status == chops::wait_status::stopped);
+  REQUIRE_FALSE (res3.value);
+  REQUIRE (wq.wait_and_pop_for(10s).status == chops::wait_status::stopped);
+}
+
+TEMPLATE_TEST_CASE ( "Threaded wait queue, spin and busy poll wait policies",
+                     "[wait_queue] [threaded] [int] [deque] [wait_policy]",
+                     chops::spin_then_block_wait<>, chops::spin_then_block_wait<10u>,
+                     chops::busy_poll_wait ) {
+
+  using namespace std::chrono_literals;
+
+  chops::wait_queue<set_elem<int>, std::deque<set_elem<int> >, TestType> wq;
+
+  SECTION ( "2 reader, 2 writer threads, 1000 slice" ) {
+    REQUIRE ( threaded_test(wq, 2, 2, 1000, 44) );
+  }
+  SECTION ( "Timed pop with wait policy" ) {
+    auto res = wq.wait_and_pop_for(10ms);
+    REQUIRE (res.status == chops::wait_status::timeout);
+    wq.push(set_elem<int>{1, 44});
+    res = wq.wait_and_pop_for(10ms);
+    REQUIRE (res.status == chops::wait_status::ready);
+    REQUIRE ((*res.value).first == 1);
+  }
+}
+
+// move-only and counting moves, to check that elements are consumed in place
+struct counted_payload {
+  static inline int moves {0};
+  int m_val;
+  char m_buf[256];
+  explicit counted_payload(int val) : m_val(val), m_buf{} { }
+  counted_payload(const counted_payload&) = delete;
+  counted_payload(counted_payload&& rhs) noexcept : m_val(rhs.m_val), m_buf{} { ++moves; }
+};
+
+TEST_CASE ( "Consume in place, move-only element type, deque",
+            "[wait_queue] [consume]" ) {
+
+  chops::wait_queue<counted_payload> wq;
+  int sum {0};
+  auto add = [&sum] (counted_payload& p) { sum += p.m_val; };
+
+  REQUIRE_FALSE (wq.try_consume(add));
+  for (int i {0}; i < N; ++i) {
+    REQUIRE (wq.emplace_push(i));
+  }
+  REQUIRE (wq.try_consume(add));
+  REQUIRE (wq.wait_and_consume(add));
+  REQUIRE (wq.size() == N-2);
+  REQUIRE (sum == 1);
+
+  auto pop_fut = std::async (std::launch::async, [&wq, &sum, add] {
+      while (wq.wait_and_consume(add)) {
+        ;
+      }
+      return sum;
+    } );
+  for (int i {N}; i < 2*N; ++i) {
+    REQUIRE (wq.emplace_push(i));
+  }
+  while (!wq.empty()) {
+    std::this_thread::sleep_for(std::chrono::milliseconds(5));
+  }
+  wq.request_stop();
+  REQUIRE (pop_fut.get() == (2*N * (2*N-1)) / 2);
+  REQUIRE_FALSE (wq.try_consume(add));
+  REQUIRE (counted_payload::moves == 0);
+}
+
+TEST_CASE ( "Consume span in place, fixed_ring int",
+            "[wait_queue] [consume] [fixed_ring]" ) {
+
+  constexpr int sz = 16;
+  chops::wait_queue<int, chops::fixed_ring<int, sz>> wq;
+  std::vector<int> dest;
+  auto copy_out = [&dest] (std::span<int> elems) {
+    dest.insert(dest.end(), elems.begin(), elems.end());
+  };
+
+  REQUIRE (wq.try_consume_span(copy_out, sz) == 0u);
+  for (int i {0}; i < 10; ++i) {
+    REQUIRE (wq.push(i));
+  }
+  REQUIRE (wq.try_consume_span(copy_out, 4u) == 4u);
+  REQUIRE (wq.try_consume_span(copy_out, sz) == 6u);
+  for (int i {10}; i < 26; ++i) { // wraps around the end of the ring storage
+    REQUIRE (wq.push(i));
+  }
+  REQUIRE (wq.wait_and_consume_span(copy_out, sz) == 6u); // up to end of storage
+  REQUIRE (wq.wait_and_consume_span(copy_out, sz) == 10u);
+  REQUIRE (wq.empty());
+  std::vector<int> exp;
+  for (int i {0}; i < 26; ++i) {
+    exp.push_back(i);
+  }
+  REQUIRE (dest == exp);
+
+  constexpr int tot = 5000;
+  dest.clear();
+  auto push_fut = std::async (std::launch::async, [&wq] {
+      for (int i {0}; i < tot; ++i) {
+        if (!wq.wait_and_push(i)) {
+          return false;
+        }
+      }
+      return true;
+    } );
+  while (dest.size() < tot) {
+    REQUIRE (wq.wait_and_consume_span(copy_out, sz) > 0u);
+  }
+  REQUIRE (push_fut.get());
+  for (int i {0}; i < tot; ++i) {
+    REQUIRE (dest[i] == i);
+  }
+  wq.request_stop();
+  REQUIRE (wq.wait_and_consume_span(copy_out, sz) == 0u);
+}
+
+TEST_CASE ( "Reserve and commit slots, fixed_ring string",
+            "[wait_queue] [reserve] [fixed_ring]" ) {
+
+  constexpr int sz = 8;
+  chops::wait_queue<std::string, chops::fixed_ring<std::string, sz>> wq;
+
+  auto slot1 = wq.reserve();
+  REQUIRE (slot1);
+  REQUIRE (slot1->size() == 1u);
+  auto slot2 = wq.try_reserve(3u);
+  REQUIRE (slot2);
+  REQUIRE_FALSE (wq.try_reserve(5u)); // only 4 slots available
+  slot2->emplace("b"s);
+  slot2->emplace("c"s);
+  slot2->emplace(2u, 'd');
+  REQUIRE (wq.commit(*slot2));
+  REQUIRE (wq.empty()); // slot1 not yet committed
+  REQUIRE_FALSE (wq.try_pop());
+  slot1->emplace("a"s) += "!"s;
+  REQUIRE (wq.commit(*slot1));
+  REQUIRE (wq.size() == 4u);
+  REQUIRE (*(wq.try_pop()) == "a!"s);
+  REQUIRE (*(wq.try_pop()) == "b"s);
+  REQUIRE (*(wq.try_pop()) == "c"s);
+  REQUIRE (*(wq.wait_and_pop()) == "dd"s);
+  REQUIRE (wq.empty());
+
+  wq.request_stop();
+  REQUIRE_FALSE (wq.reserve());
+  REQUIRE_FALSE (wq.try_reserve());
+}
+
+TEST_CASE ( "Reserve and commit slots, overwriting push never touches reserved slots",
+            "[wait_queue] [reserve] [fixed_ring]" ) {
+
+  chops::wait_queue<std::string, chops::fixed_ring<std::string, 4>> wq;
+
+  // every slot reserved, nothing visible to overwrite
+  auto all = wq.reserve(4u);
+  REQUIRE (all);
+  REQUIRE_FALSE (wq.push("x"s));
+  REQUIRE_FALSE (wq.emplace_push(2u, 'y'));
+  REQUIRE_FALSE (wq.push_range(std::vector<std::string> { "z"s }));
+  for (std::size_t i {0u}; i < 4u; ++i) {
+    all->emplace(std::to_string(i));
+  }
+  REQUIRE (wq.commit(*all));
+  REQUIRE (wq.size() == 4u);
+  REQUIRE (wq.push("4"s)); // overwrites the oldest visible element
+  REQUIRE (*(wq.try_pop()) == "1"s);
+  while (wq.try_pop()) { }
+
+  // visible elements are overwritten, but not the reserved slot or the later push
+  REQUIRE (wq.push("a"s));
+  REQUIRE (wq.push("b"s));
+  auto one = wq.reserve();
+  REQUIRE (one);
+  REQUIRE (wq.push("c"s)); // free slot, pending until the reservation is committed
+  REQUIRE (wq.push("d"s)); // overwrites "a"
+  REQUIRE (wq.size() == 1u);
+  REQUIRE_FALSE (wq.push_range(std::vector<std::string> { "e"s, "f"s })); // room for one
+  REQUIRE (wq.push_range(std::vector<std::string> { "e"s })); // overwrites "b"
+  REQUIRE (wq.empty());
+  REQUIRE_FALSE (wq.push("g"s));
+  one->emplace("r"s);
+  REQUIRE (wq.commit(*one));
+  std::vector<std::string> vals;
+  while (auto val = wq.try_pop()) {
+    vals.push_back(*val);
+  }
+  REQUIRE (vals == std::vector<std::string> { "r"s, "c"s, "d"s, "e"s });
+}
+
+TEST_CASE ( "Reserve and commit slots, threaded multiple writers",
+            "[wait_queue] [reserve] [fixed_ring] [threaded]" ) {
+
+  constexpr int sz = 64;
+  constexpr int num_writers = 4;
+  constexpr int batch = 8;
+  constexpr int slice = 1000 * batch;
+  chops::wait_queue<set_elem<int>, chops::fixed_ring<set_elem<int>>> wq { sz };
+
+  {
+    std::vector<std::jthread> wr_thrs;
+    for (int w {0}; w < num_writers; ++w) {
+      wr_thrs.emplace_back( [&wq, w] {
+          for (int i {0}; i < slice; i += batch) {
+            auto n = (i / batch) % 2 ? 1u : static_cast<std::size_t>(batch);
+            for (int j {0}; j < batch; j += n) {
+              auto slots = wq.reserve(n);
+              for (std::size_t k {0u}; k < n; ++k) {
+                slots->emplace((w * slice) + i + j + static_cast<int>(k), w);
+              }
+              wq.commit(*slots);
+            }
+          }
+        } );
+    }
+    test_set<int> s;
+    while (s.size() < num_writers * slice) {
+      auto val = wq.wait_and_pop();
+      REQUIRE (val);
+      s.insert(*val);
+    }
+    int idx {0};
+    for (const auto& e : s) {
+      REQUIRE (e.first == idx);
+      REQUIRE (e.second == idx / slice);
+      ++idx;
+    }
+  }
+  REQUIRE (wq.empty());
+}
+
+TEST_CASE ( "Producer handle, batched pushes with flush on size, time and destruction",
+            "[wait_queue] [producer_handle]" ) {
+
+  chops::wait_queue<int> wq;
+  {
+    chops::wait_queue<int>::producer_handle prod { wq, 4u };
+    for (int i {0}; i < 3; ++i) {
+      REQUIRE (prod.push(i));
+    }
+    REQUIRE (prod.buffered() == 3u);
+    REQUIRE (wq.empty());
+    REQUIRE (prod.emplace_push(3)); // batch full
+    REQUIRE (prod.buffered() == 0u);
+    REQUIRE (wq.size() == 4u);
+    REQUIRE (prod.push(4));
+    REQUIRE (prod.flush());
+    REQUIRE (wq.size() == 5u);
+    REQUIRE (prod.push(5));
+    auto moved { std::move(prod) };
+    REQUIRE (moved.buffered() == 1u);
+  } // moved flushed on destruction
+  REQUIRE (wq.size() == 6u);
+  for (int i {0}; i < 6; ++i) {
+    REQUIRE (*(wq.try_pop()) == i);
+  }
+
+  {
+    chops::wait_queue<int>::producer_handle prod { wq, 1000u, std::chrono::milliseconds(20) };
+    REQUIRE (prod.push(1));
+    REQUIRE (prod.push(2));
+    REQUIRE (wq.empty());
+    std::this_thread::sleep_for(std::chrono::milliseconds(30));
+    REQUIRE (prod.push(3)); // time bound reached
+    REQUIRE (wq.size() == 3u);
+    REQUIRE (prod.push(4));
+    REQUIRE (prod.flush_if_due()); // not yet due
+    REQUIRE (prod.buffered() == 1u);
+    std::this_thread::sleep_for(std::chrono::milliseconds(30));
+    REQUIRE (prod.flush_if_due()); // idle producer, flushed on the time bound
+    REQUIRE (prod.buffered() == 0u);
+    REQUIRE (wq.size() == 4u);
+    REQUIRE (prod.flush_if_due()); // nothing buffered
+    REQUIRE (prod.push(4));
+    wq.request_stop();
+    REQUIRE_FALSE (prod.push(5));
+    REQUIRE (prod.buffered() == 0u);
+    REQUIRE_FALSE (prod.flush());
+  }
+
+  // a close discards the buffer, a rejected overwrite keeps it for a retry
+  chops::wait_queue<int, chops::fixed_ring<int, 4>> rq;
+  {
+    chops::wait_queue<int, chops::fixed_ring<int, 4>>::producer_handle prod { rq, 8u };
+    auto slots = rq.reserve(2u);
+    REQUIRE (slots);
+    REQUIRE (prod.push(1));
+    REQUIRE (prod.push(2));
+    REQUIRE (prod.push(3));
+    REQUIRE_FALSE (prod.flush()); // would overwrite reserved slots
+    REQUIRE (prod.buffered() == 3u);
+    slots->emplace(10);
+    slots->emplace(11);
+    REQUIRE (rq.commit(*slots));
+    REQUIRE (*(rq.try_pop()) == 10);
+    REQUIRE (*(rq.try_pop()) == 11);
+    REQUIRE (prod.flush()); // retried
+    REQUIRE (rq.size() == 3u);
+    REQUIRE (prod.push(4));
+    REQUIRE (rq.close());
+    REQUIRE_FALSE (prod.flush());
+    REQUIRE (prod.buffered() == 0u);
+    REQUIRE_FALSE (prod.push(5));
+  }
+  REQUIRE (rq.size() == 3u);
+}
+
+TEST_CASE ( "Producer handle, threaded with multiple producers",
+            "[wait_queue] [producer_handle] [threaded]" ) {
+
+  chops::wait_queue<set_elem<std::string>> wq;
+  constexpr int num_writers = 4;
+  constexpr int slice = 5000;
+  const std::string val { "Howzit going, bro!" };
+
+  test_set<std::string> s;
+  auto rd_fut = std::async (std::launch::async, [&wq, &s] {
+      while (s.size() < num_writers * slice) {
+        auto elem = wq.wait_and_pop();
+        if (!elem) {
+          return false;
+        }
+        s.insert(*elem);
+      }
+      return true;
+    } );
+  {
+    std::vector<std::jthread> wr_thrs;
+    for (int w {0}; w < num_writers; ++w) {
+      wr_thrs.emplace_back( [&wq, &val, w] {
+          chops::wait_queue<set_elem<std::string>>::producer_handle prod { wq, 
+                32u, std::chrono::microseconds(200) };
+          for (int i {0}; i < slice; ++i) {
+            prod.push(set_elem<std::string>{(w * slice) + i, val});
+          }
+        } );
+    }
+  }
+  REQUIRE (rd_fut.get());
+  int idx {0};
+  for (const auto& e : s) {
+    REQUIRE (e.first == idx);
+    REQUIRE (e.second == val);
+    ++idx;
+  }
+  REQUIRE (wq.empty());
+}
+
+TEST_CASE ( "Drain by swapping the container, deque int",
+            "[wait_queue] [int] [deque] [drain]" ) {
+
+  chops::wait_queue<int> wq;
+  REQUIRE (wq.drain().empty());
+  for (int i {0}; i < N; ++i) {
+    wq.push(i);
+  }
+  auto ctr = wq.drain();
+  REQUIRE (ctr.size() == N);
+  REQUIRE (ctr.front() == 0);
+  REQUIRE (ctr.back() == (N-1));
+  REQUIRE (wq.empty());
+
+  std::deque<int> supplied;
+  wq.push(42);
+  wq.push(43);
+  REQUIRE (wq.drain(supplied) == 2);
+  REQUIRE (supplied == std::deque<int>{42, 43});
+  REQUIRE (wq.empty());
+
+  auto drain_fut = std::async (std::launch::async, [&wq] { return wq.wait_and_drain(); } );
+  std::this_thread::sleep_for(std::chrono::milliseconds(20));
+  wq.push(44);
+  auto res = drain_fut.get();
+  REQUIRE (res.size() == 1);
+  REQUIRE (res.front() == 44);
+
+  auto stop_fut = std::async (std::launch::async, [&wq] { return wq.wait_and_drain(); } );
+  std::this_thread::sleep_for(std::chrono::milliseconds(20));
+  wq.request_stop();
+  REQUIRE (stop_fut.get().empty());
+  std::deque<int> supplied2;
+  REQUIRE (wq.wait_and_drain(supplied2) == 0);
+}
+
+TEST_CASE ( "Selective pop with predicate, deque",
+            "[wait_queue] [deque] [pop_if]" ) {
+
+  using reply = std::pair<int, std::string>;
+  chops::wait_queue<reply> wq;
+  auto id_is = [] (int id) { return [id] (const reply& r) { return r.first == id; }; };
+
+  REQUIRE_FALSE (wq.try_pop_if(id_is(1)));
+  wq.push(reply{1, "a"s});
+  wq.push(reply{2, "b"s});
+  wq.push(reply{3, "c"s});
+  wq.push(reply{2, "d"s});
+  auto val = wq.try_pop_if(id_is(2));
+  REQUIRE (val);
+  REQUIRE (val->second == "b"s); // first match
+  REQUIRE_FALSE (wq.try_pop_if(id_is(4)));
+  REQUIRE (wq.size() == 3u);
+  REQUIRE (wq.approx_size() == 3u);
+  REQUIRE (wq.wait_and_pop_if(id_is(2))->second == "d"s);
+  REQUIRE (wq.try_pop()->first == 1); // remaining order unchanged
+  REQUIRE (wq.try_pop()->first == 3);
+
+  // a correlator waiting for a reply is woken by non-matching pushes, while a plain
+  // reader consumes everything else
+  auto corr_fut = std::async (std::launch::async, [&wq, &id_is] { return wq.wait_and_pop_if(id_is(42)); } );
+  std::this_thread::sleep_for(std::chrono::milliseconds(20));
+  for (int i {0}; i < N; ++i) {
+    REQUIRE (wq.push(reply{1000 + i, "other"s}));
+  }
+  REQUIRE (wq.push(reply{42, "match"s}));
+  auto match = corr_fut.get();
+  REQUIRE (match);
+  REQUIRE (match->second == "match"s);
+  REQUIRE (wq.size() == static_cast<std::size_t>(N));
+  auto rd_fut = std::async (std::launch::async, [&wq] {
+      int cnt {0};
+      while (auto r = wq.wait_and_pop()) {
+        ++cnt;
+      }
+      return cnt;
+    } );
+  while (!wq.empty()) {
+    std::this_thread::sleep_for(std::chrono::milliseconds(5));
+  }
+  auto stop_fut = std::async (std::launch::async, [&wq, &id_is] { return wq.wait_and_pop_if(id_is(43)); } );
+  std::this_thread::sleep_for(std::chrono::milliseconds(20));
+  wq.request_stop();
+  REQUIRE_FALSE (stop_fut.get());
+  REQUIRE (rd_fut.get() == N);
+}
+
+TEST_CASE ( "Close, readers drain remaining values before end of stream",
+            "[wait_queue] [close]" ) {
+
+  chops::wait_queue<int> wq;
+  for (int i {0}; i < 3; ++i) {
+    REQUIRE (wq.push(i));
+  }
+  REQUIRE_FALSE (wq.closed());
+  REQUIRE (wq.close());
+  REQUIRE_FALSE (wq.close());
+  REQUIRE (wq.closed());
+  REQUIRE_FALSE (wq.stop_requested());
+  REQUIRE_FALSE (wq.push(3));
+  REQUIRE_FALSE (wq.emplace_push(4));
+  REQUIRE (*(wq.wait_and_pop()) == 0);
+  REQUIRE (*(wq.try_pop()) == 1);
+  REQUIRE (*(wq.wait_and_pop()) == 2);
+  REQUIRE_FALSE (wq.wait_and_pop()); // end of stream, does not block
+  REQUIRE_FALSE (wq.wait_and_pop_if([] (const int&) { return true; }));
+  REQUIRE (wq.wait_and_drain().empty());
+  auto res = wq.wait_and_pop_for(std::chrono::seconds(10));
+  REQUIRE (res.status == chops::wait_status::closed);
+
+  // bounded writer blocked waiting for space is released by a close
+  chops::wait_queue<int, chops::fixed_ring<int, 4u>> rq;
+  for (int i {0}; i < 4; ++i) {
+    REQUIRE (rq.try_push(i));
+  }
+  auto push_fut = std::async (std::launch::async, [&rq] { return rq.wait_and_push(4); } );
+  std::this_thread::sleep_for(std::chrono::milliseconds(20));
+  rq.close();
+  REQUIRE_FALSE (push_fut.get());
+  REQUIRE_FALSE (rq.try_reserve());
+  REQUIRE (rq.size() == 4u);
+}
+
+TEST_CASE ( "Close, threaded pipeline shutdown without losing values",
+            "[wait_queue] [close] [threaded]" ) {
+
+  constexpr int tot = 10000;
+  constexpr int num_readers = 4;
+  chops::wait_queue<int> wq;
+
+  std::vector<std::future<long long>> rd_futs;
+  for (int i {0}; i < num_readers; ++i) {
+    rd_futs.push_back(std::async(std::launch::async, [&wq] {
+        long long sum {0};
+        while (auto val = wq.wait_and_pop()) {
+          sum += *val;
+        }
+        return sum;
+      } ) );
+  }
+  for (int i {0}; i < tot; ++i) {
+    REQUIRE (wq.push(i));
+  }
+  wq.close(); // readers are still working through the backlog
+  long long sum {0};
+  for (auto& fut : rd_futs) {
+    sum += fut.get();
+  }
+  REQUIRE (sum == static_cast<long long>(tot) * (tot - 1) / 2);
+  REQUIRE (wq.empty());
+}
+
+TEST_CASE ( "Lock-free approx_size and approx_empty",
+            "[wait_queue] [int] [approx_size]" ) {
+
+  chops::wait_queue<int> wq { std::deque<int> { 1, 2, 3 } };
+  REQUIRE (wq.approx_size() == 3u);
+  REQUIRE (*(wq.try_pop()) == 1);
+  REQUIRE (wq.approx_size() == 2u);
+  std::vector<int> vec { 4, 5, 6, 7 };
+  REQUIRE (wq.push_range(vec.begin(), vec.end()));
+  REQUIRE (wq.approx_size() == 6u);
+  REQUIRE (wq.approx_size() == wq.size());
+  REQUIRE (wq.try_consume([] (int&) { }));
+  REQUIRE (wq.approx_size() == 5u);
+  [[maybe_unused]] auto ctr = wq.drain();
+  REQUIRE (wq.approx_empty());
+
+  chops::wait_queue<int, chops::fixed_ring<int, 8u>> rq;
+  REQUIRE (rq.approx_empty());
+  auto slots = rq.reserve(2u);
+  REQUIRE (slots);
+  slots->emplace(1);
+  slots->emplace(2);
+  REQUIRE (rq.approx_empty()); // not visible until committed
+  REQUIRE (rq.commit(*slots));
+  REQUIRE (rq.approx_size() == 2u);
+  REQUIRE (rq.try_consume_span([] (std::span<int>) { }, 8u) == 2u);
+  REQUIRE (rq.approx_empty());
+
+  // reader spins on the count and then pops once a writer pushes
+  chops::wait_queue<int, std::deque<int>, chops::busy_poll_wait> pq;
+  auto fut = std::async (std::launch::async, [&pq] { return pq.wait_and_pop(); } );
+  std::this_thread::sleep_for(std::chrono::milliseconds(20));
+  REQUIRE (pq.push(42));
+  REQUIRE (*(fut.get()) == 42);
+  REQUIRE (pq.approx_empty());
+}
+
+TEST_CASE ( "Instrumentation counters with atomic_stats policy",
+            "[wait_queue] [int] [deque] [stats]" ) {
+
+  chops::wait_queue<int, std::deque<int>, chops::block_wait, chops::atomic_stats> wq;
+  auto st = wq.stats();
+  REQUIRE (st.pushes == 0u);
+  REQUIRE (st.high_water == 0u);
+
+  for (int i {0}; i < N; ++i) {
+    wq.push(i);
+  }
+  REQUIRE (wq.try_pop());
+  REQUIRE (wq.try_pop());
+  wq.push(N);
+  st = wq.stats();
+  REQUIRE (st.pushes == static_cast<std::uint64_t>(N+1));
+  REQUIRE (st.pops == 2u);
+  REQUIRE (st.high_water == static_cast<std::uint64_t>(N));
+  REQUIRE (st.total_wait_ns == 0u);
+
+  std::vector<int> dest;
+  REQUIRE (wq.drain(std::back_inserter(dest)) == static_cast<std::size_t>(N-1));
+  REQUIRE (wq.stats().pops == static_cast<std::uint64_t>(N+1));
+
+  auto pop_fut = std::async (std::launch::async, [&wq] { return wq.wait_and_pop(); } );
+  std::this_thread::sleep_for(std::chrono::milliseconds(20));
+  wq.push(42);
+  REQUIRE (*(pop_fut.get()) == 42);
+  st = wq.stats();
+  REQUIRE (st.total_wait_ns > 0u);
+  REQUIRE (st.max_wait_ns > 0u);
+  REQUIRE (st.max_wait_ns <= st.total_wait_ns);
+
+  wq.request_stop();
+  REQUIRE_FALSE (wq.push(43));
+  REQUIRE_FALSE (wq.emplace_push(44));
+  REQUIRE (wq.stats().rejected_pushes == 2u);
+
+  // a full container is back-pressure, only a stopped or closed queue is a reject
+  chops::wait_queue<int, chops::fixed_ring<int, 2>, chops::block_wait, chops::atomic_stats> rq;
+  REQUIRE (rq.try_push(1));
+  REQUIRE (rq.try_push(2));
+  REQUIRE_FALSE (rq.try_push(3));
+  REQUIRE_FALSE (rq.try_reserve());
+  REQUIRE (rq.stats().rejected_pushes == 0u);
+  REQUIRE (rq.close());
+  REQUIRE_FALSE (rq.push(4));
+  REQUIRE_FALSE (rq.try_reserve());
+  REQUIRE (rq.stats().rejected_pushes == 2u);
+
+  chops::wait_queue<int> null_wq;
+  null_wq.push(42);
+  REQUIRE (null_wq.stats().pushes == 0u);
+}
+
+// minimal fire and forget coroutine type, the frame is destroyed on completion
+struct detached_task {
+  struct promise_type {
+    auto get_return_object() noexcept -> detached_task { return { }; }
+    auto initial_suspend() noexcept -> std::suspend_never { return { }; }
+    auto final_suspend() noexcept -> std::suspend_never { return { }; }
+    void return_void() noexcept { }
+    void unhandled_exception() noexcept { std::terminate(); }
+  };
+};
+
+template <typename Q>
+detached_task pop_coro(Q& wq, int& sum, int& cnt, bool& done) {
+  while (auto val = co_await wq.async_pop()) {
+    sum += *val;
+    ++cnt;
+  }
+  done = true;
+}
+
+template <typename Q, typename E>
+detached_task pop_coro_exec(Q& wq, E& exec, std::optional<int>& res) {
+  res = co_await wq.async_pop(exec);
+}
+
+template <typename Q>
+detached_task push_coro(Q& wq, int count, int& pushed, bool& done) {
+  for (int i {0}; i < count; ++i) {
+    if (!co_await wq.async_push(i)) {
+      break;
+    }
+    ++pushed;
+  }
+  done = true;
+}
+
+TEST_CASE ( "Coroutine async_pop, deque int",
+            "[wait_queue] [int] [deque] [coroutine]" ) {
+
+  chops::wait_queue<int> wq;
+  int sum {0};
+  int cnt {0};
+  bool done {false};
+
+  wq.push(10); // available before co_await, no suspension
+  pop_coro(wq, sum, cnt, done); // suspended in async_pop, no thread blocked
+  REQUIRE (cnt == 1);
+  REQUIRE_FALSE (done);
+  for (int i {0}; i < N; ++i) {
+    REQUIRE (wq.push(i)); // resumed inline in this thread
+  }
+  REQUIRE (cnt == N+1);
+  REQUIRE (sum == 10 + (N * (N-1)) / 2);
+  REQUIRE (wq.empty());
+  REQUIRE (wq.request_stop());
+  REQUIRE (done); // resumed with an empty value
+  
+  std::optional<int> res { 42 };
+  std::vector<std::coroutine_handle<> > posted;
+  auto exec = [&posted] (std::coroutine_handle<> h) { posted.push_back(h); };
+  pop_coro_exec(wq, exec, res); // after stop, not suspended
+  REQUIRE_FALSE (res);
+  REQUIRE (posted.empty());
+}
+
+TEST_CASE ( "Coroutine async_pop with executor, threaded resume",
+            "[wait_queue] [int] [deque] [coroutine] [threaded]" ) {
+
+  chops::wait_queue<int> wq;
+  std::optional<int> res;
+  std::vector<std::coroutine_handle<> > posted;
+  auto exec = [&posted] (std::coroutine_handle<> h) { posted.push_back(h); };
+
+  pop_coro_exec(wq, exec, res);
+  auto push_fut = std::async (std::launch::async, [&wq] { return wq.push(55); } );
+  REQUIRE (push_fut.get());
+  REQUIRE_FALSE (res); // posted to the executor, not yet resumed
+  REQUIRE (posted.size() == 1u);
+  posted.front().resume();
+  REQUIRE (*res == 55);
+
+  std::stop_source src;
+  chops::wait_queue<int> ext_wq { src.get_token() };
+  res = 66;
+  posted.clear();
+  pop_coro_exec(ext_wq, exec, res);
+  src.request_stop();
+  REQUIRE (posted.size() == 1u);
+  posted.front().resume();
+  REQUIRE_FALSE (res);
+}
+
+TEST_CASE ( "Coroutine async_push, bounded ring_span int",
+            "[wait_queue] [int] [ring_span] [coroutine] [bounded]" ) {
+
+  constexpr int cap { 8 };
+  int buf[cap];
+  chops::wait_queue<int, nonstd::ring_span<int> > wq 
+    { nonstd::ring_span<int> { buf+0, buf+cap } };
+  int pushed {0};
+  bool done {false};
+
+  push_coro(wq, N, pushed, done); // suspended when the ring_span is full
+  REQUIRE (pushed == cap);
+  REQUIRE (wq.size() == cap);
+  REQUIRE_FALSE (done);
+
+  for (int i {0}; i < cap*2; ++i) {
+    REQUIRE (*(wq.try_pop()) == i); // each pop resumes the writer coroutine
+  }
+  REQUIRE (pushed == cap*3);
+  REQUIRE (wq.size() == cap);
+  REQUIRE (wq.request_stop());
+  REQUIRE (done);
+  REQUIRE (pushed == cap*3);
+}
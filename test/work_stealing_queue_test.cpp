@@ -0,0 +1,109 @@
+/** @file
+ *
+ * @brief Test scenarios for @c work_stealing_queue class template.
+ *
+ * @author Cliff Green
+ *
+ * @copyright (c) 2024 by Cliff Green
+ *
+ * Distributed under the Boost Software License, Version 1.0.
+ * (See accompanying file LICENSE.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+ *
+ */
+
+#include <cstddef> // std::size_t
+#include <functional> // std::function
+#include <optional>
+#include <chrono>
+#include <vector>
+#include <atomic>
+
+#include <thread>
+#include <future> // std::async
+#include <stop_token>
+
+#include "catch2/catch_test_macros.hpp"
+
+#include "queue/work_stealing_queue.hpp"
+
+TEST_CASE ( "Non-threaded work_stealing_queue test, LIFO owner and FIFO thief",
+            "[work_stealing_queue] [non_threaded]" ) {
+
+  chops::work_stealing_queue<int> wsq { 2u };
+  REQUIRE (wsq.empty());
+  REQUIRE (wsq.worker_count() == 2u);
+
+  REQUIRE (wsq.push(0u, 1));
+  REQUIRE (wsq.push(0u, 2));
+  REQUIRE (wsq.push(0u, 3));
+  REQUIRE (wsq.submit(10));
+  REQUIRE (wsq.size() == 4u);
+
+  REQUIRE (*(wsq.try_pop(0u)) == 3); // owner, newest first
+  REQUIRE (*(wsq.try_pop(1u)) == 10); // injection queue before stealing
+  REQUIRE (*(wsq.try_pop(1u)) == 1); // thief, oldest first
+  REQUIRE (*(wsq.wait_and_pop(0u)) == 2);
+  REQUIRE (wsq.empty());
+  REQUIRE_FALSE (wsq.try_pop(0u));
+  REQUIRE_FALSE (wsq.try_pop(1u));
+
+  REQUIRE (wsq.push(1u, 4));
+  REQUIRE (wsq.request_stop());
+  REQUIRE (wsq.stop_requested());
+  REQUIRE_FALSE (wsq.push(1u, 5));
+  REQUIRE_FALSE (wsq.submit(5));
+  REQUIRE_FALSE (wsq.wait_and_pop(0u));
+}
+
+TEST_CASE ( "Threaded work_stealing_queue test, thread pool with spawned tasks",
+            "[work_stealing_queue] [threaded]" ) {
+
+  using task = std::function<void (std::size_t)>;
+
+  constexpr std::size_t num_workers { 4u };
+  constexpr int num_submits { 2000 };
+  constexpr int children { 3 };
+
+  chops::work_stealing_queue<task> wsq { num_workers };
+  std::atomic<int> cnt {0};
+
+  {
+    std::vector<std::jthread> workers;
+    for (std::size_t i {0u}; i < num_workers; ++i) {
+      workers.emplace_back( [&wsq, i] {
+          while (auto tsk = wsq.wait_and_pop(i)) {
+            (*tsk)(i);
+          }
+        } );
+    }
+    for (int i {0}; i < num_submits; ++i) {
+      wsq.submit( [&wsq, &cnt] (std::size_t idx) {
+          cnt.fetch_add(1);
+          for (int j {0}; j < children; ++j) {
+            wsq.push(idx, [&cnt] (std::size_t) { cnt.fetch_add(1); } );
+          }
+        } );
+    }
+    while (cnt.load() != num_submits * (children + 1)) {
+      std::this_thread::sleep_for(std::chrono::milliseconds(5));
+    }
+    REQUIRE (wsq.empty());
+    REQUIRE (wsq.request_stop()); // unblocks idle workers
+  } // workers joined
+  REQUIRE (cnt.load() == num_submits * (children + 1));
+}
+
+TEST_CASE ( "Threaded work_stealing_queue test, external stop_token",
+            "[work_stealing_queue] [threaded] [stop_token]" ) {
+
+  std::stop_source src;
+  chops::work_stealing_queue<int> wsq { src.get_token(), 3u };
+  REQUIRE_FALSE (wsq.request_stop()); // no effect, external stop token
+
+  auto pop_fut = std::async (std::launch::async, [&wsq] { return wsq.wait_and_pop(2u); } );
+  std::this_thread::sleep_for(std::chrono::milliseconds(50));
+  src.request_stop();
+  REQUIRE_FALSE (pop_fut.get());
+  REQUIRE (wsq.stop_requested());
+}
+